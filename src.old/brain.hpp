@@ -15,9 +15,12 @@
 #include <boost/foreach.hpp>
 
 #include <iostream>
+#include <thread>
+#include <vector>
 #include <fuse.h>
 
 #include "fuse.hpp"
+#include "fuselowlevel.hpp"
 #include "httpd.hpp"
 #include "libc/ilibc.hpp"
 
@@ -40,6 +43,9 @@ namespace Springy{
             static void signalHandler(boost::asio::signal_set& this_, boost::system::error_code error, int signal_number);
             void printHelp(std::ostream & output);
 
+            // shared executor of the asynchronous volumes (Volume::AsyncVolume)
+            boost::asio::io_service& executor(){ return this->io_service; }
+
         protected:
             boost::asio::io_service io_service;
             boost::asio::io_service::work preventIOServiceFromExitWorker;
@@ -55,9 +61,24 @@ namespace Springy{
             Springy::Settings *config;
 
             Fuse fuse;
+            FuseLowlevel fuseLowlevel;
+            bool lowlevel;  // --lowlevel, serve the inode based api instead of fuse
             Httpd httpd;
 
             bool showusage;
+
+            // SIGUSR1 writes the lock contention report here
+            std::string lockProfileFile;
+
+            void writeLockProfile();
+
+            // --flight-recorder, opened in run()
+            std::string flightRecorderFile;
+            size_t flightRecorderSize;
+
+            // --volume-threads, run the executor besides the main thread
+            unsigned executorThreadCount;
+            std::vector<std::thread> executorThreads;
             
 
             Brain();
@@ -10,6 +10,12 @@ namespace Springy{
     {
         this->libc = new Springy::LibC::LibC();
         this->config = new Springy::Settings(this->libc);
+
+        this->signals.add(SIGUSR1);
+
+        this->flightRecorderSize = 64*1024*1024;
+        this->executorThreadCount = 0;
+        this->lowlevel = false;
     }
 
     void Brain::printHelp(std::ostream & output){
@@ -20,11 +26,9 @@ namespace Springy{
         output << "FUSE options:" << std::endl
                << "-o allow_other         allow access to other users" << std::endl
                << "-o allow_root          allow access to root" << std::endl
-               << "-o nonempty            allow mounts over non-empty file/dir" << std::endl
                << "-o default_permissions enable permission checking by kernel" << std::endl
                << "-o fsname=NAME         set filesystem name" << std::endl
                << "-o subtype=NAME        set filesystem type" << std::endl
-               << "-o large_read          issue large read requests (2.4 only)" << std::endl
                << "-o max_read=N          set maximum size of read requests" << std::endl
 
                << "-o hard_remove         immediate removal (don't hide files)" << std::endl
@@ -48,8 +52,14 @@ namespace Springy{
                << "-o max_readahead=N     set maximum readahead" << std::endl
                << "-o async_read          perform reads asynchronously (default)" << std::endl
                << "-o sync_read           perform reads synchronously" << std::endl
-               << "-o atomic_o_trunc      enable atomic open+truncate support" << std::endl
-               << "-o big_writes          enable larger than 4kB writes" << std::endl
+               << "-o max_background=N    set number of maximum background requests" << std::endl
+               << "-o congestion_threshold=N  set kernel's congestion threshold" << std::endl
+               << "-o writeback_cache     let the kernel cache and merge writes" << std::endl
+               << "-o [no_]splice_read    use splice to read from the fuse device" << std::endl
+               << "-o [no_]splice_write   use splice to write to the fuse device" << std::endl
+               << "-o [no_]splice_move    move data while splicing to the fuse device" << std::endl
+               << "-o [no_]async_dio      asynchronous direct I/O" << std::endl
+               << "-o readdirplus=S       yes, no or auto (auto)" << std::endl
                << "-o no_remote_lock      disable remote file locking" << std::endl;
     }
 }
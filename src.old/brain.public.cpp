@@ -3,9 +3,13 @@
 #include "util/string.hpp"
 #include "util/file.hpp"
 #include "exception.hpp"
+#include "flightrecorder.hpp"
 
 #include <execinfo.h>
 
+#include <fstream>
+#include <sstream>
+
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/expressions.hpp>
@@ -38,8 +42,22 @@ namespace Springy{
             ("option,o", po::value<std::vector<std::string> >()->composing(), "additional options like id, logfile, loglevel, fuse options")
             ("debug,d", "additional debugging output")
             ("foreground,f", "run in foreground")
+            ("cache-size", po::value<size_t>(), "memory budget in MiB for caching reads from remote volumes (default 64, 0 disables)")
+            ("lock-profile", po::value<std::string>(), "record lock contention per call site from the start, SIGUSR1 writes a report to the given file (see also /api/locks)")
+            ("flight-recorder", po::value<std::string>(), "write every traced call into the given memory mapped file, it survives crashes (%p is replaced by the pid, decode with tools/flightdump)")
+            ("flight-recorder-size", po::value<size_t>(), "size of the flight recorder file in MiB (default 64)")
+            ("volume-threads", po::value<unsigned>(), "threads running asynchronous volume operations besides the main thread (default 0)")
+            ("io-uring", "serve the volume directories through io_uring instead of one syscall per operation (plain syscalls where the kernel has no io_uring)")
     #ifdef HAS_FUSE
             ("single,s", "run fuse single threaded")
+            ("max-threads", po::value<unsigned>(), "maximum number of fuse worker threads (libfuse's default if not given)")
+            ("max-idle-threads", po::value<unsigned>(), "number of idle fuse worker threads kept around (libfuse's default if not given)")
+            ("cache-timeout", po::value<double>(), "seconds the kernel may cache names and attributes (libfuse's default of 1 if not given), springy invalidates what changes behind its back")
+            ("direct-io", po::value<std::vector<std::string> >()->composing(), "bypass the kernel's page cache for matching files, a virtual path (the file or everything below the directory) or *.ext (e.g. *.sqlite)")
+            ("cache-policy", po::value<std::vector<std::string> >()->composing(), "page cache policy of files below a virtual mount point, MOUNTPOINT=auto|keep|none|direct (default auto: keep the cache of files unchanged since their last open)")
+            ("lowlevel", "use the inode based low level fuse api, volumes are resolved once per lookup")
+            ("passthrough", "let the kernel read and write files on local volumes directly (implies --lowlevel, needs a kernel and libfuse with fuse passthrough)")
+            ("pin-workers", "cpu pinning: one fuse worker per allowed cpu, each pinned to its cpu and reading its own /dev/fuse clone (implies --lowlevel)")
     #endif
         ;
         this->hiddenDesc.add_options()
@@ -59,6 +77,7 @@ namespace Springy{
 
         try{
             this->fuse.init(this->config, this->libc);
+            this->fuseLowlevel.init(this->config, this->libc);
         }catch(std::runtime_error &e){
             std::cerr << e.what() << std::endl;
             this->exitStatus = -1;
@@ -159,7 +178,8 @@ namespace Springy{
                                     throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "directory within mountpoint not allowed: " << directory;
                                 }
 
-                                this->config->volumes.addVolume(Springy::Util::Uri(std::string("file://")+directory), virtualmountpoint);
+                                std::string protocol = vm.count("io-uring") ? "uring://" : "file://";
+                                this->config->volumes.addVolume(Springy::Util::Uri(protocol+directory), virtualmountpoint);
                                 //this->config->directories.insert(std::make_pair(boost::filesystem::path(directory), boost::filesystem::path(virtualmountpoint)));
                             }
                         }
@@ -198,6 +218,54 @@ namespace Springy{
                     std::copy( cmdoptions.begin(), cmdoptions.end(), std::inserter( this->config->options, this->config->options.end() ) );
                 }
 
+                if (vm.count("cache-size")) {
+                    this->config->volumes.blockCache.setCapacity(vm["cache-size"].as<size_t>()*1024*1024);
+                }
+
+                if (vm.count("lock-profile")) {
+                    this->lockProfileFile = vm["lock-profile"].as<std::string>();
+                    SynchronizedProfiler::enable(true);
+                }
+
+                if (vm.count("flight-recorder")) {
+                    this->flightRecorderFile = vm["flight-recorder"].as<std::string>();
+                }
+                if (vm.count("flight-recorder-size")) {
+                    this->flightRecorderSize = vm["flight-recorder-size"].as<size_t>()*1024*1024;
+                }
+
+                if (vm.count("volume-threads")) {
+                    this->executorThreadCount = vm["volume-threads"].as<unsigned>();
+                }
+
+                if (vm.count("max-threads")) {
+                    this->config->fuseMaxThreads = vm["max-threads"].as<unsigned>();
+                }
+                if (vm.count("max-idle-threads")) {
+                    this->config->fuseMaxIdleThreads = vm["max-idle-threads"].as<unsigned>();
+                }
+
+                if (vm.count("cache-timeout")) {
+                    this->config->cacheTimeout = vm["cache-timeout"].as<double>();
+                }
+
+                if (vm.count("direct-io")) {
+                    std::vector<std::string> patterns = vm["direct-io"].as<std::vector<std::string> >();
+                    for (size_t i = 0; i < patterns.size(); i++) {
+                        this->config->cachePolicy.directIo(patterns[i]);
+                    }
+                }
+                if (vm.count("cache-policy")) {
+                    std::vector<std::string> policies = vm["cache-policy"].as<std::vector<std::string> >();
+                    for (size_t i = 0; i < policies.size(); i++) {
+                        size_t pos = policies[i].rfind('=');
+                        if (pos == std::string::npos) {
+                            throw std::runtime_error("invalid cache policy given: " + policies[i]);
+                        }
+                        this->config->cachePolicy.mode(policies[i].substr(0, pos), Springy::CachePolicy::parseMode(policies[i].substr(pos + 1)));
+                    }
+                }
+
                 if (vm.count("foreground")) {
                     this->config->foreground = true;
                 }
@@ -206,7 +274,13 @@ namespace Springy{
                 }
 
 std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
-                this->fuse.setUp(vm.count("single")!=0);
+                this->lowlevel = (vm.count("lowlevel")!=0 || vm.count("passthrough")!=0 || vm.count("pin-workers")!=0);
+                if(this->lowlevel){
+                    this->fuseLowlevel.setUp(vm.count("single")!=0, vm.count("passthrough")!=0, vm.count("pin-workers")!=0);
+                }
+                else{
+                    this->fuse.setUp(vm.count("single")!=0);
+                }
                 std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         }catch(std::runtime_error &e){ 
           std::cerr << "ERROR: " << e.what() << std::endl << std::endl; 
@@ -274,18 +348,39 @@ std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::e
       // print out all the frames to stderr
       fprintf(stderr, "Error: signal %d:\n", signal_number);
       backtrace_symbols_fd(array, size, STDERR_FILENO);
+
+      // nothing to do for the flight recorder, its MAP_SHARED pages belong to
+      // the file and outlive the process
       exit(-1);
     }
     void Brain::signalHandler(boost::asio::signal_set& this_, boost::system::error_code error, int signal_number){
         switch(signal_number){
             case SIGHUP:
                 break;
+            case SIGUSR1:
+                Brain::instance().writeLockProfile();
+                break;
             case SIGINT: case SIGTERM:
                 Brain::instance().io_service.stop();
                 return;
         }
         this_.async_wait(boost::bind(Brain::signalHandler, boost::ref(this_), _1, _2));
     }
+    void Brain::writeLockProfile(){
+        std::string file = this->lockProfileFile;
+        if(file.empty()){
+            std::stringstream ss;
+            ss << "/tmp/springy." << getpid() << ".locks";
+            file = ss.str();
+        }
+
+        std::ofstream out(file.c_str(), std::ios::out | std::ios::trunc);
+        if(!out){
+            std::cerr << "cannot write lock profile to " << file << std::endl;
+            return;
+        }
+        SynchronizedProfiler::report(out);
+    }
     Brain& Brain::run(){
         if(this->exitStatus){
             return *this;
@@ -317,14 +412,42 @@ std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::e
         }
 
         signal(SIGSEGV, Brain::sigsegv);
-        
+
+        // opened after forking, so the pid in the file name is the daemon's
+        if(!this->flightRecorderFile.empty()){
+            std::string file = this->flightRecorderFile;
+            size_t pos = file.find("%p");
+            if(pos != std::string::npos){
+                std::stringstream ss;
+                ss << getpid();
+                file.replace(pos, 2, ss.str());
+            }
+            if(!FlightRecorder::open(file, this->flightRecorderSize)){
+                std::cerr << "cannot open flight recorder " << file << ": " << strerror(errno) << std::endl;
+            }
+        }
+
         this->httpd.start();
-        this->fuse.run();
+        this->config->changes.start();
+        if(this->lowlevel){
+            this->fuseLowlevel.run();
+        }
+        else{
+            this->fuse.run();
+        }
 
         signals.async_wait(boost::bind(Brain::signalHandler, boost::ref(signals), _1, _2));
 
         std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
+        // the main thread runs it as well and handles the signals
+        for(unsigned i=0;i<this->executorThreadCount;i++){
+            this->executorThreads.push_back(std::thread([this](){ this->io_service.run(); }));
+        }
         io_service.run();
+        for(size_t i=0;i<this->executorThreads.size();i++){
+            this->executorThreads[i].join();
+        }
+        this->executorThreads.clear();
         std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
 
         /*
@@ -351,7 +474,15 @@ std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::e
         }
 
         this->httpd.stop();
-        this->fuse.tearDown();
+        if(this->lowlevel){
+            this->fuseLowlevel.tearDown();
+        }
+        else{
+            this->fuse.tearDown();
+        }
+        this->config->changes.stop();
+
+        FlightRecorder::close();
 
         return *this;
     }
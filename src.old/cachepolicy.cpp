@@ -0,0 +1,131 @@
+#include "cachepolicy.hpp"
+#include "exception.hpp"
+#include "trace.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+namespace Springy{
+    CachePolicy::CachePolicy(){}
+
+    CachePolicy::Mode CachePolicy::parseMode(const std::string &mode){
+        if(mode == "auto"){ return CachePolicy::AUTO; }
+        if(mode == "keep"){ return CachePolicy::KEEP; }
+        if(mode == "none"){ return CachePolicy::NONE; }
+        if(mode == "direct"){ return CachePolicy::DIRECT; }
+
+        throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "unknown cache policy " << mode;
+    }
+
+    void CachePolicy::mode(const boost::filesystem::path &virtualMountPoint, Mode mode){
+        Synchronized syncToken(this);
+        this->modes[virtualMountPoint] = mode;
+    }
+
+    void CachePolicy::directIo(const std::string &pattern){
+        Synchronized syncToken(this);
+        if(boost::algorithm::starts_with(pattern, "*")){
+            this->suffixes.push_back(pattern.substr(1));
+        }
+        else{
+            // "/db/" names the same directory as "/db"
+            std::string prefix = pattern;
+            while(prefix.size() > 0 && prefix[prefix.size() - 1] == '/'){
+                prefix.erase(prefix.size() - 1);
+            }
+            this->prefixes.push_back(prefix);
+        }
+    }
+
+    CachePolicy::Mode CachePolicy::modeOf(const boost::filesystem::path &virtualMountPoint){
+        std::map<boost::filesystem::path, Mode>::iterator it = this->modes.find(virtualMountPoint);
+        if(it == this->modes.end()){
+            return CachePolicy::AUTO;
+        }
+        return it->second;
+    }
+
+    bool CachePolicy::directIo(const boost::filesystem::path &file, const boost::filesystem::path &virtualMountPoint){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this, Synchronized::LockType::READ);
+
+        if(this->modeOf(virtualMountPoint) == CachePolicy::DIRECT){
+            return true;
+        }
+
+        const std::string &name = file.string();
+        for(size_t i=0;i<this->suffixes.size();i++){
+            if(boost::algorithm::ends_with(name, this->suffixes[i])){
+                return true;
+            }
+        }
+        // whole path components only, "/db" covers "/db" and "/db/x" but not "/dbx"
+        for(size_t i=0;i<this->prefixes.size();i++){
+            const std::string &prefix = this->prefixes[i];
+            if(boost::algorithm::starts_with(name, prefix) && (name.size() == prefix.size() || name[prefix.size()] == '/')){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool CachePolicy::keepCache(const boost::filesystem::path &file, const boost::filesystem::path &virtualMountPoint, const struct stat &st){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        bool unchanged;
+        {
+            Synchronized syncToken(this, Synchronized::LockType::READ);
+
+            Mode mode = this->modeOf(virtualMountPoint);
+            if(mode == CachePolicy::KEEP){
+                return true;
+            }
+            if(mode != CachePolicy::AUTO){
+                return false;
+            }
+
+            std::unordered_map<std::string, Served>::iterator it = this->servedFiles.find(file.string());
+            unchanged = it != this->servedFiles.end() &&
+                        it->second.dev == st.st_dev && it->second.ino == st.st_ino && it->second.size == st.st_size &&
+                        it->second.mtime.tv_sec == st.st_mtim.tv_sec && it->second.mtime.tv_nsec == st.st_mtim.tv_nsec;
+        }
+
+        // an unchanged file is remembered as it is, opens of it share the read lock
+        if(!unchanged){
+            Synchronized syncToken(this);
+            this->remember(file, st);
+        }
+        return unchanged;
+    }
+
+    void CachePolicy::served(const boost::filesystem::path &file, const struct stat &st){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this);
+
+        this->remember(file, st);
+    }
+
+    bool CachePolicy::cacheListing(const boost::filesystem::path &virtualMountPoint){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this, Synchronized::LockType::READ);
+
+        Mode mode = this->modeOf(virtualMountPoint);
+        return mode == CachePolicy::AUTO || mode == CachePolicy::KEEP;
+    }
+
+    void CachePolicy::remember(const boost::filesystem::path &file, const struct stat &st){
+        std::unordered_map<std::string, Served>::iterator it = this->servedFiles.find(file.string());
+        if(it == this->servedFiles.end()){
+            if(this->servedFiles.size() >= CachePolicy::maxServed){
+                this->servedFiles.erase(this->servedFiles.begin());
+            }
+            it = this->servedFiles.insert(std::make_pair(file.string(), Served())).first;
+        }
+        it->second.dev = st.st_dev;
+        it->second.ino = st.st_ino;
+        it->second.size = st.st_size;
+        it->second.mtime = st.st_mtim;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SPRINGY_CACHEPOLICY
+#define SPRINGY_CACHEPOLICY
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "util/synchronized.hpp"
+
+namespace Springy{
+    /**
+     * how the kernel's page cache is used for a file opened through the mount
+     *
+     * by default (AUTO) the cache of a file survives a reopen if the file still
+     * has the identity, mtime and size it had when the kernel last served it,
+     * much like libfuse's auto_cache but for both front ends and without an
+     * extra getattr. files matching a --direct-io pattern bypass the page cache,
+     * e.g. databases doing their own caching or huge files streamed once.
+     * virtual mount points may override the mode (--cache-policy). directory
+ * listings are cached unless the mode is NONE or DIRECT.
+     */
+    class CachePolicy : public Synchronizable{
+        public:
+            enum Mode{
+                AUTO,   // keep the cache if the file didn't change since it was last served
+                KEEP,   // always keep the cache, for volumes nobody changes behind springy's back
+                NONE,   // drop the cache on every open
+                DIRECT  // don't cache at all (direct_io)
+            };
+
+            CachePolicy();
+
+            // "auto", "keep", "none" or "direct", throws Springy::Exception otherwise
+            static Mode parseMode(const std::string &mode);
+
+            void mode(const boost::filesystem::path &virtualMountPoint, Mode mode);
+            // a virtual path, the file or everything below the directory, or "*.ext"
+            void directIo(const std::string &pattern);
+
+            bool directIo(const boost::filesystem::path &file, const boost::filesystem::path &virtualMountPoint);
+            // whether the kernel may keep what it cached of file, remembers st as served
+            bool keepCache(const boost::filesystem::path &file, const boost::filesystem::path &virtualMountPoint, const struct stat &st);
+            // the kernel's cache of file matches st, e.g. after it was written through the mount
+            void served(const boost::filesystem::path &file, const struct stat &st);
+            // whether the kernel may cache directory listings below virtualMountPoint
+            // across opens, it is told when a watched directory changes
+            bool cacheListing(const boost::filesystem::path &virtualMountPoint);
+
+        protected:
+            struct Served{
+                dev_t dev;
+                ino_t ino;
+                off_t size;
+                struct timespec mtime;
+            };
+            // bounds the memory of files opened once and never again
+            static const size_t maxServed = 64 * 1024;
+
+            std::map<boost::filesystem::path, Mode> modes;
+            std::vector<std::string> prefixes;
+            std::vector<std::string> suffixes;
+            std::unordered_map<std::string, Served> servedFiles;
+
+            Mode modeOf(const boost::filesystem::path &virtualMountPoint);
+            void remember(const boost::filesystem::path &file, const struct stat &st);
+    };
+}
+
+#endif
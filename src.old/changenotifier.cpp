@@ -0,0 +1,304 @@
+#include "changenotifier.hpp"
+#include "volume/ivolume.hpp"
+#include "trace.hpp"
+
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace Springy{
+    // IN_MODIFY is left out on purpose, it would fire for every write springy
+    // does itself. a writer is noticed when it closes the file
+    static const uint32_t watchMask = IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                                      IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+
+    ChangeNotifier::ChangeNotifier(Springy::LibC::ILibC *libc) : libc(libc), inotifyFd(-1), running(false), exhausted(false){}
+    ChangeNotifier::~ChangeNotifier(){
+        this->stop();
+    }
+
+    void ChangeNotifier::subscribe(const void *owner, Listener listener){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this);
+        this->listeners[owner] = listener;
+    }
+    void ChangeNotifier::unsubscribe(const void *owner){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this);
+        this->listeners.erase(owner);
+    }
+
+    void ChangeNotifier::changed(const boost::filesystem::path &path, Kind kind){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        std::vector<Listener> notify;
+        {
+            Synchronized syncToken(this, Synchronized::LockType::READ);
+            if(this->listeners.empty()){
+                return;
+            }
+            for(std::map<const void*, Listener>::iterator it=this->listeners.begin();it!=this->listeners.end();it++){
+                notify.push_back(it->second);
+            }
+        }
+
+        // listeners talk to the kernel, which may call back into springy, so no lock is held
+        for(size_t i=0;i<notify.size();i++){
+            notify[i](path, kind);
+        }
+    }
+
+    void ChangeNotifier::watch(Springy::Volume::IVolume *volume, const boost::filesystem::path &virtualMountPoint, const boost::filesystem::path &volumeRelativeDir){
+        if(!this->running.load(std::memory_order_relaxed)){
+            return;
+        }
+
+        boost::filesystem::path backing = volume->backingPath(volumeRelativeDir);
+        if(backing.empty()){
+            return;
+        }
+
+        {
+            Synchronized syncToken(this, Synchronized::LockType::READ);
+            if(this->exhausted || this->watched.find(backing.string()) != this->watched.end()){
+                return;
+            }
+        }
+
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this);
+        if(this->exhausted || this->watched.find(backing.string()) != this->watched.end()){
+            return;
+        }
+
+        int wd = this->libc->inotify_add_watch(__LINE__, this->inotifyFd, backing.c_str(), watchMask);
+        if(wd == -1){
+            if(errno == ENOSPC){
+                this->exhausted = true;
+                std::cerr << "inotify watch limit reached, further changes of backing directories go unnoticed"
+                          << " (fs.inotify.max_user_watches)" << std::endl;
+            }
+            return;
+        }
+
+        boost::filesystem::path virtualDir = virtualMountPoint;
+        if(!volumeRelativeDir.empty() && volumeRelativeDir != "/"){
+            virtualDir /= volumeRelativeDir.relative_path();
+        }
+        this->watches[wd] = virtualDir;
+        this->watched[backing.string()] = wd;
+        this->virtualDirs.insert(virtualDir);
+    }
+
+    // an event is read within milliseconds, the rest is slack for a busy system
+    static const uint64_t expectationTimeout = 2000;
+
+    uint64_t ChangeNotifier::now(){
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void ChangeNotifier::expect(const boost::filesystem::path &path, uint32_t events){
+        if(!this->running.load(std::memory_order_relaxed)){
+            return;
+        }
+
+        Synchronized syncToken(this);
+
+        // only a watched directory will report the events, IN_DELETE_SELF comes from the path itself
+        if(this->virtualDirs.find(path.parent_path()) == this->virtualDirs.end() &&
+           this->virtualDirs.find(path) == this->virtualDirs.end()){
+            return;
+        }
+
+        Expectation e;
+        e.events = events;
+        e.until = ChangeNotifier::now() + expectationTimeout;
+        this->expectations.insert(std::make_pair(path.string(), e));
+    }
+
+    bool ChangeNotifier::expected(const boost::filesystem::path &path, uint32_t event){
+        if(this->expectations.empty()){
+            return false;
+        }
+
+        uint64_t now = ChangeNotifier::now();
+        std::pair<std::unordered_multimap<std::string, Expectation>::iterator,
+                  std::unordered_multimap<std::string, Expectation>::iterator> range = this->expectations.equal_range(path.string());
+        for(std::unordered_multimap<std::string, Expectation>::iterator it=range.first;it!=range.second;it++){
+            if(it->second.until < now || !(it->second.events & event)){
+                // expired ones are dropped by expire()
+                continue;
+            }
+            it->second.events &= ~event;
+            if(it->second.events == 0){
+                this->expectations.erase(it);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void ChangeNotifier::expire(){
+        Synchronized syncToken(this);
+
+        uint64_t now = ChangeNotifier::now();
+        for(std::unordered_multimap<std::string, Expectation>::iterator it=this->expectations.begin();it!=this->expectations.end();){
+            if(it->second.until < now){
+                it = this->expectations.erase(it);
+            }else{
+                it++;
+            }
+        }
+    }
+
+    void ChangeNotifier::handle(const struct inotify_event *event){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        if(event->mask & IN_Q_OVERFLOW){
+            // events were lost, everything watched may have changed
+            std::vector<boost::filesystem::path> dirs;
+            {
+                Synchronized syncToken(this);
+                dirs.assign(this->virtualDirs.begin(), this->virtualDirs.end());
+                this->expectations.clear();
+            }
+            for(size_t i=0;i<dirs.size();i++){
+                this->changed(dirs[i], ChangeNotifier::DATA);
+            }
+            return;
+        }
+
+        boost::filesystem::path path;
+        {
+            Synchronized syncToken(this);
+
+            std::unordered_map<int, boost::filesystem::path>::iterator it = this->watches.find(event->wd);
+            if(it == this->watches.end()){
+                return;
+            }
+            path = it->second;
+            if(event->len > 0){
+                path /= event->name;
+            }
+
+            if(event->mask & IN_IGNORED){
+                // the directory is gone or was unmounted, the kernel dropped the watch
+                for(std::unordered_map<std::string, int>::iterator wit=this->watched.begin();wit!=this->watched.end();wit++){
+                    if(wit->second == event->wd){
+                        this->watched.erase(wit);
+                        break;
+                    }
+                }
+                std::multiset<boost::filesystem::path>::iterator vit = this->virtualDirs.find(it->second);
+                if(vit != this->virtualDirs.end()){
+                    this->virtualDirs.erase(vit);
+                }
+                this->watches.erase(it);
+                return;
+            }
+
+            if(this->expected(path, event->mask & watchMask)){
+                return;
+            }
+        }
+
+        if(event->mask & (IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO|IN_DELETE_SELF)){
+            this->changed(path, ChangeNotifier::ENTRY);
+        }
+        else if(event->mask & IN_CLOSE_WRITE){
+            this->changed(path, ChangeNotifier::DATA);
+        }
+        else if(event->mask & IN_ATTRIB){
+            this->changed(path, ChangeNotifier::ATTRIBUTES);
+        }
+    }
+
+    void ChangeNotifier::start(){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        if(this->running){
+            return;
+        }
+
+        this->inotifyFd = this->libc->inotify_init1(__LINE__, IN_NONBLOCK | IN_CLOEXEC);
+        if(this->inotifyFd == -1){
+            std::cerr << "cannot watch backing directories: " << this->libc->strerror(__LINE__, errno) << std::endl;
+            return;
+        }
+
+        this->running = true;
+        this->th = std::thread(ChangeNotifier::thread, this);
+    }
+
+    void ChangeNotifier::stop(){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        if(!this->running){
+            return;
+        }
+
+        this->running = false;
+        if(this->th.joinable()){
+            this->th.join();
+        }
+        this->libc->close(__LINE__, this->inotifyFd);
+        this->inotifyFd = -1;
+
+        Synchronized syncToken(this);
+        this->watches.clear();
+        this->watched.clear();
+        this->virtualDirs.clear();
+        this->expectations.clear();
+        this->exhausted = false;
+    }
+
+    void ChangeNotifier::thread(ChangeNotifier *instance){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        // large enough for a few events with names of NAME_MAX
+        char buf[64 * 1024] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        uint64_t lastExpiry = ChangeNotifier::now();
+
+        while(instance->running){
+            struct pollfd pfd;
+            pfd.fd = instance->inotifyFd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+
+            // the timeout bounds how long stop() waits for this thread
+            int res = ::poll(&pfd, 1, 1000);
+
+            // expectations of mutations that failed or caused no event
+            if(ChangeNotifier::now() - lastExpiry >= expectationTimeout){
+                instance->expire();
+                lastExpiry = ChangeNotifier::now();
+            }
+
+            if(res <= 0){
+                continue;
+            }
+
+            ssize_t len = instance->libc->read(__LINE__, instance->inotifyFd, buf, sizeof(buf));
+            if(len <= 0){
+                continue;
+            }
+
+            for(char *p=buf;p<buf+len;){
+                const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(p);
+                try{
+                    instance->handle(event);
+                }catch(...){
+                    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+}
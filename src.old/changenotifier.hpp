@@ -0,0 +1,98 @@
+#ifndef SPRINGY_CHANGENOTIFIER
+#define SPRINGY_CHANGENOTIFIER
+
+#include <stdint.h>
+#include <sys/inotify.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+
+#include "util/synchronized.hpp"
+#include "libc/ilibc.hpp"
+
+namespace Springy{
+    namespace Volume{
+        class IVolume;
+    }
+
+    /**
+     * changes of the virtual file system the kernel didn't see coming through the mount
+     *
+     * the fuse front ends subscribe while mounted and turn a changed virtual path
+     * into notify_inval_inode/notify_inval_entry, so names and attributes may be
+     * cached by the kernel for a long time (--cache-timeout).
+     *
+     * changes are reported by springy itself (httpd api) and by inotify watches
+     * on the backing directories of local volumes. a directory is watched once
+     * it was listed or a file in it was looked up, which are exactly the
+     * directories the kernel may have cached something of. writes are noticed
+     * when the writer closes the file (IN_CLOSE_WRITE). springy's own mutations
+     * went through the mount and are known to the kernel already, the FsOps
+     * announce them by expect() so their events don't drop cached entries,
+     * attributes or pages, nor the locations the NodeTable remembered.
+     */
+    class ChangeNotifier : public Synchronizable{
+        public:
+            enum Kind{
+                ATTRIBUTES, // owner, mode, times of the path
+                DATA,       // contents and attributes
+                ENTRY       // the name was created, removed or renamed
+            };
+            typedef std::function<void(const boost::filesystem::path &path, Kind kind)> Listener;
+
+            ChangeNotifier(Springy::LibC::ILibC *libc);
+            ~ChangeNotifier();
+
+            void subscribe(const void *owner, Listener listener);
+            void unsubscribe(const void *owner);
+
+            void changed(const boost::filesystem::path &path, Kind kind);
+
+            // watch the backing directory of volumeRelativeDir, no-op for volumes
+            // without a backing path or while not started
+            void watch(Springy::Volume::IVolume *volume, const boost::filesystem::path &virtualMountPoint, const boost::filesystem::path &volumeRelativeDir);
+            // springy is about to cause the given inotify events (IN_CREATE, IN_DELETE, ...)
+            // on path, each of them is ignored once. events that don't come expire
+            void expect(const boost::filesystem::path &path, uint32_t events);
+
+            void start();
+            void stop();
+
+        protected:
+            Springy::LibC::ILibC *libc;
+
+            int inotifyFd;
+            std::atomic<bool> running;
+            bool exhausted;     // fs.inotify.max_user_watches reached, logged once
+            std::thread th;
+
+            std::map<const void*, Listener> listeners;
+
+            std::unordered_map<int, boost::filesystem::path> watches;   // wd -> virtual directory
+            std::unordered_map<std::string, int> watched;               // backing directory -> wd
+            std::multiset<boost::filesystem::path> virtualDirs;         // same directory of several volumes counts once per volume
+
+            struct Expectation{
+                uint32_t events;    // not seen yet
+                uint64_t until;     // ms, steady clock
+            };
+            std::unordered_multimap<std::string, Expectation> expectations;
+
+            static uint64_t now();
+            // true if the event on path was announced by expect(), consumes it
+            bool expected(const boost::filesystem::path &path, uint32_t event);
+            void expire();
+
+            void handle(const struct inotify_event *event);
+            static void thread(ChangeNotifier *instance);
+    };
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include "flightrecorder.hpp"
+#include "trace.hpp"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace Springy{
+    FlightRecorder::Header* FlightRecorder::header = NULL;
+    size_t FlightRecorder::mapSize = 0;
+
+    static std::mutex& internLock(){
+        static std::mutex *lock = new std::mutex();
+        return *lock;
+    }
+    static std::unordered_map<std::string, uint32_t>& internedStrings(){
+        static std::unordered_map<std::string, uint32_t> *strings = new std::unordered_map<std::string, uint32_t>();
+        return *strings;
+    }
+
+    bool FlightRecorder::open(const std::string &file, size_t size){
+        if(FlightRecorder::header != NULL){
+            return true;
+        }
+        if(size < 1024*1024){
+            size = 1024*1024;
+        }
+
+        int fd = ::open(file.c_str(), O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC, 0600);
+        if(fd == -1){
+            return false;
+        }
+        if(::ftruncate(fd, size) == -1){
+            ::close(fd);
+            return false;
+        }
+        void *p = ::mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(p == MAP_FAILED){
+            return false;
+        }
+
+        Header *h = (Header*)p;
+        memset(h, 0, sizeof(Header));
+        memcpy(h->magic, "SPRINGFR", 8);
+        h->version = FlightRecorder::version;
+        h->recordSize = sizeof(Record);
+        // an eighth for call site and volume names, the rest for records
+        h->stringsOffset = sizeof(Header);
+        h->stringsSize = size / 8;
+        h->recordsOffset = h->stringsOffset + h->stringsSize;
+        h->recordsOffset = (h->recordsOffset + 63) & ~(uint64_t)63;
+        h->capacity = (size - h->recordsOffset) / sizeof(Record);
+        h->stringsUsed = 1; // offset 0 means "no string"
+        h->pid = getpid();
+
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        h->startNs = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+        FlightRecorder::mapSize = size;
+        FlightRecorder::header = h;
+        return true;
+    }
+
+    void FlightRecorder::close(){
+        Header *h = FlightRecorder::header;
+        if(h == NULL){
+            return;
+        }
+        FlightRecorder::header = NULL;
+        ::msync(h, FlightRecorder::mapSize, MS_SYNC);
+        // the mapping stays, a frame ending concurrently may still write into it
+    }
+
+    uint32_t FlightRecorder::intern(const std::string &s){
+        Header *h = FlightRecorder::header;
+
+        std::lock_guard<std::mutex> lock(internLock());
+        std::unordered_map<std::string, uint32_t> &strings = internedStrings();
+        std::unordered_map<std::string, uint32_t>::iterator it = strings.find(s);
+        if(it != strings.end()){
+            return it->second;
+        }
+
+        // [uint32 length][bytes]
+        uint64_t need = sizeof(uint32_t) + s.length();
+        if(h->stringsUsed + need > h->stringsSize){
+            return 0;
+        }
+        uint32_t offset = h->stringsUsed;
+        char *p = (char*)h + h->stringsOffset + offset;
+        uint32_t len = s.length();
+        memcpy(p, &len, sizeof(len));
+        memcpy(p + sizeof(len), s.data(), len);
+        __atomic_store_n(&h->stringsUsed, h->stringsUsed + need, __ATOMIC_RELEASE);
+
+        strings[s] = offset;
+        return offset;
+    }
+
+    uint32_t FlightRecorder::siteId(const char *file, const char *method){
+        // __PRETTY_FUNCTION__ is unique per function, its address identifies the site
+        static thread_local std::unordered_map<const char*, uint32_t> *sites = NULL;
+        if(sites == NULL){
+            sites = new std::unordered_map<const char*, uint32_t>();
+        }
+        std::unordered_map<const char*, uint32_t>::iterator it = sites->find(method);
+        if(it != sites->end()){
+            return it->second;
+        }
+        uint32_t id = FlightRecorder::intern(std::string(file) + "\t" + method);
+        (*sites)[method] = id;
+        return id;
+    }
+
+    uint32_t FlightRecorder::volumeId(uint32_t volume){
+        if(FlightRecorder::header == NULL || volume == 0){
+            return 0;
+        }
+        static thread_local std::unordered_map<uint32_t, uint32_t> *volumes = NULL;
+        if(volumes == NULL){
+            volumes = new std::unordered_map<uint32_t, uint32_t>();
+        }
+        std::unordered_map<uint32_t, uint32_t>::iterator it = volumes->find(volume);
+        if(it != volumes->end()){
+            return it->second;
+        }
+        uint32_t id = FlightRecorder::intern(Trace::volumeName(volume));
+        (*volumes)[volume] = id;
+        return id;
+    }
+
+    void FlightRecorder::record(const char *file, const char *method, int line, int depth, int err, uint64_t startNs, uint64_t endNs, uint32_t volume){
+        Header *h = FlightRecorder::header;
+        if(h == NULL){
+            return;
+        }
+
+        static thread_local uint32_t tid = 0;
+        if(tid == 0){
+            tid = syscall(SYS_gettid);
+        }
+
+        uint64_t pos = __atomic_fetch_add(&h->head, 1, __ATOMIC_RELAXED);
+        Record *r = (Record*)((char*)h + h->recordsOffset) + (pos % h->capacity);
+
+        // invalidate first, so a reader never pairs old fields with the new seq
+        __atomic_store_n(&r->seq, 0, __ATOMIC_RELEASE);
+        r->startNs = startNs;
+        r->durationNs = endNs - startNs;
+        r->site = FlightRecorder::siteId(file, method);
+        r->volume = volume;
+        r->line = line;
+        r->err = err;
+        r->tid = tid;
+        r->depth = depth;
+        r->reserved = 0;
+        __atomic_store_n(&r->seq, pos + 1, __ATOMIC_RELEASE);
+    }
+}
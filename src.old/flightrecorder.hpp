@@ -0,0 +1,72 @@
+#ifndef SPRINGY_FLIGHTRECORDER
+#define SPRINGY_FLIGHTRECORDER
+
+#include <stdint.h>
+
+#include <string>
+
+namespace Springy{
+    /**
+     * binary flight recorder
+     *
+     * when opened, every finished Trace frame is written as a fixed size record
+     * into a circular file mapped with MAP_SHARED. the data lives in the page
+     * cache, so whatever was written before a crash or a kill -9 is still in the
+     * file afterwards - tools/flightdump turns it into text or chrome trace json.
+     *
+     * file layout: Header, string table, record slots. strings (call sites and
+     * volume names) are referenced by their offset into the string table, a slot
+     * is valid once its seq equals its position + 1.
+     */
+    class FlightRecorder{
+        public:
+            static const uint32_t version = 1;
+
+            struct Header{
+                char magic[8];          // "SPRINGFR"
+                uint32_t version;
+                uint32_t recordSize;
+                uint64_t capacity;      // number of record slots
+                uint64_t stringsOffset;
+                uint64_t stringsSize;
+                uint64_t recordsOffset;
+                uint64_t head;          // next slot to be written, ever increasing
+                uint64_t stringsUsed;
+                uint64_t startNs;       // wall clock when the file was opened
+                int32_t pid;
+                uint32_t reserved;
+            };
+
+            struct Record{
+                uint64_t seq;       // slot position + 1, stored last
+                uint64_t startNs;   // wall clock
+                uint64_t durationNs;
+                uint32_t site;      // "file\tmethod" in the string table
+                uint32_t volume;    // volume name in the string table, 0 if none
+                int32_t line;
+                int32_t err;        // errno the frame failed with (Trace::result), 0 if it didn't
+                uint32_t tid;
+                uint16_t depth;
+                uint16_t reserved;
+            };
+
+            // size in bytes of the whole file, at least 1MiB
+            static bool open(const std::string &file, size_t size);
+            static void close();
+            static bool enabled(){ return FlightRecorder::header != NULL; }
+
+            static void record(const char *file, const char *method, int line, int depth, int err, uint64_t startNs, uint64_t endNs, uint32_t volume);
+
+            // string table offset of the name of a Trace volume number, cached per thread
+            static uint32_t volumeId(uint32_t volume);
+
+        protected:
+            static Header *header;
+            static size_t mapSize;
+
+            static uint32_t intern(const std::string &s);
+            static uint32_t siteId(const char *file, const char *method);
+    };
+}
+
+#endif
@@ -17,7 +17,7 @@ namespace Springy {
             boost::filesystem::path parent = path.parent_path();
             if(parent.empty()){
                 Trace(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return 0;
+                return t.result(0);
             }
 
             struct stat st;
@@ -26,23 +26,21 @@ namespace Springy {
                 if (!S_ISDIR(st.st_mode)) {
                     errno = ENOTDIR;
                     Trace(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
-                return 0;
+                return t.result(0);
             }
 
             VolumeInfo vinfo;
-            try {
-                vinfo = this->findVolume(parent);
-            } catch (...) {
+            if (this->findVolume(parent, vinfo) != 0) {
                 Trace(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -EFAULT;
+                return t.result(-EFAULT);
             }
 
             // create parent dirs
             int res = this->cloneParentDirsIntoVolume(volume, parent);
             if (res != 0) {
-                return res;
+                return t.result(res);
             }
 
             res = volume->mkdir(parent, st.st_mode);
@@ -59,44 +57,80 @@ namespace Springy {
                 res = -errno;
             }
 
-            return res;
+            return t.result(res);
         }
 
-        int Abstract::lock(MetaRequest meta, const boost::filesystem::path path, int fd, int cmd, struct ::flock *lck, const void *owner, size_t owner_len){
+        int Abstract::lock(MetaRequest meta, const boost::filesystem::path path, uint64_t fh, int cmd, struct ::flock *lck, const void *owner, size_t owner_len){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             try {
-                VolumeInfo vinfo = this->findVolume(path);
-                int res = vinfo.volume->lock(path, fd, cmd, lck, (const uint64_t*)owner);
+                VolumeInfo vinfo;
+                if (this->findVolume(path, vinfo) != 0) {
+                    return t.result(-EBADFD);
+                }
+                int res = vinfo.volume->lock(path, (int)fh, cmd, lck, (const uint64_t*)owner);
                 if (res == -1)
-                    return -errno;
+                    return t.result(-errno);
             } catch (...) {
                 errno = EBADFD;
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+                return t.result(-errno);
             }
 
-            return 0;
+            return t.result(0);
         }
 
         /////////////////// Path based operations ////////////////////////////////
 
+        int Abstract::resolve(MetaRequest meta, const boost::filesystem::path file, Springy::NodeTable::Location &location, struct stat *buf){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if (buf == nullptr) {
+                return t.result(-EINVAL);
+            }
+
+            try {
+                VolumeInfo vinfo;
+                int res = this->findVolume(file, vinfo);
+                if (res != 0) {
+                    return t.result(res);
+                }
+                location.volume = vinfo.volume;
+                location.virtualMountPoint = vinfo.virtualMountPoint;
+                location.volumeRelativeFileName = vinfo.volumeRelativeFileName;
+                *buf = vinfo.st;
+
+                // the kernel caches what it looked up, so its directory is watched from now on
+                this->config->changes.watch(vinfo.volume, vinfo.virtualMountPoint, vinfo.volumeRelativeFileName.parent_path());
+                return t.result(0);
+            } catch (...) {
+            }
+
+            return t.result(-ENOENT);
+        }
+
         int Abstract::getattr(MetaRequest meta, const boost::filesystem::path file_name, struct stat *buf){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (buf == nullptr) {
-                return -EINVAL;
+                return t.result(-EINVAL);
             }
 
             try {
-                VolumeInfo vinfo = this->findVolume(file_name);
+                VolumeInfo vinfo;
+                int res = this->findVolume(file_name, vinfo);
+                if (res != 0) {
+                    return t.result(res);
+                }
                 *buf = vinfo.st;
-                return 0;
+
+                this->config->changes.watch(vinfo.volume, vinfo.virtualMountPoint, vinfo.volumeRelativeFileName.parent_path());
+                return t.result(0);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
 
-            return -ENOENT;
+            return t.result(-ENOENT);
         }
         
 
@@ -104,45 +138,58 @@ namespace Springy {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             try {
-                VolumeInfo vinfo = this->findVolume(path);
+                VolumeInfo vinfo;
+                int found = this->findVolume(path, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
+                // an open file is truncated under the whole file guard, like through ftruncate
+                std::shared_ptr<OpenFiles::FileState> state = this->config->openFiles.state(vinfo.volume, vinfo.volumeRelativeFileName);
+                std::unique_ptr<Springy::Util::RangeLock::Guard> range;
+                if (state) {
+                    range.reset(new Springy::Util::RangeLock::Guard(state->ranges, 0, 0));
+                }
                 int res = vinfo.volume->truncate(vinfo.volumeRelativeFileName, -1, size);
 
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
-                return 0;
+                return t.result(0);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
             errno = ENOENT;
-            return -errno;
+            return t.result(-errno);
         }
 
         int Abstract::statfs(MetaRequest meta, const boost::filesystem::path path, struct statvfs *buf) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (buf == nullptr) {
-                return -EINVAL;
+                return t.result(-EINVAL);
             }
 
             std::vector<struct statvfs> stats;
             std::set<dev_t> localDevices;
 
-            try {
-                this->findVolume(path);
-            } catch (...) {
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -ENOENT;
+            VolumeInfo vinfo;
+            int res = this->findVolume(path, vinfo);
+            if (res != 0) {
+                return t.result(res);
             }
 
             unsigned long min_block = 0, min_frame = 0;
 
-            Springy::Volumes::VolumeRelativeFile vols = this->getVolumesByVirtualFileName(path);
+            Springy::Volumes::VolumeRelativeFile vols;
+            res = this->getVolumesByVirtualFileName(path, vols);
+            if (res != 0) {
+                return t.result(res);
+            }
 
             std::set<Springy::Volume::IVolume*>::iterator it;
             for (it = vols.volumes.begin(); it != vols.volumes.end(); it++) {
@@ -151,9 +198,10 @@ namespace Springy {
                     struct stat st;
                     int ret = volume->getattr(vols.volumeRelativeFileName, &st);
                     if (ret != 0) {
-                        return -errno;
+                        return t.result(-errno);
                     }
-                    if (localDevices.find(st.st_dev) == localDevices.end()) {
+                    // several volumes on one device count once
+                    if (!localDevices.insert(st.st_dev).second) {
                         continue;
                     }
                 }
@@ -161,7 +209,7 @@ namespace Springy {
                 struct statvfs stv;
                 int ret = volume->statvfs(vols.volumeRelativeFileName, &stv);
                 if (ret != 0) {
-                    return -errno;
+                    return t.result(-errno);
                 }
 
                 stats.push_back(stv);
@@ -207,7 +255,7 @@ namespace Springy {
                 buf->f_blocks += stats[i].f_blocks;
             }
 
-            return 0;
+            return t.result(0);
         }
 
         int Abstract::readdir(
@@ -220,7 +268,11 @@ namespace Springy {
             size_t found = 0;
             std::vector<Springy::Volume::IVolume*> dirs;
 
-            Springy::Volumes::VolumeRelativeFile vols = this->getVolumesByVirtualFileName(dirname);
+            Springy::Volumes::VolumeRelativeFile vols;
+            int res = this->getVolumesByVirtualFileName(dirname, vols);
+            if (res != 0) {
+                return t.result(res);
+            }
 
             std::set<Springy::Volume::IVolume*>::iterator it;
             for (it = vols.volumes.begin(); it != vols.volumes.end(); it++) {
@@ -241,100 +293,99 @@ namespace Springy {
                 errno = ENOENT;
                 if (found) errno = ENOTDIR;
 
-                return -errno;
+                return t.result(-errno);
             }
 
             // read directories
             for (size_t i = 0; i < dirs.size(); i++) {
                 Springy::Volume::IVolume *volume = dirs[i];
                 volume->readdir(vols.volumeRelativeFileName, directories);
+                this->config->changes.watch(volume, vols.virtualMountPoint, vols.volumeRelativeFileName);
             }
 
-            return 0;
+            return t.result(0);
         }
 
         int Abstract::readlink(MetaRequest meta, const boost::filesystem::path path, char *buf, size_t size) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (buf == NULL) {
-                return -EINVAL;
+                return t.result(-EINVAL);
             }
 
             int res = 0;
             try {
-                VolumeInfo vinfo = this->findVolume(path);
+                VolumeInfo vinfo;
+                int found = this->findVolume(path, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
                 memset(buf, 0, size);
                 res = vinfo.volume->readlink(vinfo.volumeRelativeFileName, buf, size);
 
                 if (res >= 0)
-                    return 0;
-                return -errno;
+                    return t.result(0);
+                return t.result(-errno);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
-            return -ENOENT;
+            return t.result(-ENOENT);
         }
 
         int Abstract::access(MetaRequest meta, const boost::filesystem::path path, int mode) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly && (mode & F_OK) != F_OK && (mode & R_OK) != R_OK) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             try {
-                VolumeInfo vinfo = this->findVolume(path);
+                VolumeInfo vinfo;
+                int found = this->findVolume(path, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
                 int res = vinfo.volume->access(vinfo.volumeRelativeFileName, mode);
 
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
-                return 0;
+                return t.result(0);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
             errno = ENOENT;
-            return -errno;
+            return t.result(-errno);
         }
 
         int Abstract::mkdir(MetaRequest meta, const boost::filesystem::path path, mode_t mode) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             VolumeInfo vinfo;
-            try {
-                vinfo = this->findVolume(path);
-
-                errno = EEXIST;
-                return -errno;
-            } catch (...) {
+            if (this->findVolume(path, vinfo) == 0) {
+                return t.result(-EEXIST);
             }
 
-            try {
-                boost::filesystem::path parent = path.parent_path();
-                if(parent.empty()){ throw ENOENT; }
-                this->findVolume(parent);
-            } catch (...) {
-                errno = ENOENT;
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+            boost::filesystem::path parent = path.parent_path();
+            if (parent.empty() || this->findVolume(parent, vinfo) != 0) {
+                return t.result(-ENOENT);
             }
 
-            try {
-                vinfo = this->getMaxFreeSpaceVolume(path);
-            } catch (...) {
-                errno = ENOSPC;
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+            int res = this->getMaxFreeSpaceVolume(path, vinfo);
+            if (res != 0) {
+                return t.result(res);
             }
 
             this->cloneParentDirsIntoVolume(vinfo.volume, vinfo.volumeRelativeFileName);
+            bool root = this->libc->getuid(__LINE__) == 0;
+            this->config->changes.expect(path, IN_CREATE | (root ? IN_ATTRIB : 0));
             if (vinfo.volume->mkdir(vinfo.volumeRelativeFileName, mode) == 0) {
-                if (this->libc->getuid(__LINE__) == 0) {
+                if (root) {
                     struct stat st;
                     gid_t gid = meta.g;
                     if (vinfo.volume->getattr(vinfo.volumeRelativeFileName, &st) == 0) {
@@ -344,57 +395,72 @@ namespace Springy {
                     }
                     vinfo.volume->chown(vinfo.volumeRelativeFileName, meta.u, gid);
                 }
-                return 0;
+                return t.result(0);
             }
 
             t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -errno;
+            return t.result(-errno);
         }
 
         int Abstract::rmdir(MetaRequest meta, const boost::filesystem::path path) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
+            this->xattrs.invalidate(path.string());
+
             try {
-                VolumeInfo vinfo = this->findVolume(path);
+                VolumeInfo vinfo;
+                int found = this->findVolume(path, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
+                // the directory's own watch reports IN_DELETE_SELF
+                this->config->changes.expect(path, IN_DELETE | IN_DELETE_SELF);
                 int res = vinfo.volume->rmdir(vinfo.volumeRelativeFileName);
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
 
-                return 0;
+                return t.result(0);
             } catch (...) {
             }
 
             t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -ENOENT;
+            return t.result(-ENOENT);
         }
 
         int Abstract::unlink(MetaRequest meta, const boost::filesystem::path path) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
+            this->xattrs.invalidate(path.string());
+
             try {
-                VolumeInfo vinfo = this->findVolume(path);
+                VolumeInfo vinfo;
+                int found = this->findVolume(path, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
+                this->config->changes.expect(path, IN_DELETE);
                 int res = vinfo.volume->unlink(vinfo.volumeRelativeFileName);
 
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
 
-                return 0;
+                return t.result(0);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
                 errno = ENOENT;
-                return -errno;
+                return t.result(-errno);
             }
         }
 
@@ -402,21 +468,28 @@ namespace Springy {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             int res;
             struct stat st;
 
             if (from == to)
-                return 0;
+                return t.result(0);
+
+            this->xattrs.invalidate(from.string());
+            this->xattrs.invalidate(to.string());
 
             boost::filesystem::path fromParent = from.parent_path();
             if(fromParent.empty()){ fromParent = boost::filesystem::path("/"); }
             boost::filesystem::path toParent = to.parent_path();
             if(toParent.empty()){ toParent = boost::filesystem::path("/"); }
 
-            Springy::Volumes::VolumeRelativeFile fromVolumes = this->getVolumesByVirtualFileName(from);
+            Springy::Volumes::VolumeRelativeFile fromVolumes;
+            res = this->getVolumesByVirtualFileName(from, fromVolumes);
+            if (res != 0) {
+                return t.result(res);
+            }
 
             std::set<Springy::Volume::IVolume*>::iterator it;
             for (it = fromVolumes.volumes.begin(); it != fromVolumes.volumes.end(); it++) {
@@ -424,28 +497,34 @@ namespace Springy {
                     continue;
                 }
 
+                this->config->changes.expect(from, IN_MOVED_FROM);
+                this->config->changes.expect(to, IN_MOVED_TO);
                 res = (*it)->rename(fromVolumes.volumeRelativeFileName, to);
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
             }
 
-            return 0;
+            return t.result(0);
         }
 
         int Abstract::utimens(MetaRequest meta, const boost::filesystem::path path, const struct timespec ts[2]) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             size_t flag_found = 0;
             int res;
             struct stat st;
 
-            Springy::Volumes::VolumeRelativeFile pathVolumes = this->getVolumesByVirtualFileName(path);
+            Springy::Volumes::VolumeRelativeFile pathVolumes;
+            res = this->getVolumesByVirtualFileName(path, pathVolumes);
+            if (res != 0) {
+                return t.result(res);
+            }
 
             std::set<Springy::Volume::IVolume*>::iterator it;
             for (it = pathVolumes.volumes.begin(); it != pathVolumes.volumes.end(); it++) {
@@ -455,31 +534,36 @@ namespace Springy {
 
                 flag_found = 1;
 
+                this->config->changes.expect(path, IN_ATTRIB);
                 res = (*it)->utimensat(pathVolumes.volumeRelativeFileName, ts);
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
             }
             if (flag_found)
-                return 0;
+                return t.result(0);
             errno = ENOENT;
             t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -errno;
+            return t.result(-errno);
         }
 
         int Abstract::chmod(MetaRequest meta, const boost::filesystem::path path, mode_t mode) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             size_t flag_found;
             int res;
             struct stat st;
 
-            Springy::Volumes::VolumeRelativeFile pathVolumes = this->getVolumesByVirtualFileName(path);
+            Springy::Volumes::VolumeRelativeFile pathVolumes;
+            res = this->getVolumesByVirtualFileName(path, pathVolumes);
+            if (res != 0) {
+                return t.result(res);
+            }
 
             std::set<Springy::Volume::IVolume*>::iterator it;
             for (it = pathVolumes.volumes.begin(); it != pathVolumes.volumes.end(); it++) {
@@ -488,32 +572,37 @@ namespace Springy {
                 }
 
                 flag_found = 1;
+                this->config->changes.expect(path, IN_ATTRIB);
                 res = (*it)->chmod(pathVolumes.volumeRelativeFileName, mode);
 
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
             }
             if (flag_found)
-                return 0;
+                return t.result(0);
             errno = ENOENT;
             t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -errno;
+            return t.result(-errno);
         }
 
         int Abstract::chown(MetaRequest meta, const boost::filesystem::path path, uid_t uid, gid_t gid) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             size_t flag_found;
             int res;
             struct stat st;
 
-            Springy::Volumes::VolumeRelativeFile pathVolumes = this->getVolumesByVirtualFileName(path);
+            Springy::Volumes::VolumeRelativeFile pathVolumes;
+            res = this->getVolumesByVirtualFileName(path, pathVolumes);
+            if (res != 0) {
+                return t.result(res);
+            }
 
             std::set<Springy::Volume::IVolume*>::iterator it;
             for (it = pathVolumes.volumes.begin(); it != pathVolumes.volumes.end(); it++) {
@@ -522,25 +611,28 @@ namespace Springy {
                 }
 
                 flag_found = 1;
+                // a chown drops security.capability on the backing file
+                this->xattrs.invalidate(path.string());
+                this->config->changes.expect(path, IN_ATTRIB);
                 res = (*it)->chown(pathVolumes.volumeRelativeFileName, uid, gid);
 
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
             }
             if (flag_found)
-                return 0;
+                return t.result(0);
             errno = ENOENT;
             t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -errno;
+            return t.result(-errno);
         }
 
         int Abstract::symlink(MetaRequest meta, const boost::filesystem::path oldname, const boost::filesystem::path newname) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             int res;
@@ -548,115 +640,101 @@ namespace Springy {
             // symlink only works on same volume type
             VolumeInfo vinfo;
             boost::filesystem::path parent = newname.parent_path();
-            try {
-                if(parent.empty()){ throw ENOENT; }
-                vinfo = this->findVolume(parent);
-            } catch (...) {
-                errno = ENOENT;
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+            if (parent.empty() || this->findVolume(parent, vinfo) != 0) {
+                return t.result(-ENOENT);
             }
 
             // symlink into found Volume
+            this->config->changes.expect(newname, IN_CREATE);
             res = vinfo.volume->symlink(this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, oldname),
                     this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, newname));
             if (res == 0) {
-                return 0;
+                return t.result(0);
             }
             if (errno != ENOSPC) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+                return t.result(-errno);
             }
 
-            try {
-                vinfo = this->getMaxFreeSpaceVolume(parent);
-            } catch (...) {
-                errno = ENOSPC;
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+            res = this->getMaxFreeSpaceVolume(parent, vinfo);
+            if (res != 0) {
+                return t.result(res);
             }
 
             // symlink into max free space volume
             this->cloneParentDirsIntoVolume(vinfo.volume, this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, newname));
+            this->config->changes.expect(newname, IN_CREATE);
             res = vinfo.volume->symlink(this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, oldname),
                     this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, newname));
             if (res == 0) {
-                return 0;
+                return t.result(0);
             }
             if (errno != ENOSPC) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+                return t.result(-errno);
             }
 
             t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -errno;
+            return t.result(-errno);
         }
 
         int Abstract::link(MetaRequest meta, const boost::filesystem::path oldname, const boost::filesystem::path newname) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             int res = 0;
             VolumeInfo vinfo;
 
-            try {
-                vinfo = this->findVolume(oldname);
-            } catch (...) {
-                errno = ENOENT;
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+            res = this->findVolume(oldname, vinfo);
+            if (res != 0) {
+                return t.result(res);
             }
 
             res = this->cloneParentDirsIntoVolume(vinfo.volume, this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, newname));
             if (res != 0) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return res;
+                return t.result(res);
             }
 
+            this->config->changes.expect(newname, IN_CREATE);
             res = vinfo.volume->link(this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, oldname),
                     this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, newname));
 
             if (res == 0)
-                return 0;
+                return t.result(0);
             t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -errno;
+            return t.result(-errno);
         }
 
         int Abstract::mknod(MetaRequest meta, const boost::filesystem::path path, mode_t mode, dev_t rdev) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             int res, i;
             boost::filesystem::path parent = path.parent_path();
             VolumeInfo vinfo;
-            try {
-                if(parent.empty()){ throw ENOENT; }
-                vinfo = this->findVolume(parent);
-            } catch (...) {
-                errno = ENOENT;
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+            if (parent.empty() || this->findVolume(parent, vinfo) != 0) {
+                return t.result(-ENOENT);
             }
 
             for (i = 0; i < 2; i++) {
                 if (i) {
-                    try {
-                        vinfo = this->getMaxFreeSpaceVolume(parent);
-                    } catch (...) {
-                        errno = ENOSPC;
-                        t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                        return -errno;
+                    res = this->getMaxFreeSpaceVolume(parent, vinfo);
+                    if (res != 0) {
+                        return t.result(res);
                     }
 
                     this->cloneParentDirsIntoVolume(vinfo.volume, this->config->volumes.convertFuseFilenameToVolumeRelativeFilename(vinfo.volume, path));
                 }
 
+                bool root = this->libc->getuid(__LINE__) == 0;
+                this->config->changes.expect(path, IN_CREATE | (S_ISREG(mode) ? IN_CLOSE_WRITE : 0) | (root ? IN_ATTRIB : 0));
                 if (S_ISREG(mode)) {
                     res = vinfo.volume->open(path, O_CREAT | O_EXCL | O_WRONLY, mode);
                     if (res >= 0)
@@ -667,120 +745,211 @@ namespace Springy {
                     res = vinfo.volume->mknod(path, mode, rdev);
 
                 if (res != -1) {
-                    if (this->libc->getuid(__LINE__) == 0) {
+                    if (root) {
                         vinfo.volume->chown(path, meta.u, meta.g);
                     }
 
-                    return 0;
+                    return t.result(0);
                 }
 
                 if (errno != ENOSPC) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
             }
             t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -errno;
+            return t.result(-errno);
+        }
+
+        int Abstract::xattrValue(const std::string &value, int err, char *buf, size_t count){
+            if(err != 0){
+                return -err;
+            }
+            if(count == 0){
+                return value.size();
+            }
+            if(value.size() > count){
+                return -ERANGE;
+            }
+            memcpy(buf, value.data(), value.size());
+            return value.size();
         }
 
         int Abstract::setxattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname,
                                const char *attrval, size_t attrvalsize, int flags){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
+            if (meta.readonly) {
+                return t.result(-EROFS);
+            }
+
+            this->xattrs.invalidate(file_name.string());
+
             try{
-                Abstract::VolumeInfo vinfo = this->findVolume(file_name);
+                Abstract::VolumeInfo vinfo;
+                int found = this->findVolume(file_name, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
+                this->config->changes.expect(file_name, IN_ATTRIB);
                 if(vinfo.volume->setxattr(vinfo.volumeRelativeFileName, attrname, attrval, attrvalsize, flags) == -1){
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
-                return 0;
+                return t.result(0);
             }
             catch(...){
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
             errno = ENOENT;
-            return -ENOENT;
+            return t.result(-ENOENT);
         }
         int Abstract::getxattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname, char *buf, size_t count){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
+            std::string path = file_name.string();
+            std::string value;
+            int err = 0;
+            if(this->xattrs.get(path, attrname, value, err)){
+                return t.result(this->xattrValue(value, err, buf, count));
+            }
+
             try{
-                Abstract::VolumeInfo vinfo = this->findVolume(file_name);
-                int size = vinfo.volume->getxattr(vinfo.volumeRelativeFileName, attrname, buf, count);
+                Abstract::VolumeInfo vinfo;
+                int found = this->findVolume(file_name, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
+                this->xattrs.validate(path, XattrCache::identity(vinfo.volume, vinfo.st));
+                if(this->xattrs.get(path, attrname, value, err)){
+                    return t.result(this->xattrValue(value, err, buf, count));
+                }
+
+                int size = vinfo.volume->getxattr(vinfo.volumeRelativeFileName, attrname, NULL, 0);
+                if(size > 0){
+                    value.resize(size);
+                    size = vinfo.volume->getxattr(vinfo.volumeRelativeFileName, attrname, &value[0], value.size());
+                }
                 if(size == -1){
-                    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    err = errno;
+                    // answers like "no such attribute" are cached as well - the value may have grown
+                    // between both calls though (ERANGE), so that one is simply passed on
+                    if(err != ERANGE){
+                        this->xattrs.put(path, attrname, std::string(), err);
+                    }
+                    return t.result(-err);
                 }
-                return size;
+                value.resize(size);
+                this->xattrs.put(path, attrname, value, 0);
+
+                return t.result(this->xattrValue(value, 0, buf, count));
             }
             catch(...){
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
             errno = ENOENT;
-            return -ENOENT;
+            return t.result(-ENOENT);
         }
         int Abstract::listxattr(MetaRequest meta, const boost::filesystem::path file_name, char *buf, size_t count){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
+            std::string path = file_name.string();
+            std::string list;
+            int err = 0;
+            if(this->xattrs.getList(path, list, err)){
+                return t.result(this->xattrValue(list, err, buf, count));
+            }
+
             try{
-                Abstract::VolumeInfo vinfo = this->findVolume(file_name);
-                int size = vinfo.volume->listxattr(vinfo.volumeRelativeFileName, buf, count);
+                Abstract::VolumeInfo vinfo;
+                int found = this->findVolume(file_name, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
+                this->xattrs.validate(path, XattrCache::identity(vinfo.volume, vinfo.st));
+                if(this->xattrs.getList(path, list, err)){
+                    return t.result(this->xattrValue(list, err, buf, count));
+                }
+
+                int size = vinfo.volume->listxattr(vinfo.volumeRelativeFileName, NULL, 0);
+                if(size > 0){
+                    list.resize(size);
+                    size = vinfo.volume->listxattr(vinfo.volumeRelativeFileName, &list[0], list.size());
+                }
                 if(size == -1){
+                    err = errno;
+                    if(err != ERANGE){
+                        this->xattrs.putList(path, std::string(), err);
+                    }
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-err);
                 }
-                return size;
+                list.resize(size);
+                this->xattrs.putList(path, list, 0);
+
+                return t.result(this->xattrValue(list, 0, buf, count));
             }
             catch(...){
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
             errno = ENOENT;
-            return -ENOENT;
+            return t.result(-ENOENT);
         }
         int Abstract::removexattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
+            if (meta.readonly) {
+                return t.result(-EROFS);
+            }
+
+            this->xattrs.invalidate(file_name.string());
+
             try{
-                Abstract::VolumeInfo vinfo = this->findVolume(file_name);
+                Abstract::VolumeInfo vinfo;
+                int found = this->findVolume(file_name, vinfo);
+                if (found != 0) {
+                    return t.result(found);
+                }
+                this->config->changes.expect(file_name, IN_ATTRIB);
                 if(vinfo.volume->removexattr(vinfo.volumeRelativeFileName, attrname) == -1){
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
-                return 0;
+                return t.result(0);
             }
             catch(...){
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
             errno = ENOENT;
-            return -ENOENT;
+            return t.result(-ENOENT);
         }
 
         int Abstract::create(MetaRequest meta, const boost::filesystem::path file, mode_t mode, struct ::fuse_file_info *fi){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
+            Abstract::VolumeInfo vinfo;
+            return t.result(this->createVolumeFile(meta, file, mode, fi, vinfo));
+        }
+        int Abstract::createVolumeFile(MetaRequest meta, const boost::filesystem::path file, mode_t mode, struct ::fuse_file_info *fi, VolumeInfo &vinfo){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
-            try {
-                this->findVolume(file);
-                // file exists
-            } catch (...) {
-                Abstract::VolumeInfo vinfo;
-                try {
-                    vinfo = this->getMaxFreeSpaceVolume(file);
-                } catch (...) {
-                    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-
-                    return -ENOSPC;
+            if (this->findVolume(file, vinfo) != 0) {
+                int res = this->getMaxFreeSpaceVolume(file, vinfo);
+                if (res != 0) {
+                    return t.result(res);
                 }
 
                 this->cloneParentDirsIntoVolume(vinfo.volume, vinfo.volumeRelativeFileName);
 
                 // file doesnt exist
+                this->config->changes.expect(file, IN_CREATE);
                 int fd = vinfo.volume->creat(vinfo.volumeRelativeFileName, mode);
                 if (fd == -1) {
-                    return -errno;
+                    return t.result(-errno);
                 }
                 try {
                     fi->fh = fd;
@@ -793,44 +962,46 @@ namespace Springy {
 
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-                    return -rval;
+                    return t.result(-rval);
                 }
-                return 0;
+                return t.result(0);
             }
 
-            return this->open(meta, file, fi);
+            return t.result(this->openVolumeFile(meta, file, fi, vinfo));
         }
         int Abstract::open(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_file_info *fi){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
+            Abstract::VolumeInfo vinfo;
+            return t.result(this->openVolumeFile(meta, file, fi, vinfo));
+        }
+        int Abstract::openVolumeFile(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_file_info *fi, VolumeInfo &vinfo){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
             if (meta.readonly && (fi->flags & O_RDONLY) != O_RDONLY) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             fi->fh = 0;
 
-            Abstract::VolumeInfo vinfo;
-
             try {
-                int fd = 0;
-                vinfo = this->findVolume(file);
-                fd = vinfo.volume->open(vinfo.volumeRelativeFileName, fi->flags);
-                if (fd == -1) {
-                    return -errno;
-                }
+                if (this->findVolume(file, vinfo) == 0) {
+                    int fd = vinfo.volume->open(vinfo.volumeRelativeFileName, fi->flags);
+                    if (fd == -1) {
+                        return t.result(-errno);
+                    }
 
-                fi->fh = fd;
+                    fi->fh = fd;
 
-                return 0;
+                    return t.result(0);
+                }
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
 
-            try {
-                vinfo = this->getMaxFreeSpaceVolume(file);
-            } catch (...) {
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -ENOSPC;
+            int res = this->getMaxFreeSpaceVolume(file, vinfo);
+            if (res != 0) {
+                return t.result(res);
             }
 
             this->cloneParentDirsIntoVolume(vinfo.volume, vinfo.volumeRelativeFileName);
@@ -839,7 +1010,7 @@ namespace Springy {
             fd = vinfo.volume->open(vinfo.volumeRelativeFileName, fi->flags);
 
             if (fd == -1) {
-                return -errno;
+                return t.result(-errno);
             }
 
             if (getuid() == 0) {
@@ -854,7 +1025,7 @@ namespace Springy {
 
             fi->fh = fd;
 
-            return 0;
+            return t.result(0);
         }
         int Abstract::release(MetaRequest meta, const boost::filesystem::path path, struct ::fuse_file_info *fi){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
@@ -862,18 +1033,19 @@ namespace Springy {
             int fd = fi->fh;
             if(fd < 0){
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
 
             Abstract::VolumeInfo vinfo;
             try {
-                vinfo = this->findVolume(path);
-                vinfo.volume->close(vinfo.volumeRelativeFileName, fd);
+                if (this->findVolume(path, vinfo) == 0) {
+                    vinfo.volume->close(vinfo.volumeRelativeFileName, fd);
+                }
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             }
 
-            return 0;
+            return t.result(0);
         }
         int Abstract::read(MetaRequest meta, const boost::filesystem::path file, char *buf, size_t count, off_t offset, struct ::fuse_file_info *fi){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
@@ -881,27 +1053,29 @@ namespace Springy {
             int fd = fi->fh;
             if(fd < 0){
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
 
             if (buf == NULL) {
-                return -EINVAL;
+                return t.result(-EINVAL);
             }
 
             Abstract::VolumeInfo vinfo;
             try {
-                vinfo = this->findVolume(file);
+                if (this->findVolume(file, vinfo) != 0) {
+                    return t.result(-EBADFD);
+                }
                 int res = vinfo.volume->read(vinfo.volumeRelativeFileName, fd, buf, count, offset);
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
 
-                return res;
+                return t.result(res);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
         }
         int Abstract::write(MetaRequest meta, const boost::filesystem::path file, const char *buf, size_t count, off_t offset, struct ::fuse_file_info *fi){
@@ -910,52 +1084,66 @@ namespace Springy {
             int fd = fi->fh;
             if(fd < 0){
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
 
             if (buf == NULL) {
-                return -EINVAL;
+                return t.result(-EINVAL);
             }
 
             Abstract::VolumeInfo vinfo;
             try {
-                vinfo = this->findVolume(file);
+                if (this->findVolume(file, vinfo) != 0) {
+                    return t.result(-EBADFD);
+                }
                 int res = vinfo.volume->write(vinfo.volumeRelativeFileName, fd, buf, count, offset);
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
 
-                return res;
+                return t.result(res);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
         }
+        int Abstract::fgetattr(MetaRequest meta, const boost::filesystem::path path, struct stat *buf, struct ::fuse_file_info *fi){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            return t.result(this->getattr(meta, path, buf));
+        }
+        int Abstract::flush(MetaRequest meta, const boost::filesystem::path path, struct ::fuse_file_info *fi){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            return t.result(0);
+        }
         int Abstract::ftruncate(MetaRequest meta, const boost::filesystem::path path, off_t size, struct ::fuse_file_info *fi){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             int fd = fi->fh;
             if(fd < 0){
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
 
             Abstract::VolumeInfo vinfo;
             try {
-                vinfo = this->findVolume(path);
+                if (this->findVolume(path, vinfo) != 0) {
+                    return t.result(-EBADFD);
+                }
                 int res = vinfo.volume->truncate(vinfo.volumeRelativeFileName, fd, size);
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
 
-                return res;
+                return t.result(res);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
         }
         int Abstract::fsync(MetaRequest meta, const boost::filesystem::path path, int isdatasync, struct ::fuse_file_info *fi){
@@ -964,23 +1152,25 @@ namespace Springy {
             int fd = fi->fh;
             if(fd < 0){
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
 
             Abstract::VolumeInfo vinfo;
             try {
-                vinfo = this->findVolume(path);
+                if (this->findVolume(path, vinfo) != 0) {
+                    return t.result(-EBADFD);
+                }
                 int res = vinfo.volume->fsync(vinfo.volumeRelativeFileName, fd);
                 if (res == -1) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
+                    return t.result(-errno);
                 }
 
-                return res;
+                return t.result(res);
             } catch (...) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
                 errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
         }
 
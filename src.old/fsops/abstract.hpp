@@ -21,6 +21,8 @@
 #include "../volume/ivolume.hpp"
 #include "../settings.hpp"
 #include "../libc/ilibc.hpp"
+#include "../nodetable.hpp"
+#include "xattrcache.hpp"
 
 namespace Springy{
     namespace FsOps{
@@ -39,9 +41,14 @@ namespace Springy{
                 Springy::Settings *config;
                 Springy::LibC::ILibC *libc;
 
-                virtual VolumeInfo findVolume(const boost::filesystem::path file_name) = 0;
-                virtual VolumeInfo getMaxFreeSpaceVolume(const boost::filesystem::path path) = 0;
-                virtual Springy::Volumes::VolumeRelativeFile getVolumesByVirtualFileName(const boost::filesystem::path file_name) = 0;
+                XattrCache xattrs;
+                static int xattrValue(const std::string &value, int err, char *buf, size_t count);
+
+                // a missing file is the common case of a union file system, so the
+                // lookups return 0 or -errno (-ENOENT, -ENOSPC) instead of throwing
+                virtual int findVolume(const boost::filesystem::path &file_name, VolumeInfo &vinfo) = 0;
+                virtual int getMaxFreeSpaceVolume(const boost::filesystem::path &path, VolumeInfo &vinfo) = 0;
+                virtual int getVolumesByVirtualFileName(const boost::filesystem::path &file_name, Springy::Volumes::VolumeRelativeFile &vols) = 0;
                 virtual int cloneParentDirsIntoVolume(Springy::Volume::IVolume *volume, const boost::filesystem::path path);
 
             public:
@@ -56,6 +63,36 @@ namespace Springy{
                     bool readonly;
                 };
 
+                // while a Hint exists, findVolume() of its path on the same thread tries the
+                // given location first instead of probing every volume (see NodeTable)
+                class Hint{
+                    public:
+                        const boost::filesystem::path path;
+                        const Springy::NodeTable::Location location;
+
+                        Hint(const boost::filesystem::path &path, const Springy::NodeTable::Location &location)
+                            : path(path), location(location), previous(Hint::current()){
+                            Hint::current() = this;
+                        }
+                        ~Hint(){
+                            Hint::current() = this->previous;
+                        }
+
+                        static const Hint*& current(){
+                            static thread_local const Hint *hint = NULL;
+                            return hint;
+                        }
+
+                    private:
+                        const Hint *previous;
+
+                        Hint(const Hint&);
+                        Hint& operator=(const Hint&);
+                };
+
+                // where the file is found, the location's generation is left to the caller
+                virtual int resolve(MetaRequest meta, const boost::filesystem::path file, Springy::NodeTable::Location &location, struct stat *buf);
+
                 virtual int getattr(MetaRequest meta, const boost::filesystem::path file_name, struct stat *buf);
                 virtual int truncate(MetaRequest meta, const boost::filesystem::path path, off_t size);
                 virtual int statfs(MetaRequest meta, const boost::filesystem::path path, struct statvfs *buf);
@@ -79,8 +116,10 @@ namespace Springy{
                 virtual int listxattr(MetaRequest meta, const boost::filesystem::path file_name, char *buf, size_t count);
                 virtual int removexattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname);
 
-                virtual int lock(MetaRequest meta, const boost::filesystem::path path, int fd, int cmd, struct ::flock *lck, const void *owner, size_t owner_len);
+                virtual int lock(MetaRequest meta, const boost::filesystem::path path, uint64_t fh, int cmd, struct ::flock *lck, const void *owner, size_t owner_len);
                 virtual int ftruncate(MetaRequest meta, const boost::filesystem::path path, off_t size, struct ::fuse_file_info *fi);
+                virtual int fgetattr(MetaRequest meta, const boost::filesystem::path path, struct stat *buf, struct ::fuse_file_info *fi);
+                virtual int flush(MetaRequest meta, const boost::filesystem::path path, struct ::fuse_file_info *fi);
 
                 virtual int create(MetaRequest meta, const boost::filesystem::path file, mode_t mode, struct ::fuse_file_info *fi);
                 virtual int open(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_file_info *fi);
@@ -88,6 +127,11 @@ namespace Springy{
                 virtual int read(MetaRequest meta, const boost::filesystem::path file, char *buf, size_t count, off_t offset, struct ::fuse_file_info *fi);
                 virtual int write(MetaRequest meta, const boost::filesystem::path file, const char *buf, size_t count, off_t offset, struct ::fuse_file_info *fi);
                 virtual int fsync(MetaRequest meta, const boost::filesystem::path path, int isdatasync, struct ::fuse_file_info *fi);
+
+            protected:
+                // open/create the file on its volume and report where it was found or created
+                virtual int createVolumeFile(MetaRequest meta, const boost::filesystem::path file, mode_t mode, struct ::fuse_file_info *fi, VolumeInfo &vinfo);
+                virtual int openVolumeFile(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_file_info *fi, VolumeInfo &vinfo);
         };
     }
 }
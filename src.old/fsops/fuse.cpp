@@ -1,46 +1,73 @@
 #include "fuse.hpp"
 
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <map>
+#include <vector>
+
 namespace Springy {
     namespace FsOps {
         
         Fuse::Fuse(Springy::Settings *config, Springy::LibC::ILibC *libc) : Abstract(config, libc){}
         Fuse::~Fuse(){}
 
-        Abstract::VolumeInfo Fuse::findVolume(const boost::filesystem::path file_name) {
+        int Fuse::findVolume(const boost::filesystem::path &file_name, Abstract::VolumeInfo &vinfo) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            Fuse::VolumeInfo vinfo;
+            const Abstract::Hint *hint = Abstract::Hint::current();
+            if (hint != NULL && hint->location.volume != NULL && hint->path == file_name) {
+                Springy::Volume::IVolume *volume = hint->location.volume;
+                Trace::tagVolume(volume);
+                if (volume->getattr(hint->location.volumeRelativeFileName, &vinfo.st) != -1) {
+                    vinfo.virtualMountPoint = hint->location.virtualMountPoint;
+                    vinfo.volumeRelativeFileName = hint->location.volumeRelativeFileName;
+                    vinfo.volume = volume;
+                    volume->statvfs(vinfo.volumeRelativeFileName, &vinfo.stvfs);
+                    return t.result(0);
+                }
+                // gone from there meanwhile, look everywhere
+            }
 
-            Springy::Volumes::VolumeRelativeFile vols = this->getVolumesByVirtualFileName(file_name);
+            Springy::Volumes::VolumeRelativeFile vols;
+            int res = this->getVolumesByVirtualFileName(file_name, vols);
+            if (res != 0) {
+                return t.result(res);
+            }
             vinfo.virtualMountPoint = vols.virtualMountPoint;
             vinfo.volumeRelativeFileName = vols.volumeRelativeFileName;
 
             std::set<Springy::Volume::IVolume*>::iterator it;
             for (it = vols.volumes.begin(); it != vols.volumes.end(); it++) {
                 Springy::Volume::IVolume *volume = *it;
+                Trace::tagVolume(volume);
                 if (volume->getattr(vols.volumeRelativeFileName, &vinfo.st) != -1) {
                     vinfo.volume = volume;
                     volume->statvfs(vols.volumeRelativeFileName, &vinfo.stvfs);
                     //vinfo.curspace = vinfo.buf.f_bsize * vinfo.buf.f_bavail;
 
-                    return vinfo;
+                    return t.result(0);
                 }
             }
 
-            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "file not found";
+            return t.result(-ENOENT);
         }
 
-        Abstract::VolumeInfo Fuse::getMaxFreeSpaceVolume(const boost::filesystem::path path) {
+        int Fuse::getMaxFreeSpaceVolume(const boost::filesystem::path &path, Abstract::VolumeInfo &vinfo) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            Springy::Volumes::VolumeRelativeFile vols = this->getVolumesByVirtualFileName(path);
+            Springy::Volumes::VolumeRelativeFile vols;
+            int res = this->getVolumesByVirtualFileName(path, vols);
+            if (res != 0) {
+                return t.result(-ENOSPC);
+            }
 
-            Fuse::VolumeInfo vinfo;
             vinfo.virtualMountPoint = vols.virtualMountPoint;
             vinfo.volumeRelativeFileName = vols.volumeRelativeFileName;
 
             Springy::Volume::IVolume* maxFreeSpaceVolume = NULL;
-            struct statvfs stat;
 
             uintmax_t space = 0;
 
@@ -49,8 +76,11 @@ namespace Springy {
                 Springy::Volume::IVolume *volume = *it;
                 struct statvfs stvfs;
 
-                volume->statvfs(vols.volumeRelativeFileName, &stvfs);
-                uintmax_t curspace = stat.f_bsize * stat.f_bavail;
+                // the file itself may not exist yet, the volume's root tells the free space as well
+                if (volume->statvfs(boost::filesystem::path("/"), &stvfs) != 0) {
+                    continue;
+                }
+                uintmax_t curspace = (uintmax_t) stvfs.f_frsize * stvfs.f_bavail;
 
                 if (maxFreeSpaceVolume == NULL || curspace > space) {
                     vinfo.volume = volume;
@@ -61,17 +91,17 @@ namespace Springy {
                     space = curspace;
                 }
             }
-            if (!maxFreeSpaceVolume) {
-                return vinfo;
+            if (maxFreeSpaceVolume) {
+                return t.result(0);
             }
 
-            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "no space";
+            return t.result(-ENOSPC);
         }
         
-        Springy::Volumes::VolumeRelativeFile Fuse::getVolumesByVirtualFileName(const boost::filesystem::path file_name){
+        int Fuse::getVolumesByVirtualFileName(const boost::filesystem::path &file_name, Springy::Volumes::VolumeRelativeFile &vols){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            return this->config->volumes.getVolumesByVirtualFileName(file_name);
+            return t.result(this->config->volumes.getVolumesByVirtualFileName(file_name, vols));
         }
         
 /*
@@ -85,14 +115,14 @@ namespace Springy {
 
                 // if not xattrs on source, then do nothing
                 if ((listsize = src->listxattr(path, NULL, 0)) == 0)
-                        return 0;
+                        return t.result(0);
 
                 // get all extended attributes
                 listbuf=(char *)this->libc->calloc(__LINE__, sizeof(char), listsize);
                 if (src->listxattr(path, listbuf, listsize) == -1)
                 {
                     Trace(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -1;
+                    return t.result(-1);
                 }
 
                 // loop through each xattr
@@ -108,7 +138,7 @@ namespace Springy {
                     if (attrvalsize < 0)
                     {
                         Trace(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                        return -1;
+                        return t.result(-1);
                     }
 
                     // get the value of the extended attribute
@@ -116,14 +146,14 @@ namespace Springy {
                     if (src->getxattr(path, name_begin, attrvalbuf, attrvalsize) < 0)
                     {
                         Trace(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                        return -1;
+                        return t.result(-1);
                     }
 
                     // set the value of the extended attribute on dest file
                     if (dst->setxattr(path, name_begin, attrvalbuf, attrvalsize, 0) < 0)
                     {
                         Trace(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                        return -1;
+                        return t.result(-1);
                     }
 
                     this->libc->free(__LINE__, attrvalbuf);
@@ -137,7 +167,7 @@ namespace Springy {
                 this->libc->free(__LINE__, listbuf);
 
 #endif
-            return 0;
+            return t.result(0);
         }
 
         void Fuse::reopen_files(const boost::filesystem::path file, const Springy::Volume::IVolume *volume) {
@@ -318,139 +348,171 @@ namespace Springy {
 */
         /////////////////// File descriptor operations ////////////////////////////////
 
+        void Fuse::account(MetaRequest meta, const boost::filesystem::path &file, const Abstract::VolumeInfo &vinfo, uint64_t fh) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            OpenFiles::Handle *h = this->config->openFiles.get(fh);
+            if (h == NULL) {
+                return;
+            }
+            h->account = this->config->accounting.account(vinfo.virtualMountPoint, vinfo.volume, file);
+            this->config->accounting.opened(h->account, meta.u);
+        }
+
+        bool Fuse::pageCache() {
+            return true;
+        }
+
         int Fuse::create(MetaRequest meta, const boost::filesystem::path file, mode_t mode, struct ::fuse_file_info *fi) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            int fd = Abstract::create(meta, file, mode, fi);
-            if(fd >= 0){
-                Abstract::VolumeInfo vinfo;
-                try {
-                    vinfo = this->findVolume(file);
-                    fi->fh = this->config->openFiles.add(vinfo.volumeRelativeFileName, vinfo.volume, fd, O_CREAT | O_WRONLY | O_TRUNC);
-                } catch (...) {
-                    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    errno = ENOENT;
-                    return -errno;
-                }
+            Abstract::VolumeInfo vinfo;
+            int res = this->createVolumeFile(meta, file, mode, fi, vinfo);
+            if(res != 0){
+                return t.result(res);
             }
 
-            return fd;
+            // fi->fh holds the volume descriptor until it is replaced by the open file handle
+            fi->fh = this->config->openFiles.add(vinfo.volumeRelativeFileName, vinfo.volume, fi->fh, fi->flags, mode, file);
+            this->account(meta, file, vinfo, fi->fh);
+
+            if (this->pageCache()) {
+                fi->direct_io = this->config->cachePolicy.directIo(file, vinfo.virtualMountPoint);
+                fi->keep_cache = 0;
+            }
+
+            return t.result(0);
         }
 
         int Fuse::open(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_file_info *fi) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            int fd = Abstract::open(meta, file, fi);
-            if(fd >= 0){
-                Abstract::VolumeInfo vinfo;
-                try {
-                    vinfo = this->findVolume(file);
-                    fi->fh = this->config->openFiles.add(vinfo.volumeRelativeFileName, vinfo.volume, fd, O_CREAT | O_WRONLY | O_TRUNC);
-                } catch (...) {
-                    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    errno = ENOENT;
-                    return -errno;
+            Abstract::VolumeInfo vinfo;
+            int res = this->openVolumeFile(meta, file, fi, vinfo);
+            if(res != 0){
+                return t.result(res);
+            }
+
+            fi->fh = this->config->openFiles.add(vinfo.volumeRelativeFileName, vinfo.volume, fi->fh, fi->flags, 0, file);
+            this->account(meta, file, vinfo, fi->fh);
+
+            if (this->pageCache()) {
+                if (this->config->cachePolicy.directIo(file, vinfo.virtualMountPoint)) {
+                    fi->direct_io = 1;
+                }
+                // vinfo.st was taken by findVolume right before opening, a file
+                // created or truncated by this open never matches
+                else if (S_ISREG(vinfo.st.st_mode) && !(fi->flags & (O_CREAT | O_TRUNC))) {
+                    fi->keep_cache = this->config->cachePolicy.keepCache(file, vinfo.virtualMountPoint, vinfo.st);
                 }
             }
 
-            return fd;
+            return t.result(0);
         }
 
-        int Fuse::release(MetaRequest meta, const boost::filesystem::path path, struct ::fuse_file_info *fi) {
+        int Fuse::opendir(MetaRequest meta, const boost::filesystem::path dirname, struct ::fuse_file_info *fi) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            int fd = fi->fh;
+            Springy::Volumes::VolumeRelativeFile vols;
+            int res = this->getVolumesByVirtualFileName(dirname, vols);
+            if (res != 0) {
+                return t.result(res);
+            }
+
+            // readdir watches every directory it lists, so a change behind
+            // springy's back drops the cached listing as well
+            if (this->pageCache() && this->config->cachePolicy.cacheListing(vols.virtualMountPoint)) {
+                fi->cache_readdir = 1;
+                fi->keep_cache = 1;
+            }
+
+            return t.result(0);
+        }
+
+        int Fuse::release(MetaRequest meta, const boost::filesystem::path path, struct ::fuse_file_info *fi) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            try {
-                OpenFiles::openFile of = this->config->openFiles.getByDescriptor(fd);
-                of.volume->close(path, of.fd);
-                this->config->openFiles.remove(fd);
-            } catch (...) {
-                if (errno == 0) {
-                    errno = EBADFD;
+            // what was written through the mount is in the kernel's cache already,
+            // closing the backing file must not invalidate it
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h != NULL && (h->flags & O_ACCMODE) != O_RDONLY) {
+                // the front end knows about renames since the open, the handle doesn't
+                const boost::filesystem::path &file = path.empty() ? h->virtualFile : path;
+                this->config->changes.expect(file, IN_CLOSE_WRITE);
+
+                // the page cache holds what was written, the next open may keep it
+                struct stat st;
+                std::shared_ptr<OpenFiles::Backing> b = h->backing();
+                if (this->pageCache() && !file.empty() && b->volume->fgetattr(h->volumeFile, b->fd, &st) == 0) {
+                    this->config->cachePolicy.served(file, st);
                 }
+            }
 
+            if (this->config->openFiles.remove(fi->fh) == -1) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-
-                return -errno;
+                return t.result(-errno);
             }
 
-            return 0;
+            return t.result(0);
         }
 
         int Fuse::read(MetaRequest meta, const boost::filesystem::path file, char *buf, size_t count, off_t offset, struct ::fuse_file_info *fi) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (buf == NULL) {
-                return -EINVAL;
+                return t.result(-EINVAL);
             }
 
-            int fd = fi->fh;
-            try {
-                OpenFiles::openFile of = this->config->openFiles.getByDescriptor(fd);
-
-                Springy::Volume::IVolume *volume = of.volume;
-                ssize_t res;
-                res = volume->read(of.volumeFile, of.fd, buf, count, offset);
-                if (res == -1) {
-                    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
-                }
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
 
-                return res;
-            } catch (...) {
+            ssize_t res = b->volume->read(h->volumeFile, b->fd, buf, count, offset);
+            this->config->accounting.read(h->account, meta.u, res);
+            if (res == -1) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                errno = EBADFD;
-                return -errno;
+                return t.result(-errno);
             }
+
+            return t.result(res);
         }
 
         int Fuse::write(MetaRequest meta, const boost::filesystem::path file, const char *buf, size_t count, off_t offset, struct ::fuse_file_info *fi) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
             if (buf == NULL) {
-                return -EINVAL;
+                return t.result(-EINVAL);
             }
 
-            ssize_t res;
-            int fd = fi->fh;
-
-            int *syncToken = NULL;
-            Springy::Volume::IVolume *volume;
-            boost::filesystem::path volumeFile;
-            int vfd;
-
-            try {
-                OpenFiles::openFile of = this->config->openFiles.getByDescriptor(fd);
-
-                syncToken  = of.syncToken;
-                volume     = of.volume;
-                volumeFile = of.volumeFile;
-                vfd        = of.fd;
-            } catch (...) {
-                if (errno == 0) {
-                    errno = EBADFD;
-                }
-                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__, "exception catched");
-                return -errno;
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
             }
+            // only overlapping writes are serialized. with O_APPEND pwrite ignores
+            // the offset, so such writes lock everything from 0 on
+            off_t lockStart = (h->flags & O_APPEND) ? 0 : offset;
+            off_t lockLength = (h->flags & O_APPEND) ? 0 : (count > 0 ? count : 1);
+            Springy::Util::RangeLock::Guard range(h->state->ranges, lockStart, lockLength);
 
-            Synchronized sync(syncToken);
+            // taken under the range, a relocation waited for by it replaced the descriptor
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
 
             errno = 0;
-            res = volume->write(volumeFile, vfd, buf, count, offset);
-            if ((res >= 0) || (res == -1 && errno != ENOSPC)) {
-                if (res == -1) {
-                    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
-                }
-                return res;
+            ssize_t res = b->volume->write(h->volumeFile, b->fd, buf, count, offset);
+            this->config->accounting.written(h->account, meta.u, res);
+            if (res == -1) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                return t.result(-errno);
             }
-            return -errno;
+            return t.result(res);
 
             //struct stat st;
             //volume->getattr(volumeFile, &st);
@@ -461,98 +523,520 @@ namespace Springy {
             //    this->move_file(fd, volumeFile, volume, (off_t) (offset + count) > st.st_size ? offset + count : st.st_size);
             //} catch (...) {
             //    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__, "exception catched");
-            //    return -errno;
+            //    return t.result(-errno);
             //}
 
             //res = this->libc->pwrite(__LINE__, fd, buf, count, offset);
             //if (res == -1) {
             //    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__, "write failed");
-            //    return -errno;
+            //    return t.result(-errno);
             //}
 
-            //return res;
+            //return t.result(res);
         }
 
-        int Fuse::ftruncate(MetaRequest meta, const boost::filesystem::path path, off_t size, struct fuse_file_info *fi) {
+        int Fuse::read_buf(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_bufvec **bufp, size_t count, off_t offset, struct ::fuse_file_info *fi) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if (bufp == NULL) {
+                return t.result(-EINVAL);
+            }
+
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
+
+            struct fuse_bufvec *src = (struct fuse_bufvec*) malloc(sizeof (struct fuse_bufvec));
+            if (src == NULL) {
+                return t.result(-ENOMEM);
+            }
+            *src = FUSE_BUFVEC_INIT(count);
+
+            int fd = b->volume->descriptor(h->volumeFile, b->fd);
+            if (fd >= 0) {
+                // libfuse reads an fd buffer only after read_buf returned, when a
+                // relocation may have closed the handle's descriptor already. the
+                // pages are moved into a pipe of this thread instead, libfuse moves
+                // them on from there
+                int pipeFd;
+                ssize_t filled = this->spliceReply(fd, offset, count, pipeFd);
+                if (filled >= 0) {
+                    src->buf[0].flags = FUSE_BUF_IS_FD;
+                    src->buf[0].fd = pipeFd;
+                    src->buf[0].size = filled;
+                    this->config->accounting.read(h->account, meta.u, filled);
+
+                    *bufp = src;
+                    return t.result(0);
+                }
+            }
+
+            void *mem = malloc(count > 0 ? count : 1);
+            if (mem == NULL) {
+                free(src);
+                return t.result(-ENOMEM);
+            }
+
+            ssize_t res = b->volume->read(h->volumeFile, b->fd, mem, count, offset);
+            this->config->accounting.read(h->account, meta.u, res);
+            if (res == -1) {
+                int err = errno;
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                free(mem);
+                free(src);
+                return t.result(-err);
+            }
+
+            src->buf[0].mem = mem;
+            src->buf[0].size = res;
+            *bufp = src;
+            return t.result(0);
+        }
+
+        namespace {
+            // the pipe read_buf replies of a worker thread go through
+            struct ReplyPipe {
+                Springy::LibC::ILibC *libc;
+                int fds[2];
+                size_t capacity;
+
+                ReplyPipe() : libc(NULL), capacity(0) {
+                    this->fds[0] = this->fds[1] = -1;
+                }
+                ~ReplyPipe() {
+                    this->reset();
+                }
+                void reset() {
+                    if (this->fds[0] != -1) {
+                        this->libc->close(__LINE__, this->fds[0]);
+                        this->libc->close(__LINE__, this->fds[1]);
+                    }
+                    this->fds[0] = this->fds[1] = -1;
+                    this->capacity = 0;
+                }
+            };
+        }
+
+        ssize_t Fuse::spliceReply(int fd, off_t offset, size_t count, int &pipeFd) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            static thread_local ReplyPipe rp;
+            rp.libc = this->libc;
+
+            // a reply that failed left its data behind, it must not precede the next one
+            int pending = 0;
+            if (rp.fds[0] != -1 && (this->libc->ioctl(__LINE__, rp.fds[0], FIONREAD, &pending) == -1 || pending != 0)) {
+                rp.reset();
+            }
+            if (rp.fds[0] == -1 && this->libc->pipe2(__LINE__, rp.fds, O_CLOEXEC) == -1) {
+                return t.result(-1);
+            }
+
+            // pipe buffers hold up to a page each, an unaligned range needs one more
+            size_t needed = count + 2 * getpagesize();
+            if (rp.capacity < needed) {
+                int capacity = this->libc->fcntl(__LINE__, rp.fds[1], F_SETPIPE_SZ, (int) needed);
+                if (capacity == -1) {
+                    // above /proc/sys/fs/pipe-max-size
+                    return t.result(-1);
+                }
+                rp.capacity = capacity;
+            }
+
+            loff_t pos = offset;
+            size_t filled = 0;
+            while (filled < count) {
+                ssize_t res = this->libc->splice(__LINE__, fd, &pos, rp.fds[1], NULL, count - filled, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (res == 0) {
+                    // end of file
+                    break;
+                }
+                if (res == -1) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    // the caller reads the whole range again
+                    rp.reset();
+                    return t.result(-1);
+                }
+                filled += res;
+            }
+
+            pipeFd = rp.fds[0];
+            return t.result(filled);
+        }
+
+        int Fuse::write_buf(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_bufvec *buf, off_t offset, struct ::fuse_file_info *fi) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
-            int fd = fi->fh;
-            try {
-                OpenFiles::openFile of = this->config->openFiles.getByDescriptor(fd);
+            if (buf == NULL) {
+                return t.result(-EINVAL);
+            }
 
-                if (of.volume->truncate(of.volumeFile, of.fd, size) == -1) {
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+            size_t count = fuse_buf_size(buf);
+
+            // same ranges as write(), the backing is taken under them as well
+            off_t lockStart = (h->flags & O_APPEND) ? 0 : offset;
+            off_t lockLength = (h->flags & O_APPEND) ? 0 : (count > 0 ? count : 1);
+            Springy::Util::RangeLock::Guard range(h->state->ranges, lockStart, lockLength);
+
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
+
+            int fd = b->volume->descriptor(h->volumeFile, b->fd);
+            if (fd >= 0) {
+                struct fuse_bufvec dst = FUSE_BUFVEC_INIT(count);
+                dst.buf[0].flags = (enum fuse_buf_flags) (FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+                dst.buf[0].fd = fd;
+                dst.buf[0].pos = offset;
+
+                // splices if buf is a pipe from /dev/fuse, falls back to pwrite otherwise
+                ssize_t res = fuse_buf_copy(&dst, buf, FUSE_BUF_SPLICE_NONBLOCK);
+                this->config->accounting.written(h->account, meta.u, res < 0 ? -1 : res);
+                if (res < 0) {
                     t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                    return -errno;
                 }
-                return 0;
-            } catch (...) {
+                return t.result(res);
             }
 
-            errno = -EBADFD;
-            t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return -errno;
+            // the volume wants a plain buffer
+            std::vector<char> mem(count > 0 ? count : 1);
+            struct fuse_bufvec tmp = FUSE_BUFVEC_INIT(count);
+            tmp.buf[0].mem = &mem[0];
+            ssize_t copied = fuse_buf_copy(&tmp, buf, (enum fuse_buf_copy_flags) 0);
+            if (copied < 0) {
+                return t.result(copied);
+            }
+
+            errno = 0;
+            ssize_t res = b->volume->write(h->volumeFile, b->fd, &mem[0], copied, offset);
+            this->config->accounting.written(h->account, meta.u, res);
+            if (res == -1) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                return t.result(-errno);
+            }
+            return t.result(res);
         }
 
-        int Fuse::fsync(MetaRequest meta, const boost::filesystem::path path, int isdatasync, struct fuse_file_info *fi) {
+        int Fuse::descriptor(struct ::fuse_file_info *fi) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                errno = EBADFD;
+                return t.result(-1);
+            }
+            // only valid while no relocation can happen (passthrough), the kernel takes its own reference
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            return t.result(b->volume->descriptor(h->volumeFile, b->fd));
+        }
+
+        int Fuse::ftruncate(MetaRequest meta, const boost::filesystem::path path, off_t size, struct fuse_file_info *fi) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             if (meta.readonly) {
-                return -EROFS;
+                return t.result(-EROFS);
             }
 
-            int fd = fi->fh;
-            try {
-                OpenFiles::openFile of = this->config->openFiles.getByDescriptor(fd);
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+            // waits for all writes in flight and keeps new ones out
+            Springy::Util::RangeLock::Guard range(h->state->ranges, 0, 0);
 
-                int res = 0;
-                res = of.volume->fsync(of.volumeFile, of.fd);
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
 
-                if (res == -1)
-                    return -errno;
-            } catch (...) {
-                errno = EBADFD;
+            int res = b->volume->truncate(h->volumeFile, b->fd, size);
+            this->config->accounting.other(h->account, meta.u, res);
+            if (res == -1) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+                return t.result(-errno);
+            }
+            return t.result(0);
+        }
+
+        int Fuse::fallocate(MetaRequest meta, const boost::filesystem::path path, int mode, off_t offset, off_t length, struct fuse_file_info *fi, bool relocate) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if (meta.readonly) {
+                return t.result(-EROFS);
             }
 
-            return 0;
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+
+            // holes and zeroed ranges must not interleave with writes, a relocation
+            // replaces the descriptors of every handle of the file
+            Springy::Util::RangeLock::Guard range(h->state->ranges, 0, 0);
+
+            if (relocate && !(mode & (FALLOC_FL_PUNCH_HOLE | FALLOC_FL_ZERO_RANGE | FALLOC_FL_COLLAPSE_RANGE | FALLOC_FL_INSERT_RANGE))) {
+                this->place(path, h, offset + length);
+            }
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
+
+            int res = b->volume->fallocate(h->volumeFile, b->fd, mode, offset, length);
+            this->config->accounting.other(h->account, meta.u, res);
+            if (res == -1) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                return t.result(-errno);
+            }
+            return t.result(0);
         }
 
-        int Fuse::lock(MetaRequest meta, const boost::filesystem::path path, int fd, int cmd, struct ::flock *lck, const void *owner, size_t owner_len){
+        ssize_t Fuse::copy_file_range(MetaRequest meta, const boost::filesystem::path pathIn, struct fuse_file_info *fiIn, off_t offIn,
+                                      const boost::filesystem::path pathOut, struct fuse_file_info *fiOut, off_t offOut, size_t len, int flags) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            try {
-                OpenFiles::openFile of = this->config->openFiles.getByDescriptor(fd);
+            if (meta.readonly) {
+                return t.result(-EROFS);
+            }
+            if (flags != 0) {
+                return t.result(-EINVAL);
+            }
 
-                int res = of.volume->lock(of.volumeFile, of.fd, cmd, lck, (const uint64_t*)owner);
-                if (res == -1)
-                    return -errno;
-            } catch (...) {
-                errno = EBADFD;
+            OpenFiles::Handle *in = this->config->openFiles.get(fiIn->fh);
+            OpenFiles::Handle *out = this->config->openFiles.get(fiOut->fh);
+            if (in == NULL || out == NULL) {
+                return t.result(-EBADFD);
+            }
+            Springy::Util::RangeLock::Guard range(out->state->ranges, offOut, len > 0 ? len : 1);
+
+            std::shared_ptr<OpenFiles::Backing> bIn = in->backing();
+            std::shared_ptr<OpenFiles::Backing> bOut = out->backing();
+            Trace::tagVolume(bOut->volume);
+
+            ssize_t res = -1;
+            errno = EXDEV;
+            if (bIn->volume == bOut->volume) {
+                res = bOut->volume->copy_file_range(in->volumeFile, bIn->fd, offIn, out->volumeFile, bOut->fd, offOut, len);
+            }
+            if (res == -1 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                // different volumes or file systems, splice if both have a kernel descriptor
+                int fdIn = bIn->volume->descriptor(in->volumeFile, bIn->fd);
+                int fdOut = bOut->volume->descriptor(out->volumeFile, bOut->fd);
+                if (fdIn < 0 || fdOut < 0) {
+                    return t.result(-EXDEV);
+                }
+
+                loff_t i = offIn, o = offOut;
+                res = this->libc->copy_file_range(__LINE__, fdIn, &i, fdOut, &o, len, 0);
+                if (res == -1 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                    res = this->spliceRange(fdIn, offIn, fdOut, offOut, len);
+                }
+            }
+
+            this->config->accounting.read(in->account, meta.u, res);
+            this->config->accounting.written(out->account, meta.u, res);
+            if (res == -1) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                return t.result(-errno);
+            }
+            return t.result(res);
+        }
+
+        ssize_t Fuse::spliceRange(int in, off_t offIn, int out, off_t offOut, size_t len) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            int p[2];
+            if (this->libc->pipe2(__LINE__, p, O_CLOEXEC) == -1) {
+                return t.result(-1);
+            }
+
+            loff_t i = offIn, o = offOut;
+            size_t copied = 0;
+            int err = 0;
+            while (copied < len && err == 0) {
+                ssize_t filled = this->libc->splice(__LINE__, in, &i, p[1], NULL, len - copied, SPLICE_F_MOVE);
+                if (filled <= 0) {
+                    err = filled == 0 ? 0 : errno;
+                    break;
+                }
+                // whatever is in the pipe has to reach out before the next round
+                for (ssize_t drained = 0; drained < filled;) {
+                    ssize_t res = this->libc->splice(__LINE__, p[0], NULL, out, &o, filled - drained, SPLICE_F_MOVE);
+                    if (res <= 0) {
+                        err = res == 0 ? EIO : errno;
+                        break;
+                    }
+                    drained += res;
+                    copied += res;
+                }
+            }
+
+            this->libc->close(__LINE__, p[0]);
+            this->libc->close(__LINE__, p[1]);
+
+            // a partial copy is reported as such, like write(2)
+            if (copied == 0 && err != 0) {
+                errno = err;
+                return t.result(-1);
+            }
+            return t.result(copied);
+        }
+
+        void Fuse::place(const boost::filesystem::path &file, OpenFiles::Handle *h, off_t size) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+
+            // only a new file, anything else would have to be copied (see move_file)
+            struct stat st;
+            if (b->volume->fgetattr(h->volumeFile, b->fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size != 0 || st.st_blocks != 0) {
+                return;
+            }
+
+            struct statvfs stvfs;
+            if (b->volume->statvfs(h->volumeFile, &stvfs) == 0 && (uintmax_t) stvfs.f_frsize * stvfs.f_bavail >= (uintmax_t) size) {
+                return;
+            }
+
+            Abstract::VolumeInfo to;
+            if (this->getMaxFreeSpaceVolume(file, to) != 0) {
+                return;
+            }
+            if (to.volume == b->volume || to.volumeRelativeFileName != h->volumeFile ||
+                (uintmax_t) to.stvfs.f_frsize * to.stvfs.f_bavail < (uintmax_t) size) {
+                return;
+            }
+
+            Springy::Volume::IVolume *from = b->volume;
+            boost::filesystem::path volumeFile = h->volumeFile;
+
+            this->cloneParentDirsIntoVolume(to.volume, volumeFile);
+
+            // the name stays the same, to the kernel nothing changed
+            this->config->changes.expect(file, IN_CREATE | IN_ATTRIB | IN_DELETE);
+
+            // one descriptor per handle, the first one creates the file
+            std::map<uint64_t, int> descriptors;
+            std::vector<uint64_t> ids = this->config->openFiles.handles(from, volumeFile);
+            int createFlags = O_CREAT | O_EXCL;
+            for (size_t i = 0; i < ids.size(); i++) {
+                OpenFiles::Handle *other = this->config->openFiles.get(ids[i]);
+                if (other == NULL) {
+                    continue;
+                }
+                int fd = to.volume->open(volumeFile, (other->flags & ~(O_CREAT | O_EXCL | O_TRUNC)) | createFlags, st.st_mode & 07777);
+                if (fd == -1) {
+                    break;
+                }
+                createFlags = 0;
+                descriptors[ids[i]] = fd;
+            }
+
+            if (descriptors.size() != ids.size() || this->config->openFiles.relocate(from, volumeFile, to.volume, descriptors) != 0) {
                 t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-                return -errno;
+                for (std::map<uint64_t, int>::iterator it = descriptors.begin(); it != descriptors.end(); it++) {
+                    to.volume->close(volumeFile, it->second);
+                }
+                if (!descriptors.empty()) {
+                    to.volume->unlink(volumeFile);
+                }
+                return;
             }
 
-            return 0;
+            to.volume->chown(volumeFile, st.st_uid, st.st_gid);
+            // requests still reading through the old descriptors keep them open until they are done
+            from->unlink(volumeFile);
         }
 
-        int Fuse::setxattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname,
-                             const char *attrval, size_t attrvalsize, int flags){
-            return -ENOTSUP;
+        int Fuse::fgetattr(MetaRequest meta, const boost::filesystem::path path, struct stat *buf, struct fuse_file_info *fi) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if (buf == NULL) {
+                return t.result(-EINVAL);
+            }
+
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
+
+            if (b->volume->fgetattr(h->volumeFile, b->fd, buf) == -1) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                return t.result(-errno);
+            }
+            return t.result(0);
         }
-        int Fuse::getxattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname, char *buf, size_t count){
-            return -ENOTSUP;
+
+        int Fuse::flush(MetaRequest meta, const boost::filesystem::path path, struct fuse_file_info *fi) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
+
+            int res = b->volume->flush(h->volumeFile, b->fd);
+            this->config->accounting.other(h->account, meta.u, res);
+            if (res == -1) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                return t.result(-errno);
+            }
+            return t.result(0);
         }
-        int Fuse::listxattr(MetaRequest meta, const boost::filesystem::path file_name, char *buf, size_t count){
-            return -ENOTSUP;
+
+        int Fuse::fsync(MetaRequest meta, const boost::filesystem::path path, int isdatasync, struct fuse_file_info *fi) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if (meta.readonly) {
+                return t.result(-EROFS);
+            }
+
+            OpenFiles::Handle *h = this->config->openFiles.get(fi->fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
+
+            int res = b->volume->fsync(h->volumeFile, b->fd);
+            this->config->accounting.other(h->account, meta.u, res);
+            if (res == -1) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                return t.result(-errno);
+            }
+
+            return t.result(0);
         }
-        int Fuse::removexattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname){
-            return -ENOTSUP;
+
+        int Fuse::lock(MetaRequest meta, const boost::filesystem::path path, uint64_t fh, int cmd, struct ::flock *lck, const void *owner, size_t owner_len){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            OpenFiles::Handle *h = this->config->openFiles.get(fh);
+            if (h == NULL) {
+                return t.result(-EBADFD);
+            }
+            std::shared_ptr<OpenFiles::Backing> b = h->backing();
+            Trace::tagVolume(b->volume);
+
+            if (b->volume->lock(h->volumeFile, b->fd, cmd, lck, (const uint64_t*)owner) == -1) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                return t.result(-errno);
+            }
+
+            return t.result(0);
         }
-        
+
     }
 }
\ No newline at end of file
@@ -7,11 +7,30 @@ namespace Springy{
     namespace FsOps{
         class Fuse : public Abstract{
             protected:
-                virtual Abstract::VolumeInfo findVolume(const boost::filesystem::path file_name);
-                virtual Abstract::VolumeInfo getMaxFreeSpaceVolume(const boost::filesystem::path path);
-                virtual Springy::Volumes::VolumeRelativeFile getVolumesByVirtualFileName(const boost::filesystem::path file_name);
+                virtual int findVolume(const boost::filesystem::path &file_name, Abstract::VolumeInfo &vinfo);
+                virtual int getMaxFreeSpaceVolume(const boost::filesystem::path &path, Abstract::VolumeInfo &vinfo);
+                virtual int getVolumesByVirtualFileName(const boost::filesystem::path &file_name, Springy::Volumes::VolumeRelativeFile &vols);
                 
                 void move_file(int fd, boost::filesystem::path file, Springy::Volume::IVolume *from, fsblkcnt_t wsize);
+                // moves a new, still empty file to the volume with the most free space
+                // if its own can't hold size bytes. the caller holds the whole file range lock
+                void place(const boost::filesystem::path &file, OpenFiles::Handle *h, off_t size);
+
+                // attaches the IOAccounting of the volume and mount point to a newly opened handle
+                void account(MetaRequest meta, const boost::filesystem::path &file, const Abstract::VolumeInfo &vinfo, uint64_t fh);
+
+                // copies len bytes between two kernel descriptors through a pipe,
+                // for files copy_file_range(2) can't copy between
+                ssize_t spliceRange(int in, off_t offIn, int out, off_t offOut, size_t len);
+
+                // moves count bytes at offset of fd into the calling thread's reply
+                // pipe, whose read end stays open as long as the thread. the bytes
+                // moved (less at the end of the file), -1 if the data has to be read
+                ssize_t spliceReply(int fd, off_t offset, size_t count, int &pipeFd);
+
+                // whether opened files end up in the kernel's page cache, which is
+                // when the CachePolicy applies (keep_cache, direct_io)
+                virtual bool pageCache();
 
             public:
                 Fuse(Springy::Settings *config, Springy::LibC::ILibC *libc);
@@ -20,20 +39,33 @@ namespace Springy{
                 virtual int create(MetaRequest meta, const boost::filesystem::path file, mode_t mode, struct ::fuse_file_info *fi);
                 virtual int open(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_file_info *fi);
                 virtual int release(MetaRequest meta, const boost::filesystem::path path, struct ::fuse_file_info *fi);
+                // lets the kernel keep the listing of dirname across opens (cache_readdir,
+                // keep_cache) if the CachePolicy allows, the ChangeNotifier invalidates it
+                virtual int opendir(MetaRequest meta, const boost::filesystem::path dirname, struct ::fuse_file_info *fi);
 
                 virtual int read(MetaRequest meta, const boost::filesystem::path file, char *buf, size_t count, off_t offset, struct ::fuse_file_info *fi);
                 virtual int write(MetaRequest meta, const boost::filesystem::path file, const char *buf, size_t count, off_t offset, struct ::fuse_file_info *fi);
+                // as read/write, but volumes with a local descriptor hand it to libfuse,
+                // which splices between /dev/fuse and the file. *bufp is malloc'ed and
+                // released by the caller
+                virtual int read_buf(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_bufvec **bufp, size_t count, off_t offset, struct ::fuse_file_info *fi);
+                virtual int write_buf(MetaRequest meta, const boost::filesystem::path file, struct ::fuse_bufvec *buf, off_t offset, struct ::fuse_file_info *fi);
+
+                // kernel descriptor of an open file, see IVolume::descriptor
+                int descriptor(struct ::fuse_file_info *fi);
 
-                virtual int lock(MetaRequest meta, const boost::filesystem::path path, int fd, int cmd, struct ::flock *lck, const void *owner, size_t owner_len);
+                virtual int lock(MetaRequest meta, const boost::filesystem::path path, uint64_t fh, int cmd, struct ::flock *lck, const void *owner, size_t owner_len);
 
                 virtual int fsync(MetaRequest meta, const boost::filesystem::path path, int isdatasync, struct fuse_file_info *fi);
                 virtual int ftruncate(MetaRequest meta, const boost::filesystem::path path, off_t size, struct fuse_file_info *fi);
-
-                virtual int setxattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname,
-                                     const char *attrval, size_t attrvalsize, int flags);
-                virtual int getxattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname, char *buf, size_t count);
-                virtual int listxattr(MetaRequest meta, const boost::filesystem::path file_name, char *buf, size_t count);
-                virtual int removexattr(MetaRequest meta, const boost::filesystem::path file_name, const std::string attrname);
+                // a preallocation of a new file may relocate it to a volume which can hold it, unless relocate is false
+                virtual int fallocate(MetaRequest meta, const boost::filesystem::path path, int mode, off_t offset, off_t length, struct fuse_file_info *fi, bool relocate=true);
+                // server side copy, within a volume by the volume itself, across local
+                // volumes by splicing. -EXDEV lets the kernel fall back to read/write
+                virtual ssize_t copy_file_range(MetaRequest meta, const boost::filesystem::path pathIn, struct fuse_file_info *fiIn, off_t offIn,
+                                                const boost::filesystem::path pathOut, struct fuse_file_info *fiOut, off_t offOut, size_t len, int flags);
+                virtual int fgetattr(MetaRequest meta, const boost::filesystem::path path, struct stat *buf, struct fuse_file_info *fi);
+                virtual int flush(MetaRequest meta, const boost::filesystem::path path, struct fuse_file_info *fi);
         };
     }
 }
@@ -7,42 +7,50 @@ namespace Springy {
         Local::Local(Springy::Settings *config, Springy::LibC::ILibC *libc) : Fuse(config, libc){}
         Local::~Local(){}
 
+        // httpd clients read through their own volume's cache
+        bool Local::pageCache(){ return false; }
 
-        Abstract::VolumeInfo Local::findVolume(const boost::filesystem::path file_name) {
-            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            Abstract::VolumeInfo vinfo;
+        int Local::findVolume(const boost::filesystem::path &file_name, Abstract::VolumeInfo &vinfo) {
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            Springy::Volumes::VolumeRelativeFile vols = this->getVolumesByVirtualFileName(file_name);
+            Springy::Volumes::VolumeRelativeFile vols;
+            int res = this->getVolumesByVirtualFileName(file_name, vols);
+            if (res != 0) {
+                return t.result(res);
+            }
             vinfo.virtualMountPoint = vols.virtualMountPoint;
             vinfo.volumeRelativeFileName = vols.volumeRelativeFileName;
 
             std::set<Springy::Volume::IVolume*>::iterator it;
             for (it = vols.volumes.begin(); it != vols.volumes.end(); it++) {
                 Springy::Volume::IVolume *volume = *it;
+                Trace::tagVolume(volume);
                 if (volume->getattr(vols.volumeRelativeFileName, &vinfo.st) != -1 && volume->isLocal()) {
                     vinfo.volume = volume;
                     volume->statvfs(vols.volumeRelativeFileName, &vinfo.stvfs);
                     //vinfo.curspace = vinfo.buf.f_bsize * vinfo.buf.f_bavail;
 
-                    return vinfo;
+                    return t.result(0);
                 }
             }
 
-            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "file not found";
+            return t.result(-ENOENT);
         }
 
-        Abstract::VolumeInfo Local::getMaxFreeSpaceVolume(const boost::filesystem::path path) {
+        int Local::getMaxFreeSpaceVolume(const boost::filesystem::path &path, Abstract::VolumeInfo &vinfo) {
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            Springy::Volumes::VolumeRelativeFile vols = this->getVolumesByVirtualFileName(path);
+            Springy::Volumes::VolumeRelativeFile vols;
+            int res = this->getVolumesByVirtualFileName(path, vols);
+            if (res != 0) {
+                return t.result(-ENOSPC);
+            }
 
-            Abstract::VolumeInfo vinfo;
             vinfo.virtualMountPoint = vols.virtualMountPoint;
             vinfo.volumeRelativeFileName = vols.volumeRelativeFileName;
 
             Springy::Volume::IVolume* maxFreeSpaceVolume = NULL;
-            struct statvfs stat;
 
             uintmax_t space = 0;
 
@@ -51,8 +59,11 @@ namespace Springy {
                 Springy::Volume::IVolume *volume = *it;
                 struct statvfs stvfs;
 
-                volume->statvfs(vols.volumeRelativeFileName, &stvfs);
-                uintmax_t curspace = stat.f_bsize * stat.f_bavail;
+                // the file itself may not exist yet, the volume's root tells the free space as well
+                if (volume->statvfs(boost::filesystem::path("/"), &stvfs) != 0) {
+                    continue;
+                }
+                uintmax_t curspace = (uintmax_t) stvfs.f_frsize * stvfs.f_bavail;
 
                 if ((maxFreeSpaceVolume == NULL || curspace > space) && volume->isLocal()) {
                     vinfo.volume = volume;
@@ -64,32 +75,35 @@ namespace Springy {
                 }
             }
             if (maxFreeSpaceVolume) {
-                return vinfo;
+                return t.result(0);
             }
 
-            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "no space";
+            return t.result(-ENOSPC);
         }
 
-        Springy::Volumes::VolumeRelativeFile Local::getVolumesByVirtualFileName(const boost::filesystem::path file_name){
-            Springy::Volumes::VolumeRelativeFile vrel = this->config->volumes.getVolumesByVirtualFileName(file_name);
+        int Local::getVolumesByVirtualFileName(const boost::filesystem::path &file_name, Springy::Volumes::VolumeRelativeFile &vols){
+            int res = this->config->volumes.getVolumesByVirtualFileName(file_name, vols);
+            if(res != 0){
+                return res;
+            }
 
             std::set<Springy::Volume::IVolume*>::iterator vit, tmpit;
-            for(vit=vrel.volumes.begin();vit != vrel.volumes.end();){
+            for(vit=vols.volumes.begin();vit != vols.volumes.end();){
                 // remove non local volumes
                 if(!(*vit)->isLocal()){
                     tmpit = vit;
                     vit++;
-                    vrel.volumes.erase(tmpit);
+                    vols.volumes.erase(tmpit);
                     continue;
                 }
                 vit++;
             }
 
-            if(vrel.volumes.size() <= 0){
-                throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "file not found";
+            if(vols.volumes.size() <= 0){
+                return -ENOENT;
             }
 
-            return vrel;
+            return 0;
         }
     }
 }
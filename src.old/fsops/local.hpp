@@ -7,9 +7,10 @@ namespace Springy{
     namespace FsOps{
         class Local : public ::Springy::FsOps::Fuse{
             protected:
-                virtual Abstract::VolumeInfo findVolume(const boost::filesystem::path file_name);
-                virtual Abstract::VolumeInfo getMaxFreeSpaceVolume(const boost::filesystem::path path);
-                virtual Springy::Volumes::VolumeRelativeFile getVolumesByVirtualFileName(const boost::filesystem::path file_name);
+                virtual int findVolume(const boost::filesystem::path &file_name, Abstract::VolumeInfo &vinfo);
+                virtual int getMaxFreeSpaceVolume(const boost::filesystem::path &path, Abstract::VolumeInfo &vinfo);
+                virtual int getVolumesByVirtualFileName(const boost::filesystem::path &file_name, Springy::Volumes::VolumeRelativeFile &vols);
+                virtual bool pageCache();
 
             public:
                 Local(Springy::Settings *config, Springy::LibC::ILibC *libc);
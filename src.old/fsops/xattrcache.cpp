@@ -0,0 +1,148 @@
+#include "xattrcache.hpp"
+
+#include <chrono>
+#include <functional>
+
+namespace Springy{
+    namespace FsOps{
+        XattrCache::XattrCache(size_t capacity, unsigned int ttl){
+            this->capacity = capacity / XattrCache::numShards;
+            this->ttl = ttl;
+            for(size_t i=0;i<XattrCache::numShards;i++){
+                this->shards.push_back(new Shard());
+            }
+        }
+        XattrCache::~XattrCache(){
+            for(size_t i=0;i<this->shards.size();i++){
+                delete this->shards[i];
+            }
+        }
+
+        uint64_t XattrCache::now(){
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        XattrCache::Identity XattrCache::identity(Springy::Volume::IVolume *volume, const struct stat &st){
+            Identity id;
+            id.volume = volume;
+            id.dev = st.st_dev;
+            id.ino = st.st_ino;
+            id.ctime = st.st_ctim;
+            return id;
+        }
+
+        XattrCache::Shard& XattrCache::shard(const std::string &path){
+            return *this->shards[std::hash<std::string>()(path) % this->shards.size()];
+        }
+
+        XattrCache::Entry* XattrCache::fresh(Shard &s, const std::string &path){
+            std::unordered_map<std::string, Entry>::iterator it = s.entries.find(path);
+            if(it == s.entries.end()){
+                return NULL;
+            }
+            if(XattrCache::now() - it->second.validated > this->ttl){
+                return NULL;
+            }
+            s.lru.splice(s.lru.begin(), s.lru, it->second.lru);
+            return &it->second;
+        }
+
+        bool XattrCache::get(const std::string &path, const std::string &attrname, std::string &value, int &err){
+            Shard &s = this->shard(path);
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            Entry *e = this->fresh(s, path);
+            if(e == NULL){
+                return false;
+            }
+            std::map<std::string, Value>::iterator it = e->attrs.find(attrname);
+            if(it == e->attrs.end()){
+                return false;
+            }
+            value = it->second.value;
+            err = it->second.err;
+            return true;
+        }
+        void XattrCache::put(const std::string &path, const std::string &attrname, const std::string &value, int err){
+            Shard &s = this->shard(path);
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            std::unordered_map<std::string, Entry>::iterator it = s.entries.find(path);
+            if(it == s.entries.end()){
+                // only entries bound to an inode by validate() are filled
+                return;
+            }
+            Value v = {value, err};
+            it->second.attrs[attrname] = v;
+        }
+
+        bool XattrCache::getList(const std::string &path, std::string &list, int &err){
+            Shard &s = this->shard(path);
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            Entry *e = this->fresh(s, path);
+            if(e == NULL || !e->listed){
+                return false;
+            }
+            list = e->list.value;
+            err = e->list.err;
+            return true;
+        }
+        void XattrCache::putList(const std::string &path, const std::string &list, int err){
+            Shard &s = this->shard(path);
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            std::unordered_map<std::string, Entry>::iterator it = s.entries.find(path);
+            if(it == s.entries.end()){
+                return;
+            }
+            it->second.listed = true;
+            it->second.list.value = list;
+            it->second.list.err = err;
+        }
+
+        void XattrCache::validate(const std::string &path, const Identity &id){
+            Shard &s = this->shard(path);
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            std::unordered_map<std::string, Entry>::iterator it = s.entries.find(path);
+            if(it == s.entries.end()){
+                while(s.entries.size() >= this->capacity && !s.lru.empty()){
+                    s.entries.erase(s.lru.back());
+                    s.lru.pop_back();
+                }
+                s.lru.push_front(path);
+
+                Entry e;
+                e.id = id;
+                e.listed = false;
+                e.lru = s.lru.begin();
+                it = s.entries.insert(std::make_pair(path, e)).first;
+            }
+            else{
+                s.lru.splice(s.lru.begin(), s.lru, it->second.lru);
+            }
+
+            Entry &e = it->second;
+            if(e.id.volume != id.volume || e.id.dev != id.dev || e.id.ino != id.ino ||
+               e.id.ctime.tv_sec != id.ctime.tv_sec || e.id.ctime.tv_nsec != id.ctime.tv_nsec){
+                e.id = id;
+                e.attrs.clear();
+                e.listed = false;
+            }
+            e.validated = XattrCache::now();
+        }
+
+        void XattrCache::invalidate(const std::string &path){
+            Shard &s = this->shard(path);
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            std::unordered_map<std::string, Entry>::iterator it = s.entries.find(path);
+            if(it == s.entries.end()){
+                return;
+            }
+            s.lru.erase(it->second.lru);
+            s.entries.erase(it);
+        }
+    }
+}
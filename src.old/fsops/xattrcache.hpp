@@ -0,0 +1,86 @@
+#ifndef SPRINGY_FSOPS_XATTRCACHE_HPP
+#define SPRINGY_FSOPS_XATTRCACHE_HPP
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../volume/ivolume.hpp"
+
+namespace Springy{
+    namespace FsOps{
+        /**
+         * extended attribute cache including negative entries
+         *
+         * the kernel asks for security.capability on every write, which nearly always
+         * answers ENODATA. entries are looked up by virtual path but are bound to the
+         * backend inode (volume, dev, ino) and its ctime - a setxattr/removexattr on
+         * the backing file changes ctime and drops everything cached for it.
+         * an entry validated within the last ttl milliseconds is answered without
+         * touching the volumes at all.
+         */
+        class XattrCache{
+            public:
+                struct Identity{
+                    Springy::Volume::IVolume *volume;
+                    dev_t dev;
+                    ino_t ino;
+                    struct timespec ctime;
+                };
+
+                XattrCache(size_t capacity = 65536, unsigned int ttl = 1000);
+                ~XattrCache();
+
+                // true if the value (or the error, e.g. ENODATA) of attrname is cached and fresh
+                bool get(const std::string &path, const std::string &attrname, std::string &value, int &err);
+                void put(const std::string &path, const std::string &attrname, const std::string &value, int err);
+
+                bool getList(const std::string &path, std::string &list, int &err);
+                void putList(const std::string &path, const std::string &list, int err);
+
+                // (re)binds the entry of path to the given inode and marks it fresh
+                void validate(const std::string &path, const Identity &id);
+                void invalidate(const std::string &path);
+
+                static Identity identity(Springy::Volume::IVolume *volume, const struct stat &st);
+
+            protected:
+                struct Value{
+                    std::string value;
+                    int err;
+                };
+                struct Entry{
+                    Identity id;
+                    uint64_t validated;
+                    std::map<std::string, Value> attrs;
+                    bool listed;
+                    Value list;
+                    std::list<std::string>::iterator lru;
+                };
+                struct Shard{
+                    std::mutex mutex;
+                    std::unordered_map<std::string, Entry> entries;
+                    std::list<std::string> lru;
+                };
+
+                static const size_t numShards = 16;
+
+                size_t capacity;
+                unsigned int ttl;
+                std::vector<Shard*> shards;
+
+                Shard& shard(const std::string &path);
+                Entry* fresh(Shard &s, const std::string &path);
+                static uint64_t now();
+        };
+    }
+}
+
+#endif
@@ -2,11 +2,14 @@
 
 #include "fuse.hpp"
 
+#include <fuse_lowlevel.h>
+
 #include "util/synchronized.hpp"
 #include "exception.hpp"
 #include "trace.hpp"
 
 #include <errno.h>
+#include <stdlib.h>
 #include <pthread.h>
 #include <signal.h>
 #include <sys/types.h>
@@ -27,6 +30,8 @@ namespace Springy {
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
         this->fuse = NULL;
+        this->connOptions = NULL;
+        this->loopConfig = NULL;
         this->config = NULL;
         this->libc = NULL;
         this->readonly = false;
@@ -50,6 +55,7 @@ namespace Springy {
 
         this->fops.getattr = Fuse::getattr;
         this->fops.statfs = Fuse::statfs;
+        this->fops.opendir = Fuse::opendir;
         this->fops.readdir = Fuse::readdir;
         this->fops.readlink = Fuse::readlink;
 
@@ -59,8 +65,10 @@ namespace Springy {
 
         this->fops.read = Fuse::read;
         this->fops.write = Fuse::write;
+        this->fops.read_buf = Fuse::read_buf;
+        this->fops.write_buf = Fuse::write_buf;
         this->fops.truncate = Fuse::truncate;
-        this->fops.ftruncate = Fuse::ftruncate;
+        this->fops.flush = Fuse::flush;
         this->fops.access = Fuse::access;
         this->fops.mkdir = Fuse::mkdir;
         this->fops.rmdir = Fuse::rmdir;
@@ -72,6 +80,8 @@ namespace Springy {
         this->fops.symlink = Fuse::symlink;
         this->fops.mknod = Fuse::mknod;
         this->fops.fsync = Fuse::fsync;
+        this->fops.fallocate = Fuse::fallocate;
+        this->fops.copy_file_range = Fuse::copy_file_range;
         this->fops.link = Fuse::link;
 
         this->fops.lock = Fuse::lock;
@@ -83,18 +93,12 @@ namespace Springy {
         this->fops.removexattr = Fuse::removexattr;
 #endif
 
-        //int(* 	opendir )(const char *, struct fuse_file_info *)
         //int(* 	releasedir )(const char *, struct fuse_file_info *)
         //int(* 	fsyncdir )(const char *, int, struct fuse_file_info *)
-        //int(* 	fgetattr )(const char *, struct stat *, struct fuse_file_info *)
-        //int(* 	lock )(const char *, struct fuse_file_info *, int cmd, struct flock *)
         //int(* 	bmap )(const char *, size_t blocksize, uint64_t *idx)
         //int(* 	ioctl )(const char *, int cmd, void *arg, struct fuse_file_info *, unsigned int flags, void *data)
         //int(* 	poll )(const char *, struct fuse_file_info *, struct fuse_pollhandle *ph, unsigned *reventsp)
-        //int(* 	write_buf )(const char *, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *)
-        //int(* 	read_buf )(const char *, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *)
         //int(* 	flock )(const char *, struct fuse_file_info *, int op)
-        //int(* 	fallocate )(const char *, int, off_t, off_t, struct fuse_file_info *)
 
         return *this;
     }
@@ -106,16 +110,8 @@ namespace Springy {
 
         this->singleThreaded = singleThreaded;
 
-        this->fmountpoint = NULL; // the mountpoint is encoded within fuseArgv!
-        int multithreaded = (int) this->singleThreaded;
-
         std::vector<const char*> fuseArgv;
         fuseArgv.push_back(this->fsname);
-        fuseArgv.push_back(this->mountpoint.c_str());
-        if (this->singleThreaded) {
-            fuseArgv.push_back("-s");
-        }
-        fuseArgv.push_back("-f");
 
         this->readonly = (this->config->options.find("ro") != this->config->options.end());
 
@@ -124,14 +120,45 @@ namespace Springy {
             fuseArgv.push_back("-o");
             fuseArgv.push_back(this->fuseoptions.c_str());
         }
+        fuseArgv.push_back(NULL);
+
+        struct fuse_args args = FUSE_ARGS_INIT((int) fuseArgv.size() - 1, (char**) &fuseArgv[0]);
 
-        this->fuse = fuse_setup(fuseArgv.size(), (char**) &fuseArgv[0], &this->fops, sizeof (this->fops),
-                &this->fmountpoint, &multithreaded, static_cast<void*> (this));
+        // takes the connection options out of args, fuse_new doesn't know them
+        this->connOptions = fuse_parse_conn_info_opts(&args);
+        if (this->connOptions == NULL) {
+            fuse_opt_free_args(&args);
+            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "invalid fuse options given";
+        }
+
+        this->fuse = fuse_new(&args, &this->fops, sizeof (this->fops), static_cast<void*> (this));
+        fuse_opt_free_args(&args);
         if (this->fuse == NULL) {
             // fuse failed!
+            free(this->connOptions);
+            this->connOptions = NULL;
             throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "initializing fuse failed";
         }
 
+        if (fuse_mount(this->fuse, this->mountpoint.c_str()) != 0) {
+            fuse_destroy(this->fuse);
+            this->fuse = NULL;
+            free(this->connOptions);
+            this->connOptions = NULL;
+            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "mounting fuse failed";
+        }
+
+        this->config->changes.subscribe(this, std::bind(&Fuse::invalidate, this, std::placeholders::_1, std::placeholders::_2));
+
+        this->loopConfig = fuse_loop_cfg_create();
+        fuse_loop_cfg_set_clone_fd(this->loopConfig, 1);
+        if (this->config->fuseMaxThreads > 0) {
+            fuse_loop_cfg_set_max_threads(this->loopConfig, this->config->fuseMaxThreads);
+        }
+        if (this->config->fuseMaxIdleThreads > 0) {
+            fuse_loop_cfg_set_idle_threads(this->loopConfig, this->config->fuseMaxIdleThreads);
+        }
+
         return *this;
     }
 
@@ -148,7 +175,9 @@ namespace Springy {
 
         this->withinTearDown = true;
 
-        if (this->fuse && !fuse_exited(this->fuse)) {
+        this->config->changes.unsubscribe(this);
+
+        if (this->fuse && !fuse_session_exited(fuse_get_session(this->fuse))) {
             fuse_exit(this->fuse);
         }
 
@@ -161,7 +190,7 @@ namespace Springy {
             // or during runtime or maybe after an unhandled exception
             // the price to pay is that read(internal_fuse_fd) is blocking and the following stat
             // causes an event which allow's above's fuse_exit to do its job
-            // the Fuse::thread method then calls fuse_teardown
+            // the Fuse::thread method then unmounts and destroys fuse
             struct stat buf;
             this->libc->stat(__LINE__, this->mountpoint.c_str(), &buf);
 
@@ -174,7 +203,13 @@ namespace Springy {
         }
 
         this->fuse = NULL;
-        this->fmountpoint = NULL;
+
+        free(this->connOptions);
+        this->connOptions = NULL;
+        if (this->loopConfig != NULL) {
+            fuse_loop_cfg_destroy(this->loopConfig);
+            this->loopConfig = NULL;
+        }
 
         delete this->operations;
         this->operations = NULL;
@@ -196,13 +231,14 @@ namespace Springy {
         pthread_sigmask(SIG_SETMASK, &set, NULL);
 
         if (instance->singleThreaded) {
-            fuse_loop_mt(instance->fuse);
-        } else {
             fuse_loop(instance->fuse);
+        } else {
+            fuse_loop_mt(instance->fuse, instance->loopConfig);
         }
 
         if (instance->fuse != NULL) {
-            fuse_teardown(instance->fuse, instance->fmountpoint);
+            fuse_unmount(instance->fuse);
+            fuse_destroy(instance->fuse);
         }
     }
 
@@ -223,21 +259,56 @@ namespace Springy {
 
     ////// static functions to forward function call to Fuse* instance
 
-    void* Fuse::init(struct fuse_conn_info *conn) {
+    void* Fuse::init(struct fuse_conn_info *conn, struct fuse_config *cfg) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
         struct fuse_context *ctx = fuse_get_context();
         Fuse *instance = static_cast<Fuse*> (ctx->private_data);
+
+        // asked for explicitly instead of relying on libfuse's defaults:
+        // splicing the descriptors of read_buf/write_buf, concurrent reads and
+        // direct io on one handle, lookups and readdirs in one directory in parallel
+        // and readdirplus, which answers the getattr after each entry of a listing
+        conn->want |= conn->capable & (FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE |
+                                       FUSE_CAP_ASYNC_READ | FUSE_CAP_ASYNC_DIO | FUSE_CAP_PARALLEL_DIROPS |
+                                       FUSE_CAP_READDIRPLUS | FUSE_CAP_READDIRPLUS_AUTO | FUSE_CAP_ATOMIC_O_TRUNC);
+
+        // -o writeback_cache, max_background=N, ... override the above
+        if (instance->connOptions != NULL) {
+            fuse_apply_conn_info_opts(instance->connOptions, conn);
+        }
+
+        if (instance->config->cacheTimeout > 0) {
+            cfg->entry_timeout = instance->config->cacheTimeout;
+            cfg->attr_timeout = instance->config->cacheTimeout;
+        }
+
         return instance;
     }
 
+    void Fuse::invalidate(const boost::filesystem::path &path, Springy::ChangeNotifier::Kind kind) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        if (this->withinTearDown || this->fuse == NULL) {
+            return;
+        }
+
+        // the high level api can only drop a node's attributes and data, a removed
+        // name goes away once the kernel revalidates it and getattr fails.
+        // -ENOENT just means the kernel doesn't know the path
+        fuse_invalidate_path(this->fuse, path.c_str());
+        if (kind == Springy::ChangeNotifier::ENTRY && path.has_parent_path()) {
+            fuse_invalidate_path(this->fuse, path.parent_path().c_str());
+        }
+    }
+
     void Fuse::destroy(void *arg) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
     }
 
-    int Fuse::getattr(const char *path, struct stat *buf) {
+    int Fuse::getattr(const char *path, struct stat *buf, struct fuse_file_info *fi) {
         std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
@@ -251,7 +322,10 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
 
-        return instance->operations->getattr(meta, boost::filesystem::path(path), buf);
+        if (fi != NULL) {
+            return t.result(instance->operations->fgetattr(meta, boost::filesystem::path(path), buf, fi));
+        }
+        return t.result(instance->operations->getattr(meta, boost::filesystem::path(path), buf));
     }
 
     int Fuse::statfs(const char *path, struct statvfs *buf) {
@@ -268,11 +342,27 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
 
-        return instance->operations->statfs(meta, path, buf);
+        return t.result(instance->operations->statfs(meta, path, buf));
+    }
+
+    int Fuse::opendir(const char *dirname, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        struct fuse_context *ctx = fuse_get_context();
+        Fuse *instance = static_cast<Fuse*> (ctx->private_data);
+        if (instance->withinTearDown) {
+            return -ENOENT;
+        }
+
+        Springy::FsOps::Abstract::MetaRequest meta;
+        meta.readonly = instance->readonly;
+        instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
+
+        return t.result(instance->operations->opendir(meta, boost::filesystem::path(dirname), fi));
     }
 
     int Fuse::readdir(const char *dirname, void *buf, fuse_fill_dir_t filler,
-            off_t offset, struct fuse_file_info * fi) {
+            off_t offset, struct fuse_file_info * fi, enum fuse_readdir_flags flags) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
@@ -291,14 +381,16 @@ namespace Springy {
         int rval = instance->operations->readdir(meta, boost::filesystem::path(dirname), directories);
         
         if(rval == 0){
+            // the volumes stat'ed every entry anyway, with readdirplus the kernel caches them
+            enum fuse_fill_dir_flags fill = (flags & FUSE_READDIR_PLUS) ? FUSE_FILL_DIR_PLUS : (enum fuse_fill_dir_flags) 0;
             std::unordered_map<std::string, struct stat>::iterator dit;
             for (dit = directories.begin(); dit != directories.end(); dit++) {
-                if (filler(buf, dit->first.c_str(), &dit->second, 0))
+                if (filler(buf, dit->first.c_str(), &dit->second, 0, fill))
                     break;
             }
         }
 
-        return rval;
+        return t.result(rval);
     }
 
     int Fuse::readlink(const char *path, char *buf, size_t size) {
@@ -315,7 +407,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
 
-        return instance->operations->readlink(meta, boost::filesystem::path(path), buf, size);
+        return t.result(instance->operations->readlink(meta, boost::filesystem::path(path), buf, size));
     }
 
     int Fuse::create(const char *path, mode_t mode, struct fuse_file_info *fi) {
@@ -332,7 +424,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->create(meta, boost::filesystem::path(path), mode, fi);
+        return t.result(instance->operations->create(meta, boost::filesystem::path(path), mode, fi));
     }
 
     int Fuse::open(const char *path, struct fuse_file_info *fi) {
@@ -349,7 +441,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
 
-        return instance->operations->open(meta, boost::filesystem::path(path), fi);
+        return t.result(instance->operations->open(meta, boost::filesystem::path(path), fi));
     }
 
     int Fuse::release(const char *path, struct fuse_file_info *fi) {
@@ -366,7 +458,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->open(meta, boost::filesystem::path(path), fi);
+        return t.result(instance->operations->release(meta, boost::filesystem::path(path), fi));
     }
 
     int Fuse::read(const char *path, char *buf, size_t count, off_t offset, struct fuse_file_info *fi) {
@@ -383,7 +475,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->read(meta, path, buf, count, offset, fi);
+        return t.result(instance->operations->read(meta, path, buf, count, offset, fi));
     }
 
     int Fuse::write(const char *path, const char *buf, size_t count, off_t offset, struct fuse_file_info *fi) {
@@ -400,10 +492,42 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->write(meta, boost::filesystem::path(path), buf, count, offset, fi);
+        return t.result(instance->operations->write(meta, boost::filesystem::path(path), buf, count, offset, fi));
+    }
+
+    int Fuse::read_buf(const char *path, struct fuse_bufvec **bufp, size_t size, off_t offset, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        struct fuse_context *ctx = fuse_get_context();
+        Fuse *instance = static_cast<Fuse*> (ctx->private_data);
+        if (instance->withinTearDown) {
+            return -ENOENT;
+        }
+
+        Springy::FsOps::Abstract::MetaRequest meta;
+        meta.readonly = instance->readonly;
+        instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
+
+        return t.result(instance->operations->read_buf(meta, path, bufp, size, offset, fi));
     }
 
-    int Fuse::truncate(const char *path, off_t size) {
+    int Fuse::write_buf(const char *path, struct fuse_bufvec *buf, off_t offset, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        struct fuse_context *ctx = fuse_get_context();
+        Fuse *instance = static_cast<Fuse*> (ctx->private_data);
+        if (instance->withinTearDown) {
+            return -ENOENT;
+        }
+
+        Springy::FsOps::Abstract::MetaRequest meta;
+        meta.readonly = instance->readonly;
+        instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
+
+        return t.result(instance->operations->write_buf(meta, boost::filesystem::path(path), buf, offset, fi));
+    }
+
+    int Fuse::truncate(const char *path, off_t size, struct fuse_file_info *fi) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
@@ -417,10 +541,13 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->truncate(meta, boost::filesystem::path(path), size);
+        if (fi != NULL) {
+            return t.result(instance->operations->ftruncate(meta, boost::filesystem::path(path), size, fi));
+        }
+        return t.result(instance->operations->truncate(meta, boost::filesystem::path(path), size));
     }
 
-    int Fuse::ftruncate(const char *path, off_t size, struct fuse_file_info *fi) {
+    int Fuse::flush(const char *path, struct fuse_file_info *fi) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
@@ -429,12 +556,12 @@ namespace Springy {
         if (instance->withinTearDown) {
             return -ENOENT;
         }
-        
+
         Springy::FsOps::Abstract::MetaRequest meta;
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
 
-        return instance->operations->ftruncate(meta, boost::filesystem::path(path), size, fi);
+        return t.result(instance->operations->flush(meta, boost::filesystem::path(path), fi));
     }
 
     int Fuse::access(const char *path, int mask) {
@@ -451,7 +578,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->access(meta, boost::filesystem::path(path), mask);
+        return t.result(instance->operations->access(meta, boost::filesystem::path(path), mask));
     }
 
     int Fuse::mkdir(const char *path, mode_t mode) {
@@ -468,7 +595,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->mkdir(meta, boost::filesystem::path(path), mode);
+        return t.result(instance->operations->mkdir(meta, boost::filesystem::path(path), mode));
     }
 
     int Fuse::rmdir(const char *path) {
@@ -485,7 +612,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->rmdir(meta, path);
+        return t.result(instance->operations->rmdir(meta, path));
     }
 
     int Fuse::unlink(const char *path) {
@@ -502,10 +629,10 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->unlink(meta, path);
+        return t.result(instance->operations->unlink(meta, path));
     }
 
-    int Fuse::rename(const char *from, const char *to) {
+    int Fuse::rename(const char *from, const char *to, unsigned int flags) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
@@ -519,10 +646,15 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->rename(meta, boost::filesystem::path(from), boost::filesystem::path(to));
+        // RENAME_NOREPLACE and RENAME_EXCHANGE can't be done atomically across volumes
+        if (flags != 0) {
+            return t.result(-EINVAL);
+        }
+
+        return t.result(instance->operations->rename(meta, boost::filesystem::path(from), boost::filesystem::path(to)));
     }
 
-    int Fuse::utimens(const char *path, const struct timespec ts[2]) {
+    int Fuse::utimens(const char *path, const struct timespec ts[2], struct fuse_file_info *fi) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
@@ -536,10 +668,10 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->utimens(meta, boost::filesystem::path(path), ts);
+        return t.result(instance->operations->utimens(meta, boost::filesystem::path(path), ts));
     }
 
-    int Fuse::chmod(const char *path, mode_t mode) {
+    int Fuse::chmod(const char *path, mode_t mode, struct fuse_file_info *fi) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
@@ -553,10 +685,10 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->chmod(meta, boost::filesystem::path(path), mode);
+        return t.result(instance->operations->chmod(meta, boost::filesystem::path(path), mode));
     }
 
-    int Fuse::chown(const char *path, uid_t uid, gid_t gid) {
+    int Fuse::chown(const char *path, uid_t uid, gid_t gid, struct fuse_file_info *fi) {
         //std::cout << __FILE__ << ":" << __LINE__ << ":" << __PRETTY_FUNCTION__ << std::endl;
         Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
@@ -570,7 +702,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->chown(meta, boost::filesystem::path(path), uid, gid);
+        return t.result(instance->operations->chown(meta, boost::filesystem::path(path), uid, gid));
     }
 
     int Fuse::symlink(const char *from, const char *to) {
@@ -587,7 +719,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->symlink(meta, boost::filesystem::path(from), boost::filesystem::path(to));
+        return t.result(instance->operations->symlink(meta, boost::filesystem::path(from), boost::filesystem::path(to)));
     }
 
     int Fuse::link(const char *from, const char *to) {
@@ -604,7 +736,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->link(meta, boost::filesystem::path(from), boost::filesystem::path(to));
+        return t.result(instance->operations->link(meta, boost::filesystem::path(from), boost::filesystem::path(to)));
     }
 
     int Fuse::mknod(const char *path, mode_t mode, dev_t rdev) {
@@ -621,7 +753,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->mknod(meta, boost::filesystem::path(path), mode, rdev);
+        return t.result(instance->operations->mknod(meta, boost::filesystem::path(path), mode, rdev));
     }
 
     int Fuse::fsync(const char *path, int isdatasync, struct fuse_file_info *fi) {
@@ -638,7 +770,41 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->fsync(meta, boost::filesystem::path(path), isdatasync, fi);
+        return t.result(instance->operations->fsync(meta, boost::filesystem::path(path), isdatasync, fi));
+    }
+
+    int Fuse::fallocate(const char *path, int mode, off_t offset, off_t length, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        struct fuse_context *ctx = fuse_get_context();
+        Fuse *instance = static_cast<Fuse*> (ctx->private_data);
+        if (instance->withinTearDown) {
+            return -ENOENT;
+        }
+
+        Springy::FsOps::Abstract::MetaRequest meta;
+        meta.readonly = instance->readonly;
+        instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
+
+        return t.result(instance->operations->fallocate(meta, boost::filesystem::path(path), mode, offset, length, fi));
+    }
+
+    ssize_t Fuse::copy_file_range(const char *path_in, struct fuse_file_info *fi_in, off_t offset_in,
+                                  const char *path_out, struct fuse_file_info *fi_out, off_t offset_out, size_t size, int flags) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        struct fuse_context *ctx = fuse_get_context();
+        Fuse *instance = static_cast<Fuse*> (ctx->private_data);
+        if (instance->withinTearDown) {
+            return -ENOENT;
+        }
+
+        Springy::FsOps::Abstract::MetaRequest meta;
+        meta.readonly = instance->readonly;
+        instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
+
+        return t.result(instance->operations->copy_file_range(meta, boost::filesystem::path(path_in), fi_in, offset_in,
+                                                              boost::filesystem::path(path_out), fi_out, offset_out, size, flags));
     }
 
     int Fuse::lock(const char *path, struct fuse_file_info *fi, int cmd, struct flock *lck) {
@@ -655,7 +821,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->lock(meta, boost::filesystem::path(path), fi->fh, cmd, lck, &fi->lock_owner, sizeof(fi->lock_owner));
+        return t.result(instance->operations->lock(meta, boost::filesystem::path(path), fi->fh, cmd, lck, &fi->lock_owner, sizeof(fi->lock_owner)));
     }
 
     int Fuse::setxattr(const char *path, const char *attrname,
@@ -673,7 +839,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->setxattr(meta, boost::filesystem::path(path), attrname, attrval, attrvalsize, flags);
+        return t.result(instance->operations->setxattr(meta, boost::filesystem::path(path), attrname, attrval, attrvalsize, flags));
     }
 
     int Fuse::getxattr(const char *path, const char *attrname, char *buf, size_t count) {
@@ -690,7 +856,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->getxattr(meta, boost::filesystem::path(path), attrname, buf, count);
+        return t.result(instance->operations->getxattr(meta, boost::filesystem::path(path), attrname, buf, count));
     }
 
     int Fuse::listxattr(const char *path, char *buf, size_t count) {
@@ -707,7 +873,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->listxattr(meta, boost::filesystem::path(path), buf, count);
+        return t.result(instance->operations->listxattr(meta, boost::filesystem::path(path), buf, count));
     }
 
     int Fuse::removexattr(const char *path, const char *attrname) {
@@ -724,7 +890,7 @@ namespace Springy {
         meta.readonly = instance->readonly;
         instance->determineCaller(&meta.u, &meta.g, &meta.p, &meta.mask);
         
-        return instance->operations->removexattr(meta, boost::filesystem::path(path), attrname);
+        return t.result(instance->operations->removexattr(meta, boost::filesystem::path(path), attrname));
     }
 
 
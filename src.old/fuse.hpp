@@ -33,31 +33,37 @@ namespace Springy{
 
             ~Fuse();
 
-            static void* init(struct fuse_conn_info *conn);
+            static void* init(struct fuse_conn_info *conn, struct fuse_config *cfg);
             static void destroy(void *arg);
-            static int getattr(const char *file_name, struct stat *buf);
+            static int getattr(const char *file_name, struct stat *buf, struct fuse_file_info *fi);
             static int statfs(const char *path, struct statvfs *buf);
-            static int readdir(const char *dirname, void *buf, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info * fi);
+            static int opendir(const char *dirname, struct fuse_file_info *fi);
+            static int readdir(const char *dirname, void *buf, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info * fi, enum fuse_readdir_flags flags);
             static int readlink(const char *path, char *buf, size_t size);
             static int create(const char *file, mode_t mode, struct fuse_file_info *fi);
             static int open(const char *file, struct fuse_file_info *fi);
             static int release(const char *path, struct fuse_file_info *fi);
             static int read(const char *path, char *buf, size_t count, off_t offset, struct fuse_file_info *fi);
             static int write(const char *file, const char *buf, size_t count, off_t offset, struct fuse_file_info *fi);
-            static int truncate(const char *path, off_t size);
-            static int ftruncate(const char *path, off_t size, struct fuse_file_info *fi);
+            static int read_buf(const char *path, struct fuse_bufvec **bufp, size_t size, off_t offset, struct fuse_file_info *fi);
+            static int write_buf(const char *path, struct fuse_bufvec *buf, off_t offset, struct fuse_file_info *fi);
+            static int truncate(const char *path, off_t size, struct fuse_file_info *fi);
+            static int flush(const char *path, struct fuse_file_info *fi);
             static int access(const char *path, int mask);
             static int mkdir(const char *path, mode_t mode);
             static int rmdir(const char *path);
             static int unlink(const char *path);
-            static int rename(const char *from, const char *to);
-            static int utimens(const char *path, const struct timespec ts[2]);
-            static int chmod(const char *path, mode_t mode);
-            static int chown(const char *path, uid_t uid, gid_t gid);
+            static int rename(const char *from, const char *to, unsigned int flags);
+            static int utimens(const char *path, const struct timespec ts[2], struct fuse_file_info *fi);
+            static int chmod(const char *path, mode_t mode, struct fuse_file_info *fi);
+            static int chown(const char *path, uid_t uid, gid_t gid, struct fuse_file_info *fi);
             static int symlink(const char *from, const char *to);
             static int link(const char *from, const char *to);
             static int mknod(const char *path, mode_t mode, dev_t rdev);
             static int fsync(const char *path, int isdatasync, struct fuse_file_info *fi);
+            static int fallocate(const char *path, int mode, off_t offset, off_t length, struct fuse_file_info *fi);
+            static ssize_t copy_file_range(const char *path_in, struct fuse_file_info *fi_in, off_t offset_in,
+                                           const char *path_out, struct fuse_file_info *fi_out, off_t offset_out, size_t size, int flags);
             static int lock(const char *path, struct fuse_file_info *fi, int cmd, struct flock *lck);
             static int setxattr(const char *path, const char *attrname,
 				const char *attrval, size_t attrvalsize, int flags);
@@ -77,14 +83,21 @@ namespace Springy{
 
             static const char *fsname;
             boost::filesystem::path mountpoint;
-            char *fmountpoint;
             std::string fuseoptions;
             std::thread th;
 
             struct fuse_operations fops;
             struct fuse* fuse;
 
+            // -o writeback_cache, max_background, ... applied to the connection in init()
+            struct fuse_conn_info_opts *connOptions;
+            // worker pool of fuse_loop_mt, every worker reads its own clone of /dev/fuse
+            struct fuse_loop_config *loopConfig;
+
             void determineCaller(uid_t *u=NULL, gid_t *g=NULL, pid_t *p=NULL, mode_t *mask=NULL);
+
+            // ChangeNotifier listener while mounted
+            void invalidate(const boost::filesystem::path &path, Springy::ChangeNotifier::Kind kind);
     };
 
 }
@@ -0,0 +1,1185 @@
+#ifdef HAS_FUSE
+
+#include "fuselowlevel.hpp"
+
+#include "exception.hpp"
+#include "trace.hpp"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+
+#include <boost/algorithm/string/join.hpp>
+
+namespace Springy {
+
+    const char *FuseLowlevel::fsname = "springy";
+
+    FuseLowlevel::FuseLowlevel() {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        this->config = NULL;
+        this->libc = NULL;
+        this->operations = NULL;
+        this->readonly = false;
+        this->singleThreaded = false;
+        this->withinTearDown = false;
+        this->timeout = 1.0;
+        this->passthrough = false;
+        this->passthroughFailed = false;
+        this->pinWorkers = false;
+        this->nextCpu = 0;
+        this->session = NULL;
+        this->connOptions = NULL;
+        this->loopConfig = NULL;
+        memset(&this->lops, 0, sizeof(this->lops));
+    }
+
+    FuseLowlevel::~FuseLowlevel() {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+    }
+
+    FuseLowlevel& FuseLowlevel::init(Springy::Settings *config, Springy::LibC::ILibC *libc) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        if (config == NULL || libc == NULL) {
+            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "invalid argument given ";
+        }
+
+        this->config = config;
+        this->libc = libc;
+
+        this->operations = new Springy::FsOps::Fuse(config, libc);
+
+        this->lops.init = FuseLowlevel::init;
+        this->lops.destroy = FuseLowlevel::destroy;
+
+        this->lops.lookup = FuseLowlevel::lookup;
+        this->lops.forget = FuseLowlevel::forget;
+        this->lops.forget_multi = FuseLowlevel::forget_multi;
+        this->lops.getattr = FuseLowlevel::getattr;
+        this->lops.setattr = FuseLowlevel::setattr;
+        this->lops.readlink = FuseLowlevel::readlink;
+        this->lops.mknod = FuseLowlevel::mknod;
+        this->lops.mkdir = FuseLowlevel::mkdir;
+        this->lops.unlink = FuseLowlevel::unlink;
+        this->lops.rmdir = FuseLowlevel::rmdir;
+        this->lops.symlink = FuseLowlevel::symlink;
+        this->lops.rename = FuseLowlevel::rename;
+        this->lops.link = FuseLowlevel::link;
+
+        this->lops.open = FuseLowlevel::open;
+        this->lops.create = FuseLowlevel::create;
+        this->lops.read = FuseLowlevel::read;
+        this->lops.write = FuseLowlevel::write;
+        this->lops.write_buf = FuseLowlevel::write_buf;
+        this->lops.flush = FuseLowlevel::flush;
+        this->lops.release = FuseLowlevel::release;
+        this->lops.fsync = FuseLowlevel::fsync;
+        this->lops.fallocate = FuseLowlevel::fallocate;
+        this->lops.copy_file_range = FuseLowlevel::copy_file_range;
+
+        this->lops.opendir = FuseLowlevel::opendir;
+        this->lops.readdir = FuseLowlevel::readdir;
+        this->lops.releasedir = FuseLowlevel::releasedir;
+
+        this->lops.statfs = FuseLowlevel::statfs;
+        this->lops.access = FuseLowlevel::access;
+
+        this->lops.getlk = FuseLowlevel::getlk;
+        this->lops.setlk = FuseLowlevel::setlk;
+
+#ifndef WITHOUT_XATTR
+        this->lops.setxattr = FuseLowlevel::setxattr;
+        this->lops.getxattr = FuseLowlevel::getxattr;
+        this->lops.listxattr = FuseLowlevel::listxattr;
+        this->lops.removexattr = FuseLowlevel::removexattr;
+#endif
+
+        return *this;
+    }
+
+    FuseLowlevel& FuseLowlevel::setUp(bool singleThreaded, bool passthrough, bool pinWorkers) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+#ifdef FUSE_CAP_PASSTHROUGH
+        this->passthrough = passthrough;
+#else
+        if (passthrough) {
+            std::cerr << "fuse passthrough is not supported by this libfuse, continuing without" << std::endl;
+        }
+        this->passthrough = false;
+#endif
+
+        this->mountpoint = this->config->mountpoint;
+        this->singleThreaded = singleThreaded;
+        this->pinWorkers = pinWorkers && !singleThreaded;
+        this->timeout = this->config->cacheTimeout > 0 ? this->config->cacheTimeout : 1.0;
+        this->readonly = (this->config->options.find("ro") != this->config->options.end());
+
+        std::vector<const char*> fuseArgv;
+        fuseArgv.push_back(this->fsname);
+
+        this->fuseoptions = boost::algorithm::join(this->config->options, ",");
+        if (this->fuseoptions.size() > 0) {
+            fuseArgv.push_back("-o");
+            fuseArgv.push_back(this->fuseoptions.c_str());
+        }
+        fuseArgv.push_back(NULL);
+
+        struct fuse_args args = FUSE_ARGS_INIT((int) fuseArgv.size() - 1, (char**) &fuseArgv[0]);
+
+        this->connOptions = fuse_parse_conn_info_opts(&args);
+        if (this->connOptions == NULL) {
+            fuse_opt_free_args(&args);
+            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "invalid fuse options given";
+        }
+
+        this->session = fuse_session_new(&args, &this->lops, sizeof (this->lops), static_cast<void*> (this));
+        fuse_opt_free_args(&args);
+        if (this->session == NULL) {
+            free(this->connOptions);
+            this->connOptions = NULL;
+            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "initializing fuse failed";
+        }
+
+        if (fuse_session_mount(this->session, this->mountpoint.c_str()) != 0) {
+            fuse_session_destroy(this->session);
+            this->session = NULL;
+            free(this->connOptions);
+            this->connOptions = NULL;
+            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "mounting fuse failed";
+        }
+
+        this->config->changes.subscribe(this, std::bind(&FuseLowlevel::invalidate, this, std::placeholders::_1, std::placeholders::_2));
+
+        this->loopConfig = fuse_loop_cfg_create();
+        fuse_loop_cfg_set_clone_fd(this->loopConfig, 1);
+        if (this->config->fuseMaxThreads > 0) {
+            fuse_loop_cfg_set_max_threads(this->loopConfig, this->config->fuseMaxThreads);
+        }
+        if (this->config->fuseMaxIdleThreads > 0) {
+            fuse_loop_cfg_set_idle_threads(this->loopConfig, this->config->fuseMaxIdleThreads);
+        }
+        if (this->pinWorkers) {
+            if (!this->allowedCpus()) {
+                this->pinWorkers = false;
+            }
+            else {
+                // no idle worker exits, so none is started again on an already taken cpu
+                fuse_loop_cfg_set_max_threads(this->loopConfig, this->cpus.size());
+                fuse_loop_cfg_set_idle_threads(this->loopConfig, this->cpus.size());
+            }
+        }
+
+        return *this;
+    }
+
+    FuseLowlevel& FuseLowlevel::run() {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        this->th = std::thread(FuseLowlevel::thread, this);
+
+        return *this;
+    }
+
+    FuseLowlevel& FuseLowlevel::tearDown() {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        this->withinTearDown = true;
+
+        this->config->changes.unsubscribe(this);
+
+        if (this->session && !fuse_session_exited(this->session)) {
+            fuse_session_exit(this->session);
+        }
+
+        if (this->th.joinable()) {
+            // the loop blocks in read() on the fuse device, a request wakes it up
+            // (see Fuse::tearDown)
+            struct stat buf;
+            this->libc->stat(__LINE__, this->mountpoint.c_str(), &buf);
+
+            try {
+                this->th.join();
+            } catch (...) {
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+            }
+        }
+
+        this->session = NULL;
+
+        free(this->connOptions);
+        this->connOptions = NULL;
+        if (this->loopConfig != NULL) {
+            fuse_loop_cfg_destroy(this->loopConfig);
+            this->loopConfig = NULL;
+        }
+
+        delete this->operations;
+        this->operations = NULL;
+
+        this->withinTearDown = false;
+
+        return *this;
+    }
+
+    void FuseLowlevel::thread(FuseLowlevel *instance) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        sigset_t set;
+        // Block all signals in fuse thread - so all signals are delivered to another (main) thread
+        sigemptyset(&set);
+        sigfillset(&set);
+        pthread_sigmask(SIG_SETMASK, &set, NULL);
+
+        if (instance->singleThreaded) {
+            fuse_session_loop(instance->session);
+        } else {
+            fuse_session_loop_mt(instance->session, instance->loopConfig);
+        }
+
+        fuse_session_unmount(instance->session);
+        fuse_session_destroy(instance->session);
+    }
+
+    bool FuseLowlevel::allowedCpus() {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        this->cpus.clear();
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+            return false;
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                this->cpus.push_back(cpu);
+            }
+        }
+        return !this->cpus.empty();
+    }
+
+    void FuseLowlevel::pin() {
+        static thread_local bool pinned = false;
+        if (pinned) {
+            return;
+        }
+        pinned = true;
+
+        unsigned int n = this->nextCpu.fetch_add(1, std::memory_order_relaxed);
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(this->cpus[n % this->cpus.size()], &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+
+    FuseLowlevel* FuseLowlevel::instance(fuse_req_t req) {
+        FuseLowlevel *instance = static_cast<FuseLowlevel*> (fuse_req_userdata(req));
+        if (instance->pinWorkers) {
+            instance->pin();
+        }
+        return instance;
+    }
+
+    Springy::FsOps::Abstract::MetaRequest FuseLowlevel::meta(fuse_req_t req) {
+        Springy::FsOps::Abstract::MetaRequest meta;
+        const struct fuse_ctx *ctx = fuse_req_ctx(req);
+        meta.u = ctx->uid;
+        meta.g = ctx->gid;
+        meta.p = ctx->pid;
+        meta.mask = ctx->umask;
+        meta.readonly = this->readonly;
+        return meta;
+    }
+
+    bool FuseLowlevel::locate(fuse_req_t req, const Springy::FsOps::Abstract::MetaRequest &meta, fuse_ino_t ino,
+                              boost::filesystem::path &path, Springy::NodeTable::Location &location) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        if (this->withinTearDown) {
+            fuse_reply_err(req, ENOENT);
+            return false;
+        }
+
+        // taken before the path, a rename in between outdates what is resolved here
+        uint64_t renames = this->nodes.renames();
+        try {
+            path = this->nodes.path(ino);
+        } catch (...) {
+            fuse_reply_err(req, ENOENT);
+            return false;
+        }
+
+        uint64_t volumesGeneration = this->config->volumes.generation();
+        if (this->nodes.location(ino, volumesGeneration, location)) {
+            return true;
+        }
+
+        // volumes or names changed since the lookup, resolve once and remember it again
+        struct stat st;
+        if (this->operations->resolve(meta, path, location, &st) == 0) {
+            location.generation = volumesGeneration;
+            location.renames = renames;
+            this->nodes.relocate(ino, location);
+        } else {
+            location = Springy::NodeTable::Location();
+        }
+        return true;
+    }
+
+    int FuseLowlevel::entry(const Springy::FsOps::Abstract::MetaRequest &meta, fuse_ino_t parent, const std::string &name, struct fuse_entry_param &e) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        memset(&e, 0, sizeof(e));
+
+        uint64_t renames = this->nodes.renames();
+        boost::filesystem::path path;
+        try {
+            path = this->nodes.path(parent, name);
+        } catch (...) {
+            return -ENOENT;
+        }
+
+        Springy::NodeTable::Location location;
+        uint64_t volumesGeneration = this->config->volumes.generation();
+        int res = this->operations->resolve(meta, path, location, &e.attr);
+        if (res != 0) {
+            return res;
+        }
+        location.generation = volumesGeneration;
+        location.renames = renames;
+
+        e.ino = this->nodes.remember(parent, name, e.attr, location);
+        e.generation = 0; // ids are never reused
+        e.attr.st_ino = e.ino;
+        e.attr_timeout = this->timeout;
+        e.entry_timeout = this->timeout;
+        return 0;
+    }
+
+    void FuseLowlevel::invalidate(const boost::filesystem::path &path, Springy::ChangeNotifier::Kind kind) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        if (this->withinTearDown || this->session == NULL) {
+            return;
+        }
+
+        // paths the kernel never looked up have nothing cached
+        uint64_t id;
+        if (kind == Springy::ChangeNotifier::ENTRY) {
+            uint64_t parent;
+            if (!path.has_parent_path() || !this->nodes.find(path.parent_path(), parent)) {
+                return;
+            }
+            if (this->nodes.find(path, id)) {
+                // the name may resolve to another volume or to nothing now
+                this->nodes.relocate(id, Springy::NodeTable::Location());
+            }
+            std::string name = path.filename().string();
+            fuse_lowlevel_notify_inval_entry(this->session, parent, name.c_str(), name.size());
+            // the parent's data is its cached listing (cache_readdir)
+            fuse_lowlevel_notify_inval_inode(this->session, parent, 0, 0);
+            return;
+        }
+
+        if (this->nodes.find(path, id)) {
+            // a negative offset drops the attributes only, 0/0 the cached data too
+            fuse_lowlevel_notify_inval_inode(this->session, id, kind == Springy::ChangeNotifier::DATA ? 0 : -1, 0);
+        }
+    }
+
+    void FuseLowlevel::replyEntry(fuse_req_t req, int res, const struct fuse_entry_param &e) {
+        if (res != 0) {
+            fuse_reply_err(req, -res);
+        } else {
+            fuse_reply_entry(req, &e);
+        }
+    }
+
+    void FuseLowlevel::passthroughOpen(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+#ifdef FUSE_CAP_PASSTHROUGH
+        if (!this->passthrough || this->passthroughFailed) {
+            return;
+        }
+
+        // remote volumes have no descriptor, their handles stay on the normal path
+        int fd = this->operations->descriptor(fi);
+        if (fd < 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(this->backingLock);
+        std::unordered_map<fuse_ino_t, Backing>::iterator it = this->backings.find(ino);
+        if (it == this->backings.end()) {
+            int backingId = fuse_passthrough_open(req, fd);
+            if (backingId <= 0) {
+                // e.g. no CAP_SYS_ADMIN or a backing file system stacked too deep,
+                // which won't be different for the next file
+                if (!this->passthroughFailed.exchange(true)) {
+                    std::cerr << "registering a fuse passthrough backing file failed (" << strerror(errno) << "), continuing without" << std::endl;
+                }
+                return;
+            }
+            Backing backing;
+            backing.id = backingId;
+            backing.handles = 0;
+            it = this->backings.insert(std::make_pair(ino, backing)).first;
+        }
+        it->second.handles++;
+        this->backedHandles.insert(fi->fh);
+        fi->backing_id = it->second.id;
+#endif
+    }
+
+    void FuseLowlevel::passthroughRelease(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+#ifdef FUSE_CAP_PASSTHROUGH
+        if (!this->passthrough) {
+            return;
+        }
+
+        int backingId = 0;
+        {
+            std::lock_guard<std::mutex> lock(this->backingLock);
+            if (this->backedHandles.erase(fi->fh) == 0) {
+                return;
+            }
+            std::unordered_map<fuse_ino_t, Backing>::iterator it = this->backings.find(ino);
+            if (it == this->backings.end() || --it->second.handles > 0) {
+                return;
+            }
+            backingId = it->second.id;
+            this->backings.erase(it);
+        }
+        fuse_passthrough_close(req, backingId);
+#endif
+    }
+
+    ////// static functions to forward function call to FuseLowlevel* instance
+
+    void FuseLowlevel::init(void *userdata, struct fuse_conn_info *conn) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = static_cast<FuseLowlevel*> (userdata);
+
+        // same as Fuse::init, except readdirplus which isn't implemented here
+        conn->want |= conn->capable & (FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE |
+                                       FUSE_CAP_ASYNC_READ | FUSE_CAP_ASYNC_DIO | FUSE_CAP_PARALLEL_DIROPS |
+                                       FUSE_CAP_ATOMIC_O_TRUNC);
+        conn->want &= ~(FUSE_CAP_READDIRPLUS | FUSE_CAP_READDIRPLUS_AUTO);
+
+        if (instance->connOptions != NULL) {
+            fuse_apply_conn_info_opts(instance->connOptions, conn);
+        }
+
+#ifdef FUSE_CAP_PASSTHROUGH
+        if (instance->passthrough) {
+            if (conn->capable & FUSE_CAP_PASSTHROUGH) {
+                conn->want |= FUSE_CAP_PASSTHROUGH;
+            } else {
+                std::cerr << "the kernel doesn't offer fuse passthrough, continuing without" << std::endl;
+                instance->passthrough = false;
+            }
+        }
+#endif
+    }
+
+    void FuseLowlevel::destroy(void *userdata) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+    }
+
+    void FuseLowlevel::lookup(fuse_req_t req, fuse_ino_t parent, const char *name) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        if (instance->withinTearDown) {
+            fuse_reply_err(req, ENOENT);
+            return;
+        }
+
+        struct fuse_entry_param e;
+        int res = t.result(instance->entry(instance->meta(req), parent, name, e));
+        FuseLowlevel::replyEntry(req, res, e);
+    }
+
+    void FuseLowlevel::forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel::instance(req)->nodes.forget(ino, nlookup);
+        fuse_reply_none(req);
+    }
+
+    void FuseLowlevel::forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data *forgets) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        for (size_t i = 0; i < count; i++) {
+            instance->nodes.forget(forgets[i].ino, forgets[i].nlookup);
+        }
+        fuse_reply_none(req);
+    }
+
+    void FuseLowlevel::getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        struct stat st;
+        int res;
+        if (fi != NULL) {
+            res = instance->operations->fgetattr(meta, path, &st, fi);
+        } else {
+            res = instance->operations->getattr(meta, path, &st);
+        }
+        if (t.result(res) != 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        st.st_ino = ino;
+        fuse_reply_attr(req, &st, instance->timeout);
+    }
+
+    void FuseLowlevel::setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        int res = 0;
+        if (res == 0 && (to_set & FUSE_SET_ATTR_MODE)) {
+            res = instance->operations->chmod(meta, path, attr->st_mode);
+        }
+        if (res == 0 && (to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID))) {
+            uid_t uid = (to_set & FUSE_SET_ATTR_UID) ? attr->st_uid : (uid_t) -1;
+            gid_t gid = (to_set & FUSE_SET_ATTR_GID) ? attr->st_gid : (gid_t) -1;
+            res = instance->operations->chown(meta, path, uid, gid);
+        }
+        if (res == 0 && (to_set & FUSE_SET_ATTR_SIZE)) {
+            if (fi != NULL) {
+                res = instance->operations->ftruncate(meta, path, attr->st_size, fi);
+            } else {
+                res = instance->operations->truncate(meta, path, attr->st_size);
+            }
+        }
+        if (res == 0 && (to_set & (FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME | FUSE_SET_ATTR_ATIME_NOW | FUSE_SET_ATTR_MTIME_NOW))) {
+            struct timespec ts[2];
+            ts[0].tv_sec = 0;
+            ts[0].tv_nsec = UTIME_OMIT;
+            ts[1] = ts[0];
+            if (to_set & FUSE_SET_ATTR_ATIME_NOW) {
+                ts[0].tv_nsec = UTIME_NOW;
+            } else if (to_set & FUSE_SET_ATTR_ATIME) {
+                ts[0] = attr->st_atim;
+            }
+            if (to_set & FUSE_SET_ATTR_MTIME_NOW) {
+                ts[1].tv_nsec = UTIME_NOW;
+            } else if (to_set & FUSE_SET_ATTR_MTIME) {
+                ts[1] = attr->st_mtim;
+            }
+            res = instance->operations->utimens(meta, path, ts);
+        }
+
+        struct stat st;
+        if (res == 0) {
+            if (fi != NULL) {
+                res = instance->operations->fgetattr(meta, path, &st, fi);
+            } else {
+                res = instance->operations->getattr(meta, path, &st);
+            }
+        }
+        if (t.result(res) != 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        st.st_ino = ino;
+        fuse_reply_attr(req, &st, instance->timeout);
+    }
+
+    void FuseLowlevel::readlink(fuse_req_t req, fuse_ino_t ino) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        char buf[PATH_MAX + 1];
+        int res = t.result(instance->operations->readlink(meta, path, buf, sizeof(buf)));
+        if (res != 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        buf[PATH_MAX] = '\0';
+        fuse_reply_readlink(req, buf);
+    }
+
+    void FuseLowlevel::mknod(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, dev_t rdev) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, parent, path, location)) {
+            return;
+        }
+
+        struct fuse_entry_param e;
+        int res = instance->operations->mknod(meta, path / name, mode, rdev);
+        if (res == 0) {
+            res = instance->entry(meta, parent, name, e);
+        }
+        FuseLowlevel::replyEntry(req, t.result(res), e);
+    }
+
+    void FuseLowlevel::mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, parent, path, location)) {
+            return;
+        }
+
+        struct fuse_entry_param e;
+        int res = instance->operations->mkdir(meta, path / name, mode);
+        if (res == 0) {
+            res = instance->entry(meta, parent, name, e);
+        }
+        FuseLowlevel::replyEntry(req, t.result(res), e);
+    }
+
+    void FuseLowlevel::unlink(fuse_req_t req, fuse_ino_t parent, const char *name) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, parent, path, location)) {
+            return;
+        }
+
+        int res = t.result(instance->operations->unlink(meta, path / name));
+        if (res == 0) {
+            instance->nodes.unlinked(parent, name);
+        }
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::rmdir(fuse_req_t req, fuse_ino_t parent, const char *name) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, parent, path, location)) {
+            return;
+        }
+
+        int res = t.result(instance->operations->rmdir(meta, path / name));
+        if (res == 0) {
+            instance->nodes.unlinked(parent, name);
+        }
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::symlink(fuse_req_t req, const char *link, fuse_ino_t parent, const char *name) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, parent, path, location)) {
+            return;
+        }
+
+        struct fuse_entry_param e;
+        int res = instance->operations->symlink(meta, boost::filesystem::path(link), path / name);
+        if (res == 0) {
+            res = instance->entry(meta, parent, name, e);
+        }
+        FuseLowlevel::replyEntry(req, t.result(res), e);
+    }
+
+    void FuseLowlevel::rename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname, unsigned int flags) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        // see Fuse::rename
+        if (flags != 0) {
+            t.result(-EINVAL);
+            fuse_reply_err(req, EINVAL);
+            return;
+        }
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+
+        boost::filesystem::path from, to;
+        try {
+            from = instance->nodes.path(parent, name);
+            to = instance->nodes.path(newparent, newname);
+        } catch (...) {
+            fuse_reply_err(req, ENOENT);
+            return;
+        }
+
+        int res = t.result(instance->operations->rename(meta, from, to));
+        if (res == 0) {
+            instance->nodes.renamed(parent, name, newparent, newname);
+        }
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::link(fuse_req_t req, fuse_ino_t ino, fuse_ino_t newparent, const char *newname) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+
+        boost::filesystem::path to;
+        try {
+            to = instance->nodes.path(newparent, newname);
+        } catch (...) {
+            fuse_reply_err(req, ENOENT);
+            return;
+        }
+
+        struct fuse_entry_param e;
+        int res;
+        {
+            Springy::FsOps::Abstract::Hint hint(path, location);
+            res = instance->operations->link(meta, path, to);
+        }
+        if (res == 0) {
+            res = instance->entry(meta, newparent, newname, e);
+        }
+        FuseLowlevel::replyEntry(req, t.result(res), e);
+    }
+
+    void FuseLowlevel::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        int res = t.result(instance->operations->open(meta, path, fi));
+        if (res != 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        instance->passthroughOpen(req, ino, fi);
+        if (fuse_reply_open(req, fi) == -ENOENT) {
+            // the opening process was interrupted
+            instance->passthroughRelease(req, ino, fi);
+            instance->operations->release(meta, path, fi);
+        }
+    }
+
+    void FuseLowlevel::create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, parent, path, location)) {
+            return;
+        }
+        path /= name;
+
+        int res = instance->operations->create(meta, path, mode, fi);
+        if (t.result(res) != 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+
+        struct fuse_entry_param e;
+        res = instance->entry(meta, parent, name, e);
+        if (t.result(res) != 0) {
+            instance->operations->release(meta, path, fi);
+            fuse_reply_err(req, -res);
+            return;
+        }
+        instance->passthroughOpen(req, e.ino, fi);
+        if (fuse_reply_create(req, &e, fi) == -ENOENT) {
+            instance->passthroughRelease(req, e.ino, fi);
+            instance->operations->release(meta, path, fi);
+        }
+    }
+
+    void FuseLowlevel::read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        if (instance->withinTearDown) {
+            fuse_reply_err(req, ENOENT);
+            return;
+        }
+
+        // the handle knows its volume, no need to resolve the path
+        struct fuse_bufvec *buf = NULL;
+        int res = t.result(instance->operations->read_buf(instance->meta(req), boost::filesystem::path(), &buf, size, off, fi));
+        if (res < 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        fuse_reply_data(req, buf, FUSE_BUF_SPLICE_MOVE);
+
+        for (size_t i = 0; i < buf->count; i++) {
+            if (!(buf->buf[i].flags & FUSE_BUF_IS_FD)) {
+                free(buf->buf[i].mem);
+            }
+        }
+        free(buf);
+    }
+
+    void FuseLowlevel::write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t off, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        if (instance->withinTearDown) {
+            fuse_reply_err(req, ENOENT);
+            return;
+        }
+
+        int res = t.result(instance->operations->write(instance->meta(req), boost::filesystem::path(), buf, size, off, fi));
+        if (res < 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        fuse_reply_write(req, res);
+    }
+
+    void FuseLowlevel::write_buf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *bufv, off_t off, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        if (instance->withinTearDown) {
+            fuse_reply_err(req, ENOENT);
+            return;
+        }
+
+        int res = t.result(instance->operations->write_buf(instance->meta(req), boost::filesystem::path(), bufv, off, fi));
+        if (res < 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        fuse_reply_write(req, res);
+    }
+
+    void FuseLowlevel::flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        int res = t.result(instance->operations->flush(instance->meta(req), boost::filesystem::path(), fi));
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        instance->passthroughRelease(req, ino, fi);
+
+        // the kernel holds a lookup of an open file, so its node is known. the
+        // path tells the ChangeNotifier this close of a written file is springy's own
+        boost::filesystem::path path;
+        try {
+            path = instance->nodes.path(ino);
+        } catch (...) {
+            t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+        }
+
+        int res = t.result(instance->operations->release(instance->meta(req), path, fi));
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        int res = t.result(instance->operations->fsync(instance->meta(req), boost::filesystem::path(), datasync, fi));
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::fallocate(fuse_req_t req, fuse_ino_t ino, int mode, off_t offset, off_t length, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+
+        // the kernel keeps using the backing file of a passthrough handle, it must not be relocated
+        int res = t.result(instance->operations->fallocate(meta, path, mode, offset, length, fi, !instance->passthrough));
+        if (res == 0) {
+            // a preallocation may have moved the file to another volume
+            instance->nodes.relocate(ino, Springy::NodeTable::Location());
+        }
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::copy_file_range(fuse_req_t req, fuse_ino_t ino_in, off_t off_in, struct fuse_file_info *fi_in,
+                                       fuse_ino_t ino_out, off_t off_out, struct fuse_file_info *fi_out, size_t len, int flags) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        if (instance->withinTearDown) {
+            fuse_reply_err(req, ENOENT);
+            return;
+        }
+
+        ssize_t res = t.result(instance->operations->copy_file_range(instance->meta(req), boost::filesystem::path(), fi_in, off_in,
+                                                                     boost::filesystem::path(), fi_out, off_out, len, flags));
+        if (res < 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        fuse_reply_write(req, res);
+    }
+
+    void FuseLowlevel::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+
+        std::unordered_map<std::string, struct stat> directories;
+        int res = t.result(instance->operations->readdir(meta, path, directories));
+        if (res == 0) {
+            res = t.result(instance->operations->opendir(meta, path, fi));
+        }
+        if (res != 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+
+        // offsets handed out by readdir are indices into this snapshot
+        Listing *listing = new Listing(directories.begin(), directories.end());
+        fi->fh = (uint64_t) listing;
+        if (fuse_reply_open(req, fi) == -ENOENT) {
+            delete listing;
+        }
+    }
+
+    void FuseLowlevel::readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Listing *listing = (Listing*) fi->fh;
+        if (listing == NULL) {
+            fuse_reply_err(req, EBADF);
+            return;
+        }
+
+        std::vector<char> buf(size);
+        size_t used = 0;
+        for (size_t i = off; i < listing->size(); i++) {
+            size_t len = fuse_add_direntry(req, &buf[used], size - used, (*listing)[i].first.c_str(), &(*listing)[i].second, i + 1);
+            if (len > size - used) {
+                break;
+            }
+            used += len;
+        }
+        fuse_reply_buf(req, used > 0 ? &buf[0] : NULL, used);
+    }
+
+    void FuseLowlevel::releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        delete (Listing*) fi->fh;
+        fi->fh = 0;
+        fuse_reply_err(req, 0);
+    }
+
+    void FuseLowlevel::statfs(fuse_req_t req, fuse_ino_t ino) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        struct statvfs buf;
+        int res = t.result(instance->operations->statfs(meta, path, &buf));
+        if (res != 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        fuse_reply_statfs(req, &buf);
+    }
+
+    void FuseLowlevel::setxattr(fuse_req_t req, fuse_ino_t ino, const char *name, const char *value, size_t size, int flags) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        int res = t.result(instance->operations->setxattr(meta, path, name, value, size, flags));
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::getxattr(fuse_req_t req, fuse_ino_t ino, const char *name, size_t size) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        std::vector<char> buf(size);
+        int res = t.result(instance->operations->getxattr(meta, path, name, size > 0 ? &buf[0] : NULL, size));
+        if (res < 0) {
+            fuse_reply_err(req, -res);
+        } else if (size == 0) {
+            fuse_reply_xattr(req, res);
+        } else {
+            fuse_reply_buf(req, &buf[0], res);
+        }
+    }
+
+    void FuseLowlevel::listxattr(fuse_req_t req, fuse_ino_t ino, size_t size) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        std::vector<char> buf(size);
+        int res = t.result(instance->operations->listxattr(meta, path, size > 0 ? &buf[0] : NULL, size));
+        if (res < 0) {
+            fuse_reply_err(req, -res);
+        } else if (size == 0) {
+            fuse_reply_xattr(req, res);
+        } else {
+            fuse_reply_buf(req, &buf[0], res);
+        }
+    }
+
+    void FuseLowlevel::removexattr(fuse_req_t req, fuse_ino_t ino, const char *name) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        int res = t.result(instance->operations->removexattr(meta, path, name));
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::access(fuse_req_t req, fuse_ino_t ino, int mask) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        Springy::FsOps::Abstract::MetaRequest meta = instance->meta(req);
+        boost::filesystem::path path;
+        Springy::NodeTable::Location location;
+        if (!instance->locate(req, meta, ino, path, location)) {
+            return;
+        }
+        Springy::FsOps::Abstract::Hint hint(path, location);
+
+        int res = t.result(instance->operations->access(meta, path, mask));
+        fuse_reply_err(req, -res);
+    }
+
+    void FuseLowlevel::getlk(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, struct flock *lock) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        int res = t.result(instance->operations->lock(instance->meta(req), boost::filesystem::path(), fi->fh, F_GETLK, lock,
+                                                      &fi->lock_owner, sizeof(fi->lock_owner)));
+        if (res != 0) {
+            fuse_reply_err(req, -res);
+            return;
+        }
+        fuse_reply_lock(req, lock);
+    }
+
+    void FuseLowlevel::setlk(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, struct flock *lock, int sleep) {
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        FuseLowlevel *instance = FuseLowlevel::instance(req);
+        int res = t.result(instance->operations->lock(instance->meta(req), boost::filesystem::path(), fi->fh, sleep ? F_SETLKW : F_SETLK, lock,
+                                                      &fi->lock_owner, sizeof(fi->lock_owner)));
+        fuse_reply_err(req, -res);
+    }
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef __SPRINGY_FUSELOWLEVEL_HPP__
+#define __SPRINGY_FUSELOWLEVEL_HPP__
+
+#ifdef HAS_FUSE
+
+#include <fuse_lowlevel.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/filesystem.hpp>
+
+#include "settings.hpp"
+#include "nodetable.hpp"
+
+#include "libc/ilibc.hpp"
+#include "fsops/fuse.hpp"
+
+namespace Springy{
+    /**
+     * front end for the inode based low level fuse api (--lowlevel)
+     *
+     * same life cycle as Springy::Fuse. requests carry inode numbers which are
+     * mapped to paths by the NodeTable, the volume a node was found on at lookup
+     * time is handed to the FsOps as Abstract::Hint, so steady state requests
+     * don't walk the Volumes tree nor probe every volume.
+     */
+    class FuseLowlevel{
+        public:
+            FuseLowlevel();
+            FuseLowlevel& init(Springy::Settings *config, Springy::LibC::ILibC *libc);
+            FuseLowlevel& setUp(bool singleThreaded, bool passthrough=false, bool pinWorkers=false);
+            FuseLowlevel& run();
+            FuseLowlevel& tearDown();
+
+            static void thread(FuseLowlevel *instance);
+
+            ~FuseLowlevel();
+
+            static void init(void *userdata, struct fuse_conn_info *conn);
+            static void destroy(void *userdata);
+            static void lookup(fuse_req_t req, fuse_ino_t parent, const char *name);
+            static void forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup);
+            static void forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data *forgets);
+            static void getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+            static void setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *fi);
+            static void readlink(fuse_req_t req, fuse_ino_t ino);
+            static void mknod(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, dev_t rdev);
+            static void mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode);
+            static void unlink(fuse_req_t req, fuse_ino_t parent, const char *name);
+            static void rmdir(fuse_req_t req, fuse_ino_t parent, const char *name);
+            static void symlink(fuse_req_t req, const char *link, fuse_ino_t parent, const char *name);
+            static void rename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname, unsigned int flags);
+            static void link(fuse_req_t req, fuse_ino_t ino, fuse_ino_t newparent, const char *newname);
+            static void open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+            static void read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi);
+            static void write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t off, struct fuse_file_info *fi);
+            static void write_buf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *bufv, off_t off, struct fuse_file_info *fi);
+            static void flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+            static void release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+            static void fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info *fi);
+            static void fallocate(fuse_req_t req, fuse_ino_t ino, int mode, off_t offset, off_t length, struct fuse_file_info *fi);
+            static void copy_file_range(fuse_req_t req, fuse_ino_t ino_in, off_t off_in, struct fuse_file_info *fi_in,
+                                        fuse_ino_t ino_out, off_t off_out, struct fuse_file_info *fi_out, size_t len, int flags);
+            static void opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+            static void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi);
+            static void releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+            static void statfs(fuse_req_t req, fuse_ino_t ino);
+            static void setxattr(fuse_req_t req, fuse_ino_t ino, const char *name, const char *value, size_t size, int flags);
+            static void getxattr(fuse_req_t req, fuse_ino_t ino, const char *name, size_t size);
+            static void listxattr(fuse_req_t req, fuse_ino_t ino, size_t size);
+            static void removexattr(fuse_req_t req, fuse_ino_t ino, const char *name);
+            static void access(fuse_req_t req, fuse_ino_t ino, int mask);
+            static void create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, struct fuse_file_info *fi);
+            static void getlk(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, struct flock *lock);
+            static void setlk(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, struct flock *lock, int sleep);
+
+        protected:
+            // how long the kernel may cache entries and attributes, --cache-timeout or
+            // the high level api's default
+            double timeout;
+
+            Springy::Settings *config;
+            Springy::LibC::ILibC *libc;
+
+            Springy::FsOps::Fuse *operations;
+            Springy::NodeTable nodes;
+
+            bool readonly;
+            bool singleThreaded;
+
+            // --pin-workers: cpu pinning of libfuse's worker pool. one worker per allowed
+            // cpu, each reading from its own clone of /dev/fuse and pinned to a cpu on
+            // its first request, so a request is received, served and replied on one
+            // cpu and the thread's Trace ring, Metrics and io_uring stay in its caches.
+            // the transport is unchanged, the kernel still deals requests out from one
+            // input queue (see test/bench.pin for what the pinning itself gains)
+            bool pinWorkers;
+            std::vector<int> cpus;
+            std::atomic<unsigned int> nextCpu;
+
+            // the cpus this process may run on, false if there are none
+            bool allowedCpus();
+            void pin();
+            bool withinTearDown;
+
+            // --passthrough: the kernel reads and writes files of local volumes itself,
+            // requests of such handles never reach us. the kernel takes one backing
+            // file per inode, so the handles of a node share its backing id
+            struct Backing{
+                int id;
+                uint64_t handles;
+            };
+            bool passthrough;
+            std::atomic<bool> passthroughFailed;    // no new handles are registered after a failure
+            std::mutex backingLock;
+            std::unordered_map<fuse_ino_t, Backing> backings;
+            std::unordered_set<uint64_t> backedHandles;
+
+            static const char *fsname;
+            boost::filesystem::path mountpoint;
+            std::string fuseoptions;
+            std::thread th;
+
+            struct fuse_lowlevel_ops lops;
+            struct fuse_session *session;
+
+            // see Fuse::connOptions and Fuse::loopConfig
+            struct fuse_conn_info_opts *connOptions;
+            struct fuse_loop_config *loopConfig;
+
+            // directory listing taken by opendir, kept in fi->fh until releasedir
+            typedef std::vector<std::pair<std::string, struct stat> > Listing;
+
+            static FuseLowlevel* instance(fuse_req_t req);
+            Springy::FsOps::Abstract::MetaRequest meta(fuse_req_t req);
+
+            // path and remembered location of the node, replies ENOENT and returns false if it is unknown
+            bool locate(fuse_req_t req, const Springy::FsOps::Abstract::MetaRequest &meta, fuse_ino_t ino,
+                        boost::filesystem::path &path, Springy::NodeTable::Location &location);
+            // looks up parent/name and remembers it, the answer to lookup, mkdir, create, ...
+            int entry(const Springy::FsOps::Abstract::MetaRequest &meta, fuse_ino_t parent, const std::string &name, struct fuse_entry_param &e);
+            static void replyEntry(fuse_req_t req, int res, const struct fuse_entry_param &e);
+
+            // ChangeNotifier listener while mounted
+            void invalidate(const boost::filesystem::path &path, Springy::ChangeNotifier::Kind kind);
+
+            // register/unregister the backing file of an opened handle, no-ops without passthrough
+            void passthroughOpen(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+            void passthroughRelease(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+    };
+}
+
+#endif
+
+#endif
@@ -16,6 +16,7 @@
 
 #include "httpd.hpp"
 #include "exception.hpp"
+#include "metrics.hpp"
 #include "util/string.hpp"
 
 namespace Springy{
@@ -101,19 +102,15 @@ void Httpd::closeOpenFilesByConnection(struct mg_connection *nc){
     mg_conn_addr_to_str(nc, buf, sizeof(buf), MG_SOCK_STRINGIFY_REMOTE|MG_SOCK_STRINGIFY_IP|MG_SOCK_STRINGIFY_PORT);
     std::string remoteHost(buf);
 
-    std::pair<std::multimap<std::string, int>::iterator,
-              std::multimap<std::string, int>::iterator> range = this->mapRemoteHostToFD.equal_range(remoteHost);
+    std::pair<std::multimap<std::string, uint64_t>::iterator,
+              std::multimap<std::string, uint64_t>::iterator> range = this->mapRemoteHostToFD.equal_range(remoteHost);
     for(;range.first!=range.second;range.first++){
-        int fd = range.first->second;
-
-        OpenFiles::openFile of = this->config->openFiles.getByDescriptor(fd);
-        of.volume->close(of.volumeFile, of.fd);
-        this->config->openFiles.remove(fd);
+        this->config->openFiles.remove(range.first->second);
     }
+    this->mapRemoteHostToFD.erase(remoteHost);
 }
 
-void Httpd::sendResponse(std::string response, struct mg_connection *nc, struct http_message *hm){
-    std::string contentType("application/json");
+void Httpd::sendResponse(std::string response, struct mg_connection *nc, struct http_message *hm, std::string contentType){
     char callback[256]   = {'\0'};
 
     mg_get_http_var(&hm->query_string, "callback", callback, sizeof(callback));
@@ -142,7 +139,7 @@ void Httpd::sendResponse(std::string response, struct mg_connection *nc, struct
     mg_printf(nc, "Expires: 0\r\n");
     mg_printf(nc, "Transfer-Encoding: chunked\r\n\r\n");
 
-    mg_printf_http_chunk(nc, response.c_str());
+    mg_send_http_chunk(nc, response.data(), response.length());
 
     mg_send_http_chunk(nc, "", 0);  /* Send empty chunk, the end of response */
 }
@@ -243,6 +240,138 @@ void Httpd::list_directory(struct mg_connection *nc, struct http_message *hm){
     this->sendResponse(response, nc, hm);
 }
 
+void Httpd::list_locks(struct mg_connection *nc, struct http_message *hm){
+    char enable[8] = {'\0'};
+    char reset[8]  = {'\0'};
+
+    // ?enable=1 / ?enable=0 switches profiling on or off, ?reset=1 drops what was recorded
+    if(mg_get_http_var(&hm->query_string, "enable", enable, sizeof(enable)) > 0){
+        SynchronizedProfiler::enable(std::string(enable) == "1");
+    }
+    if(mg_get_http_var(&hm->query_string, "reset", reset, sizeof(reset)) > 0 && std::string(reset) == "1"){
+        SynchronizedProfiler::reset();
+    }
+
+    nlohmann::json j;
+    j["enabled"] = SynchronizedProfiler::enabled().load();
+    j["sites"] = nlohmann::json::array();
+    j["holders"] = nlohmann::json::array();
+
+    SynchronizedProfiler::SiteMap sites = SynchronizedProfiler::snapshot();
+    for(SynchronizedProfiler::SiteMap::iterator it=sites.begin();it!=sites.end();it++){
+        const SynchronizedProfiler::Stats &st = it->second;
+        std::stringstream addr;
+        addr << it->first.addr;
+
+        nlohmann::json site, wait, hold;
+        site["file"] = it->first.file;
+        site["line"] = it->first.line;
+        site["lock"] = addr.str();
+        site["acquisitions"] = st.acquisitions;
+
+        wait["total_ns"] = st.waitNs;
+        wait["max_ns"]   = st.maxWaitNs;
+        wait["p50_ns"]   = SynchronizedProfiler::quantile(st.waitHist, 0.5);
+        wait["p99_ns"]   = SynchronizedProfiler::quantile(st.waitHist, 0.99);
+        wait["histogram"] = std::vector<uint64_t>(st.waitHist, st.waitHist+SynchronizedProfiler::numBuckets);
+
+        hold["total_ns"] = st.holdNs;
+        hold["max_ns"]   = st.maxHoldNs;
+        hold["p50_ns"]   = SynchronizedProfiler::quantile(st.holdHist, 0.5);
+        hold["p99_ns"]   = SynchronizedProfiler::quantile(st.holdHist, 0.99);
+        hold["histogram"] = std::vector<uint64_t>(st.holdHist, st.holdHist+SynchronizedProfiler::numBuckets);
+
+        site["wait"] = wait;
+        site["hold"] = hold;
+        j["sites"].push_back(site);
+    }
+
+    uint64_t now = SynchronizedProfiler::now();
+    std::vector<SynchronizedProfiler::Holder> holders = SynchronizedProfiler::holders();
+    for(size_t i=0;i<holders.size();i++){
+        std::stringstream addr, thread;
+        addr << holders[i].site.addr;
+        thread << holders[i].thread;
+
+        nlohmann::json h;
+        h["file"] = holders[i].site.file;
+        h["line"] = holders[i].site.line;
+        h["lock"] = addr.str();
+        h["type"] = holders[i].ltype == Synchronized::WRITE ? "write" : "read";
+        h["thread"] = thread.str();
+        h["held_ns"] = now - holders[i].since;
+        j["holders"].push_back(h);
+    }
+
+    this->sendResponse(j.dump(), nc, hm);
+}
+void Httpd::list_metrics(struct mg_connection *nc, struct http_message *hm){
+    char format[16] = {'\0'};
+
+    // prometheus text format unless ?format=json is given
+    mg_get_http_var(&hm->query_string, "format", format, sizeof(format));
+
+    std::stringstream ss;
+    if(std::string(format) == "json"){
+        Metrics::json(ss);
+        this->sendResponse(ss.str(), nc, hm);
+    }
+    else{
+        Metrics::prometheus(ss);
+        this->sendResponse(ss.str(), nc, hm, "text/plain; version=0.0.4");
+    }
+}
+void Httpd::list_io(struct mg_connection *nc, struct http_message *hm){
+    char top[16] = {'\0'};
+    size_t n = 20;
+
+    // ?top=N limits the hottest files and busiest uids
+    if(mg_get_http_var(&hm->query_string, "top", top, sizeof(top)) > 0){
+        try{
+            n = boost::lexical_cast<size_t>(top);
+        }catch(boost::bad_lexical_cast &e){}
+    }
+
+    nlohmann::json j;
+    j["volumes"] = nlohmann::json::object();
+    j["mountpoints"] = nlohmann::json::object();
+    j["files"] = nlohmann::json::array();
+    j["uids"] = nlohmann::json::array();
+
+    std::map<std::string, IOAccounting::Totals> totals[2] = {this->config->accounting.volumes(), this->config->accounting.mountPoints()};
+    const char *names[2] = {"volumes", "mountpoints"};
+    for(size_t i=0;i<2;i++){
+        for(std::map<std::string, IOAccounting::Totals>::iterator it=totals[i].begin();it!=totals[i].end();it++){
+            nlohmann::json c;
+            c["ops"]           = it->second.ops;
+            c["opens"]         = it->second.opens;
+            c["bytes_read"]    = it->second.bytesRead;
+            c["bytes_written"] = it->second.bytesWritten;
+            c["errors"]        = it->second.errors;
+            j[names[i]][it->first] = c;
+        }
+    }
+
+    std::vector<IOAccounting::Hitter> files = this->config->accounting.topFiles(n);
+    for(size_t i=0;i<files.size();i++){
+        nlohmann::json f;
+        f["file"]  = files[i].key;
+        f["bytes"] = files[i].count;
+        f["error"] = files[i].error;
+        j["files"].push_back(f);
+    }
+    std::vector<IOAccounting::Hitter> users = this->config->accounting.topUsers(n);
+    for(size_t i=0;i<users.size();i++){
+        nlohmann::json u;
+        u["uid"]   = users[i].key;
+        u["bytes"] = users[i].count;
+        u["error"] = users[i].error;
+        j["uids"].push_back(u);
+    }
+
+    this->sendResponse(j.dump(), nc, hm);
+}
+
 ///// VOLUME API //////
 
 nlohmann::json Httpd::fs_getattr(std::string remotehost, nlohmann::json j){
@@ -371,6 +500,9 @@ nlohmann::json Httpd::fs_mkdir(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->mkdir(meta, p, mode);
+    if(j["errno"]==0){
+        this->config->changes.changed(p, Springy::ChangeNotifier::ENTRY);
+    }
 
     return j;
 }
@@ -382,6 +514,9 @@ nlohmann::json Httpd::fs_rmdir(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->rmdir(meta, p);
+    if(j["errno"]==0){
+        this->config->changes.changed(p, Springy::ChangeNotifier::ENTRY);
+    }
 
     return j;
 }
@@ -393,6 +528,9 @@ nlohmann::json Httpd::fs_unlink(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->unlink(meta, p);
+    if(j["errno"]==0){
+        this->config->changes.changed(p, Springy::ChangeNotifier::ENTRY);
+    }
 
     return j;
 }
@@ -406,6 +544,10 @@ nlohmann::json Httpd::fs_rename(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->rename(meta, from, to);
+    if(j["errno"]==0){
+        this->config->changes.changed(from, Springy::ChangeNotifier::ENTRY);
+        this->config->changes.changed(to, Springy::ChangeNotifier::ENTRY);
+    }
 
     return j;
 }
@@ -423,6 +565,9 @@ nlohmann::json Httpd::fs_utimens(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->utimens(meta, p, times);
+    if(j["errno"]==0){
+        this->config->changes.changed(p, Springy::ChangeNotifier::ATTRIBUTES);
+    }
 
     return j;
 }
@@ -435,6 +580,9 @@ nlohmann::json Httpd::fs_chmod(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->chmod(meta, p, mode);
+    if(j["errno"]==0){
+        this->config->changes.changed(p, Springy::ChangeNotifier::ATTRIBUTES);
+    }
 
     return j;
 }
@@ -448,6 +596,9 @@ nlohmann::json Httpd::fs_chown(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->chown(meta, p, u, g);
+    if(j["errno"]==0){
+        this->config->changes.changed(p, Springy::ChangeNotifier::ATTRIBUTES);
+    }
 
     return j;
 }
@@ -461,6 +612,9 @@ nlohmann::json Httpd::fs_symlink(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->symlink(meta, from, to);
+    if(j["errno"]==0){
+        this->config->changes.changed(to, Springy::ChangeNotifier::ENTRY);
+    }
 
     return j;
 }
@@ -476,6 +630,9 @@ nlohmann::json Httpd::fs_link(std::string remotehost, nlohmann::json j){
     boost::filesystem::path from(sfrom);
     boost::filesystem::path to(sto);
     j["errno"] = this->operations->link(meta, from, to);
+    if(j["errno"]==0){
+        this->config->changes.changed(to, Springy::ChangeNotifier::ENTRY);
+    }
 
     return j;
 }
@@ -489,6 +646,9 @@ nlohmann::json Httpd::fs_mknod(std::string remotehost, nlohmann::json j){
 
     j.clear();
     j["errno"] = this->operations->mknod(meta, p, mode, dev);
+    if(j["errno"]==0){
+        this->config->changes.changed(p, Springy::ChangeNotifier::ENTRY);
+    }
 
     return j;
 }
@@ -522,9 +682,9 @@ nlohmann::json Httpd::fs_getxattr(std::string remotehost, nlohmann::json j){
         buffer[size] = '\0';
         size = this->operations->getxattr(meta, p, attrname, &buffer[0], size+1);
     }
-    j["errno"] = size;
-    if(size > 0){
-        std::string value = std::string(&buffer[0], size);
+    j["errno"] = size < 0 ? size : 0;
+    if(size >= 0){
+        std::string value = size > 0 ? std::string(&buffer[0], size) : std::string();
         j["xattr"] = ::Springy::Util::String::encode64(value);
     }
 
@@ -545,7 +705,7 @@ nlohmann::json Httpd::fs_listxattr(std::string remotehost, nlohmann::json j){
         buffer[size] = '\0';
         size = this->operations->listxattr(meta, p, &buffer[0], size+1);
     }
-    j["errno"] = size;
+    j["errno"] = size < 0 ? size : 0;
     if(size > 0){
         nlohmann::json jxattrs;
         std::string value;
@@ -576,7 +736,7 @@ nlohmann::json Httpd::fs_removexattr(std::string remotehost, nlohmann::json j){
     Springy::FsOps::Abstract::MetaRequest meta = this->getMetaFromJson(j);
 
     j.clear();
-    j["errno"] = this->operations->link(meta, p, attrname);
+    j["errno"] = this->operations->removexattr(meta, p, attrname);
 
     return j;
 }
@@ -589,17 +749,29 @@ nlohmann::json Httpd::fs_truncate(std::string remotehost, nlohmann::json j){
     Springy::FsOps::Abstract::MetaRequest meta = this->getMetaFromJson(j);
 
     size_t size = j.value("size", -1);
-    int fd = j.value("fd", -1);
+    bool hasFd = j.find("fd") != j.end();
+    uint64_t fd = j.value("fd", (uint64_t)0);
 
     j.clear();
 
-    if(fd >= 0){
+    if(!hasFd){
         j["errno"] = this->operations->truncate(meta, p, size);
     }
     else{
+        // handle ids from clients are checked against the open files first
+        if(this->config->openFiles.acquire(fd) == NULL){
+            j["errno"] = -EBADF;
+            return j;
+        }
+
         struct ::fuse_file_info fi;
         fi.fh = fd;
         j["errno"] = this->operations->ftruncate(meta, p, size, &fi);
+
+        this->config->openFiles.put(fd);
+    }
+    if(j["errno"]==0){
+        this->config->changes.changed(p, Springy::ChangeNotifier::DATA);
     }
 
     return j;
@@ -616,15 +788,17 @@ nlohmann::json Httpd::fs_create(std::string remotehost, nlohmann::json j){
     j.clear();
     struct ::fuse_file_info fi;
     fi.flags = flags;
-    int fd = this->operations->create(meta, p, mode, &fi);
-    if(fd < 0){
-        j["errno"] = fd;
+    int res = this->operations->create(meta, p, mode, &fi);
+    if(res < 0){
+        j["errno"] = res;
     }
     else{
+        uint64_t fd = fi.fh;
         j["errno"] = 0;
         j["fd"] = fd;
 
         this->mapRemoteHostToFD.insert(std::make_pair(remotehost, fd));
+        this->config->changes.changed(p, Springy::ChangeNotifier::ENTRY);
     }
 
     return j;
@@ -639,11 +813,12 @@ nlohmann::json Httpd::fs_open(std::string remotehost, nlohmann::json j){
     j.clear();
     struct ::fuse_file_info fi;
     fi.flags = flags;
-    int fd = this->operations->open(meta, p, &fi);
-    if(fd < 0){
-        j["errno"] = fd;
+    int res = this->operations->open(meta, p, &fi);
+    if(res < 0){
+        j["errno"] = res;
     }
     else{
+        uint64_t fd = fi.fh;
         j["errno"] = 0;
         j["fd"] = fd;
         
@@ -778,6 +953,12 @@ void Httpd::ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 instance->handle_directory(0, nc, hm);
             } else if (uri == "/api/listDirectory") {
                 instance->list_directory(nc, hm);
+            } else if (uri == "/api/locks") {
+                instance->list_locks(nc, hm);
+            } else if (uri == "/api/metrics") {
+                instance->list_metrics(nc, hm);
+            } else if (uri == "/api/io") {
+                instance->list_io(nc, hm);
             } else{
                 nlohmann::json j = nlohmann::json::parse(std::string(hm->body.p, hm->body.len));
                 
@@ -41,15 +41,18 @@ namespace Springy{
             
             Springy::FsOps::Local *operations;
             
-            std::multimap<std::string, int> mapRemoteHostToFD;
+            std::multimap<std::string, uint64_t> mapRemoteHostToFD;
 
-            void sendResponse(std::string response, struct mg_connection *nc, struct http_message *hm);
+            void sendResponse(std::string response, struct mg_connection *nc, struct http_message *hm, std::string contentType="application/json");
             Springy::FsOps::Abstract::MetaRequest getMetaFromJson(nlohmann::json j);
 
             void closeOpenFilesByConnection(struct mg_connection *nc);
 
             void handle_directory(int what, struct mg_connection *nc, struct http_message *hm);
             void list_directory(struct mg_connection *nc, struct http_message *hm);
+            void list_locks(struct mg_connection *nc, struct http_message *hm);
+            void list_metrics(struct mg_connection *nc, struct http_message *hm);
+            void list_io(struct mg_connection *nc, struct http_message *hm);
 
             nlohmann::json routeRequest(std::string uri, std::string remotehost, nlohmann::json j);
 
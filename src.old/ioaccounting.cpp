@@ -0,0 +1,240 @@
+#include "ioaccounting.hpp"
+#include "volume/ivolume.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace Springy{
+    std::mutex IOAccounting::batchesLock;
+
+    IOAccounting::IOAccounting(){}
+    IOAccounting::~IOAccounting(){
+        // the threads delete their batches, they merge into nothing anymore
+        std::lock_guard<std::mutex> lock(IOAccounting::batchesLock);
+        for(std::set<Batch*>::iterator it=this->batches.begin();it!=this->batches.end();it++){
+            (*it)->owner.store(NULL, std::memory_order_relaxed);
+        }
+    }
+
+    IOAccounting::Account IOAccounting::account(const boost::filesystem::path &mountPoint, Springy::Volume::IVolume *volume, const boost::filesystem::path &file){
+        Account a;
+        a.file = file.string();
+        a.fileHash = std::hash<std::string>()(a.file);
+
+        std::lock_guard<std::mutex> lock(this->countersLock);
+        a.volume = &this->volumeCounters[volume != NULL ? volume->string() : std::string()];
+        a.mountPoint = &this->mountPointCounters[mountPoint.string()];
+        return a;
+    }
+
+    void IOAccounting::ThreadBatch::release(){
+        if(this->batch == NULL){
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(IOAccounting::batchesLock);
+        IOAccounting *owner = this->batch->owner.load(std::memory_order_relaxed);
+        if(owner != NULL){
+            {
+                std::lock_guard<std::mutex> batchLock(this->batch->lock);
+                owner->flush(*this->batch);
+            }
+            owner->batches.erase(this->batch);
+        }
+        delete this->batch;
+        this->batch = NULL;
+    }
+
+    IOAccounting::Batch* IOAccounting::batch(){
+        static thread_local ThreadBatch tb;
+        if(tb.batch != NULL && tb.batch->owner.load(std::memory_order_relaxed) == this){
+            return tb.batch;
+        }
+
+        // first operation of the thread, or it accounted to another instance so far
+        tb.release();
+        Batch *b = new Batch(this);
+        std::lock_guard<std::mutex> lock(IOAccounting::batchesLock);
+        this->batches.insert(b);
+        tb.batch = b;
+        return b;
+    }
+
+    void IOAccounting::flush(Batch &b){
+        for(size_t i=0;i<b.files.size();i++){
+            Shard &s = this->shards[b.files[i].hash % numShards];
+            std::lock_guard<std::mutex> lock(s.lock);
+            s.files.add(b.files[i].path, b.files[i].weight);
+        }
+        for(size_t i=0;i<b.users.size();i++){
+            Shard &s = this->shards[std::hash<uid_t>()(b.users[i].uid) % numShards];
+            std::lock_guard<std::mutex> lock(s.lock);
+            s.users.add(b.users[i].uid, b.users[i].weight);
+        }
+        b.files.clear();
+        b.users.clear();
+        b.ops = 0;
+    }
+
+    void IOAccounting::flushAll(){
+        std::lock_guard<std::mutex> lock(IOAccounting::batchesLock);
+        for(std::set<Batch*>::iterator it=this->batches.begin();it!=this->batches.end();it++){
+            std::lock_guard<std::mutex> batchLock((*it)->lock);
+            this->flush(**it);
+        }
+    }
+
+    void IOAccounting::hit(const Account &a, uid_t uid, uint64_t weight){
+        weight = std::max(weight, (uint64_t)1);
+
+        Batch *b = this->batch();
+        std::lock_guard<std::mutex> lock(b->lock);
+
+        // a thread mostly works on a few files, the hash is compared first
+        size_t f = 0;
+        while(f < b->files.size() && (b->files[f].hash != a.fileHash || b->files[f].path != a.file)){
+            f++;
+        }
+        if(f == b->files.size()){
+            Batch::File file = {a.file, a.fileHash, 0};
+            b->files.push_back(file);
+        }
+        b->files[f].weight += weight;
+
+        size_t u = 0;
+        while(u < b->users.size() && b->users[u].uid != uid){
+            u++;
+        }
+        if(u == b->users.size()){
+            Batch::User user = {uid, 0};
+            b->users.push_back(user);
+        }
+        b->users[u].weight += weight;
+
+        if(++b->ops >= batchOps || b->files.size() >= batchFiles || b->users.size() >= batchUsers){
+            this->flush(*b);
+        }
+    }
+
+    void IOAccounting::opened(const Account &a, uid_t uid){
+        if(a.volume == NULL){
+            return;
+        }
+        a.volume->opens.fetch_add(1, std::memory_order_relaxed);
+        a.mountPoint->opens.fetch_add(1, std::memory_order_relaxed);
+        this->hit(a, uid, 1);
+    }
+
+    void IOAccounting::read(const Account &a, uid_t uid, ssize_t res){
+        if(a.volume == NULL){
+            return;
+        }
+        a.volume->ops.fetch_add(1, std::memory_order_relaxed);
+        a.mountPoint->ops.fetch_add(1, std::memory_order_relaxed);
+        if(res < 0){
+            a.volume->errors.fetch_add(1, std::memory_order_relaxed);
+            a.mountPoint->errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        a.volume->bytesRead.fetch_add(res, std::memory_order_relaxed);
+        a.mountPoint->bytesRead.fetch_add(res, std::memory_order_relaxed);
+        this->hit(a, uid, res);
+    }
+
+    void IOAccounting::written(const Account &a, uid_t uid, ssize_t res){
+        if(a.volume == NULL){
+            return;
+        }
+        a.volume->ops.fetch_add(1, std::memory_order_relaxed);
+        a.mountPoint->ops.fetch_add(1, std::memory_order_relaxed);
+        if(res < 0){
+            a.volume->errors.fetch_add(1, std::memory_order_relaxed);
+            a.mountPoint->errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        a.volume->bytesWritten.fetch_add(res, std::memory_order_relaxed);
+        a.mountPoint->bytesWritten.fetch_add(res, std::memory_order_relaxed);
+        this->hit(a, uid, res);
+    }
+
+    void IOAccounting::other(const Account &a, uid_t uid, int res){
+        if(a.volume == NULL){
+            return;
+        }
+        a.volume->ops.fetch_add(1, std::memory_order_relaxed);
+        a.mountPoint->ops.fetch_add(1, std::memory_order_relaxed);
+        if(res < 0){
+            a.volume->errors.fetch_add(1, std::memory_order_relaxed);
+            a.mountPoint->errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        this->hit(a, uid, 1);
+    }
+
+    IOAccounting::Totals IOAccounting::totals(const Counters &c){
+        Totals t;
+        t.ops = c.ops.load(std::memory_order_relaxed);
+        t.opens = c.opens.load(std::memory_order_relaxed);
+        t.bytesRead = c.bytesRead.load(std::memory_order_relaxed);
+        t.bytesWritten = c.bytesWritten.load(std::memory_order_relaxed);
+        t.errors = c.errors.load(std::memory_order_relaxed);
+        return t;
+    }
+
+    std::map<std::string, IOAccounting::Totals> IOAccounting::volumes(){
+        std::map<std::string, Totals> result;
+        std::lock_guard<std::mutex> lock(this->countersLock);
+        for(std::map<std::string, Counters>::iterator it=this->volumeCounters.begin();it!=this->volumeCounters.end();it++){
+            result[it->first] = IOAccounting::totals(it->second);
+        }
+        return result;
+    }
+
+    std::map<std::string, IOAccounting::Totals> IOAccounting::mountPoints(){
+        std::map<std::string, Totals> result;
+        std::lock_guard<std::mutex> lock(this->countersLock);
+        for(std::map<std::string, Counters>::iterator it=this->mountPointCounters.begin();it!=this->mountPointCounters.end();it++){
+            result[it->first] = IOAccounting::totals(it->second);
+        }
+        return result;
+    }
+
+    // a key lives in exactly one shard, so the shards' entries can simply be concatenated
+    std::vector<IOAccounting::Hitter> IOAccounting::merge(std::vector<Hitter> &all, size_t n){
+        std::sort(all.begin(), all.end(), [](const Hitter &a, const Hitter &b){
+            return a.count > b.count;
+        });
+        if(all.size() > n){
+            all.resize(n);
+        }
+        return all;
+    }
+
+    std::vector<IOAccounting::Hitter> IOAccounting::topFiles(size_t n){
+        std::vector<Hitter> all;
+        this->flushAll();
+        for(size_t i=0;i<numShards;i++){
+            std::lock_guard<std::mutex> lock(this->shards[i].lock);
+            std::vector<Springy::Util::SpaceSaving<std::string>::Entry> top = this->shards[i].files.top(n);
+            for(size_t j=0;j<top.size();j++){
+                Hitter h = {top[j].key, top[j].count, top[j].error};
+                all.push_back(h);
+            }
+        }
+        return IOAccounting::merge(all, n);
+    }
+
+    std::vector<IOAccounting::Hitter> IOAccounting::topUsers(size_t n){
+        std::vector<Hitter> all;
+        this->flushAll();
+        for(size_t i=0;i<numShards;i++){
+            std::lock_guard<std::mutex> lock(this->shards[i].lock);
+            std::vector<Springy::Util::SpaceSaving<uid_t>::Entry> top = this->shards[i].users.top(n);
+            for(size_t j=0;j<top.size();j++){
+                Hitter h = {std::to_string(top[j].key), top[j].count, top[j].error};
+                all.push_back(h);
+            }
+        }
+        return IOAccounting::merge(all, n);
+    }
+}
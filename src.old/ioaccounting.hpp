@@ -0,0 +1,159 @@
+#ifndef SPRINGY_IOACCOUNTING
+#define SPRINGY_IOACCOUNTING
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "util/spacesaving.hpp"
+
+namespace Springy{
+    namespace Volume{
+        class IVolume;
+    }
+
+    /**
+     * i/o accounting of open files
+     *
+     * counts opens, reads, writes and the other descriptor operations with
+     * their bytes and errors per volume and per virtual mount point. the
+     * counters are resolved once when a file is opened and kept in its
+     * OpenFiles::Handle (Account), so accounting a read is a few atomic adds.
+     *
+     * additionally the hottest files and the busiest uids, weighted by bytes
+     * transferred (at least 1 per operation), are tracked by sharded
+     * SpaceSaving sketches of bounded size. operations are collected per
+     * thread first and merged into the sketches every batchOps operations
+     * and before a report, so the i/o threads rarely meet at a shard lock.
+     */
+    class IOAccounting{
+        public:
+            struct Counters{
+                std::atomic<uint64_t> ops;
+                std::atomic<uint64_t> opens;
+                std::atomic<uint64_t> bytesRead;
+                std::atomic<uint64_t> bytesWritten;
+                std::atomic<uint64_t> errors;
+
+                Counters() : ops(0), opens(0), bytesRead(0), bytesWritten(0), errors(0){}
+            };
+            struct Totals{
+                uint64_t ops;
+                uint64_t opens;
+                uint64_t bytesRead;
+                uint64_t bytesWritten;
+                uint64_t errors;
+            };
+
+            // what an open file is accounted to
+            struct Account{
+                Counters *volume;
+                Counters *mountPoint;
+                std::string file; // virtual path
+                size_t fileHash;
+
+                Account() : volume(NULL), mountPoint(NULL), fileHash(0){}
+            };
+
+            struct Hitter{
+                std::string key;
+                uint64_t count; // upper bound
+                uint64_t error; // count - error is a lower bound
+            };
+
+            IOAccounting();
+            ~IOAccounting();
+
+            Account account(const boost::filesystem::path &mountPoint, Springy::Volume::IVolume *volume, const boost::filesystem::path &file);
+
+            void opened(const Account &a, uid_t uid);
+            // res as returned by the volume, -1 on error
+            void read(const Account &a, uid_t uid, ssize_t res);
+            void written(const Account &a, uid_t uid, ssize_t res);
+            // any other operation on an open file
+            void other(const Account &a, uid_t uid, int res);
+
+            std::map<std::string, Totals> volumes();
+            std::map<std::string, Totals> mountPoints();
+            std::vector<Hitter> topFiles(size_t n);
+            std::vector<Hitter> topUsers(size_t n);
+
+        protected:
+            static const size_t numShards = 16;
+            static const size_t shardCapacity = 64;
+            static const size_t batchOps = 256;
+            static const size_t batchFiles = 32;
+            static const size_t batchUsers = 8;
+
+            std::mutex countersLock;
+            // never erased, Accounts point into them
+            std::map<std::string, Counters> volumeCounters;
+            std::map<std::string, Counters> mountPointCounters;
+
+            struct Shard{
+                std::mutex lock;
+                Springy::Util::SpaceSaving<std::string> files;
+                Springy::Util::SpaceSaving<uid_t> users;
+
+                Shard() : files(shardCapacity), users(shardCapacity){}
+            };
+            Shard shards[numShards];
+
+            // what a thread accounted since it last merged into the shards
+            struct Batch{
+                struct File{
+                    std::string path;
+                    size_t hash;
+                    uint64_t weight;
+                };
+                struct User{
+                    uid_t uid;
+                    uint64_t weight;
+                };
+
+                std::mutex lock;    // only contended by reports
+                std::atomic<IOAccounting*> owner;   // NULL once the owner is gone
+                std::vector<File> files;
+                std::vector<User> users;
+                size_t ops;
+
+                Batch(IOAccounting *owner) : owner(owner), ops(0){}
+            };
+            // the calling thread's batch, merged and deleted when the thread ends
+            struct ThreadBatch{
+                Batch *batch;
+
+                ThreadBatch() : batch(NULL){}
+                ~ThreadBatch(){ this->release(); }
+                void release();
+            };
+
+            // guards every instance's batches and Batch::owner
+            static std::mutex batchesLock;
+            std::set<Batch*> batches;
+
+            Batch* batch();
+            // b.lock held
+            void flush(Batch &b);
+            void flushAll();
+
+            void hit(const Account &a, uid_t uid, uint64_t weight);
+
+            static Totals totals(const Counters &c);
+            static std::vector<Hitter> merge(std::vector<Hitter> &all, size_t n);
+
+        private:
+            IOAccounting(const IOAccounting&);
+            IOAccounting& operator=(const IOAccounting&);
+    };
+}
+
+#endif
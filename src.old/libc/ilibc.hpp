@@ -2,17 +2,38 @@
 #define SPRINGY_LIBC_ILIBC_HPP
 
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <utime.h>
 
+struct io_uring_params;
+
 /**
  * for testing purpose springy uses this wrapper class as an interface to libc
+ *
+ * only builds with SPRINGY_LIBC_MOCKABLE (make MOCKABLE_LIBC=1, the tests) get
+ * this abstract interface. otherwise ILibC names the final LibC itself, so the
+ * calls of Volume::File, FsOps etc. are bound at compile time and inlined
  */
 
+#ifndef SPRINGY_LIBC_MOCKABLE
+
+namespace Springy{
+    namespace LibC{
+        class LibC;
+        typedef LibC ILibC;
+    }
+}
+
+#include "libc.hpp"
+
+#else
+
 namespace Springy{
     namespace LibC{
         class ILibC{
@@ -88,6 +109,12 @@ namespace Springy{
                 virtual off_t lseek(int LINE, int fd, off_t offset, int whence) = 0;
                 virtual int truncate(int LINE, const char *path, off_t length) = 0;
                 virtual int ftruncate(int LINE, int fd, off_t length) = 0;
+                virtual int fallocate(int LINE, int fd, int mode, off_t offset, off_t len) = 0;
+                virtual ssize_t copy_file_range(int LINE, int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t len, unsigned int flags) = 0;
+                virtual ssize_t splice(int LINE, int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t len, unsigned int flags) = 0;
+                virtual int pipe2(int LINE, int pipefd[2], int flags) = 0;
+                virtual int fcntl(int LINE, int fd, int cmd, int arg) = 0;
+                virtual int ioctl(int LINE, int fd, unsigned long request, void *arg) = 0;
                 virtual ssize_t pread(int LINE, int fd, void *buf, size_t count, off_t offset) = 0;
                 virtual ssize_t pwrite(int LINE, int fd, const void *buf, size_t count, off_t offset) = 0;
                 virtual ssize_t write(int LINE, int fd, const void *buf, size_t count) = 0;
@@ -135,9 +162,22 @@ namespace Springy{
                                 
                 virtual int ulockmgr_op(int fd, int cmd, struct ::flock *lock, const void *owner, size_t owner_len) = 0;
 
+                virtual int inotify_init1(int LINE, int flags) = 0;
+                virtual int inotify_add_watch(int LINE, int fd, const char *pathname, uint32_t mask) = 0;
+                virtual int inotify_rm_watch(int LINE, int fd, int wd) = 0;
+
+                virtual void *mmap(int LINE, void *addr, size_t length, int prot, int flags, int fd, off_t offset) = 0;
+                virtual int munmap(int LINE, void *addr, size_t length) = 0;
+                // no glibc wrappers, these are the raw syscalls
+                virtual int io_uring_setup(int LINE, unsigned entries, struct io_uring_params *p) = 0;
+                virtual int io_uring_enter(int LINE, int fd, unsigned to_submit, unsigned min_complete, unsigned flags) = 0;
+                virtual int io_uring_register(int LINE, int fd, unsigned opcode, void *arg, unsigned nr_args) = 0;
+
                 virtual void* memset(int LINE, void *s, int c, size_t n) = 0;
         };
     }
 }
 
 #endif
+
+#endif
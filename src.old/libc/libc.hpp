@@ -18,6 +18,10 @@
 #include <sys/resource.h>
 #include <fcntl.h>
 #include <sys/statvfs.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 extern "C" {
 #include <ulockmgr.h>
@@ -25,7 +29,11 @@ extern "C" {
 
 namespace Springy{
     namespace LibC{
+#ifdef SPRINGY_LIBC_MOCKABLE
         class LibC : public Springy::LibC::ILibC{
+#else
+        class LibC final{
+#endif
             public:
                 LibC(){}
                 virtual ~LibC(){}
@@ -99,6 +107,12 @@ namespace Springy{
                 virtual off_t lseek(int LINE, int fd, off_t offset, int whence){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::lseek(fd, offset, whence); }
                 virtual int truncate(int LINE, const char *path, off_t length){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::truncate(path, length); }
                 virtual int ftruncate(int LINE, int fd, off_t length){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::ftruncate(fd, length); }
+                virtual int fallocate(int LINE, int fd, int mode, off_t offset, off_t len){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::fallocate(fd, mode, offset, len); }
+                virtual ssize_t copy_file_range(int LINE, int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t len, unsigned int flags){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::copy_file_range(fd_in, off_in, fd_out, off_out, len, flags); }
+                virtual ssize_t splice(int LINE, int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t len, unsigned int flags){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::splice(fd_in, off_in, fd_out, off_out, len, flags); }
+                virtual int pipe2(int LINE, int pipefd[2], int flags){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::pipe2(pipefd, flags); }
+                virtual int fcntl(int LINE, int fd, int cmd, int arg){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::fcntl(fd, cmd, arg); }
+                virtual int ioctl(int LINE, int fd, unsigned long request, void *arg){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::ioctl(fd, request, arg); }
                 virtual ssize_t pread(int LINE, int fd, void *buf, size_t count, off_t offset){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::pread(fd, buf, count, offset); }
                 virtual ssize_t pwrite(int LINE, int fd, const void *buf, size_t count, off_t offset){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::pwrite(fd, buf, count, offset); }
                 virtual ssize_t write(int LINE, int fd, const void *buf, size_t count){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::write(fd, buf, count); }
@@ -150,6 +164,16 @@ namespace Springy{
                     return ::ulockmgr_op(fd, cmd, lock, owner, owner_len);
                 }
 
+                virtual int inotify_init1(int LINE, int flags){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::inotify_init1(flags); }
+                virtual int inotify_add_watch(int LINE, int fd, const char *pathname, uint32_t mask){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::inotify_add_watch(fd, pathname, mask); }
+                virtual int inotify_rm_watch(int LINE, int fd, int wd){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::inotify_rm_watch(fd, wd); }
+
+                virtual void *mmap(int LINE, void *addr, size_t length, int prot, int flags, int fd, off_t offset){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::mmap(addr, length, prot, flags, fd, offset); }
+                virtual int munmap(int LINE, void *addr, size_t length){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::munmap(addr, length); }
+                virtual int io_uring_setup(int LINE, unsigned entries, struct io_uring_params *p){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::syscall(__NR_io_uring_setup, entries, p); }
+                virtual int io_uring_enter(int LINE, int fd, unsigned to_submit, unsigned min_complete, unsigned flags){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0); }
+                virtual int io_uring_register(int LINE, int fd, unsigned opcode, void *arg, unsigned nr_args){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args); }
+
                 virtual void* memset(int LINE, void *s, int c, size_t n){ Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__); return ::memset(s, c, n); }
         };
     }
@@ -0,0 +1,264 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include "trace.hpp"
+#include "util/json.hpp"
+
+namespace Springy{
+    Metrics::Stats::Stats() : count(0), sumNs(0), maxNs(0){
+        std::fill(this->hist, this->hist+numBuckets, 0);
+    }
+    void Metrics::Stats::merge(const Stats &o){
+        this->count += o.count;
+        this->sumNs += o.sumNs;
+        this->maxNs = std::max(this->maxNs, o.maxNs);
+        for(size_t i=0;i<numBuckets;i++){
+            this->hist[i] += o.hist[i];
+        }
+        for(std::map<int, uint64_t>::const_iterator it=o.errors.begin();it!=o.errors.end();it++){
+            this->errors[it->first] += it->second;
+        }
+    }
+    uint64_t Metrics::Stats::errorCount() const{
+        uint64_t n = 0;
+        for(std::map<int, uint64_t>::const_iterator it=this->errors.begin();it!=this->errors.end();it++){
+            n += it->second;
+        }
+        return n;
+    }
+
+    uint64_t Metrics::quantile(const Stats &st, double q){
+        uint64_t count = 0, seen = 0;
+        for(size_t i=0;i<numBuckets;i++){
+            count += st.hist[i];
+        }
+        if(count == 0){
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(q * count);
+        for(size_t i=0;i<numBuckets;i++){
+            seen += st.hist[i];
+            if(seen > rank){
+                return std::min(Metrics::bucketLimit(i), st.maxNs);
+            }
+        }
+        return st.maxNs;
+    }
+
+    struct Metrics::ThreadData{
+        // published list, new entries are pushed to the front
+        std::atomic<Counters*> head;
+
+        // only used by the owning thread. frames which aren't entry points map to NULL
+        typedef std::pair<const char*, uint32_t> IndexKey;
+        std::unordered_map<IndexKey, Counters*, boost::hash<IndexKey> > index;
+
+        ThreadData() : head(NULL){}
+    };
+
+    std::mutex& Metrics::registryLock(){
+        static std::mutex *lock = new std::mutex();
+        return *lock;
+    }
+    // thread data is never freed, a thread's numbers stay in the totals after it ended
+    std::vector<Metrics::ThreadData*>& Metrics::registry(){
+        static std::vector<Metrics::ThreadData*> *threads = new std::vector<Metrics::ThreadData*>();
+        return *threads;
+    }
+
+    Metrics::ThreadData& Metrics::local(){
+        static thread_local ThreadData *td = NULL;
+        if(td == NULL){
+            td = new ThreadData();
+            std::lock_guard<std::mutex> lock(Metrics::registryLock());
+            Metrics::registry().push_back(td);
+        }
+        return *td;
+    }
+
+    // "virtual int Springy::FsOps::Fuse::read(...)" -> "FsOps::Fuse::read"
+    std::string Metrics::operation(const char *method){
+        std::string m(method);
+        m = m.substr(0, m.find('('));
+        size_t space = m.rfind(' ');
+        if(space != std::string::npos){
+            m = m.substr(space+1);
+        }
+        if(m.compare(0, 9, "Springy::") == 0){
+            m = m.substr(9);
+        }
+        return m;
+    }
+
+    Metrics::Counters* Metrics::counters(ThreadData &td, const char *method, uint32_t volume){
+        ThreadData::IndexKey key(method, volume);
+        std::unordered_map<ThreadData::IndexKey, Counters*, boost::hash<ThreadData::IndexKey> >::iterator it = td.index.find(key);
+        if(it != td.index.end()){
+            return it->second;
+        }
+
+        std::string op = Metrics::operation(method);
+        if(op.compare(0, 6, "Fuse::") != 0 && op.compare(0, 14, "FuseLowlevel::") != 0 &&
+           op.compare(0, 7, "FsOps::") != 0 && op.compare(0, 8, "Volume::") != 0){
+            td.index[key] = NULL;
+            return NULL;
+        }
+
+        Counters *c = new Counters();
+        c->method = method;
+        c->op = op;
+        c->volume = volume;
+        c->count.store(0);
+        c->sumNs.store(0);
+        c->maxNs.store(0);
+        for(size_t i=0;i<numBuckets;i++){
+            c->hist[i].store(0);
+        }
+        for(size_t i=0;i<numErrors;i++){
+            c->errnos[i].store(0);
+            c->errors[i].store(0);
+        }
+        c->otherErrors.store(0);
+
+        c->next = td.head.load(std::memory_order_relaxed);
+        td.head.store(c, std::memory_order_release);
+        td.index[key] = c;
+        return c;
+    }
+
+    // the owning thread is the only writer, so no read-modify-write is needed
+    static inline void add(std::atomic<uint64_t> &a, uint64_t v){
+        a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    void Metrics::record(const char *method, uint32_t volume, uint64_t ns, int result){
+        ThreadData &td = Metrics::local();
+        Counters *c = Metrics::counters(td, method, volume);
+        if(c == NULL){
+            return;
+        }
+
+        add(c->count, 1);
+        add(c->sumNs, ns);
+        add(c->hist[Metrics::bucket(ns)], 1);
+        if(ns > c->maxNs.load(std::memory_order_relaxed)){
+            c->maxNs.store(ns, std::memory_order_relaxed);
+        }
+
+        if(result >= 0){
+            return;
+        }
+        int err = -result;
+        for(size_t i=0;i<numErrors;i++){
+            int e = c->errnos[i].load(std::memory_order_relaxed);
+            if(e == 0){
+                c->errnos[i].store(err, std::memory_order_relaxed);
+                e = err;
+            }
+            if(e == err){
+                add(c->errors[i], 1);
+                return;
+            }
+        }
+        add(c->otherErrors, 1);
+    }
+
+    Metrics::StatsMap Metrics::snapshot(){
+        StatsMap result;
+        std::unordered_map<uint32_t, std::string> names;
+
+        std::lock_guard<std::mutex> lock(Metrics::registryLock());
+        std::vector<ThreadData*> &threads = Metrics::registry();
+        for(size_t i=0;i<threads.size();i++){
+            for(Counters *c=threads[i]->head.load(std::memory_order_acquire);c!=NULL;c=c->next){
+                std::unordered_map<uint32_t, std::string>::iterator nit = names.find(c->volume);
+                if(nit == names.end()){
+                    nit = names.insert(std::make_pair(c->volume, Trace::volumeName(c->volume))).first;
+                }
+                Stats &st = result[Key(c->op, nit->second)];
+                st.count += c->count.load(std::memory_order_relaxed);
+                st.sumNs += c->sumNs.load(std::memory_order_relaxed);
+                st.maxNs = std::max(st.maxNs, c->maxNs.load(std::memory_order_relaxed));
+                for(size_t b=0;b<numBuckets;b++){
+                    st.hist[b] += c->hist[b].load(std::memory_order_relaxed);
+                }
+                for(size_t e=0;e<numErrors;e++){
+                    int err = c->errnos[e].load(std::memory_order_relaxed);
+                    uint64_t n = c->errors[e].load(std::memory_order_relaxed);
+                    if(err != 0 && n != 0){
+                        st.errors[err] += n;
+                    }
+                }
+                uint64_t other = c->otherErrors.load(std::memory_order_relaxed);
+                if(other != 0){
+                    st.errors[0] += other;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static std::string labels(const Metrics::Key &key){
+        return "op=\"" + key.first + "\",volume=\"" + key.second + "\"";
+    }
+
+    void Metrics::prometheus(std::ostream &out){
+        StatsMap stats = Metrics::snapshot();
+        static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+        out << "# HELP springy_op_duration_seconds latency of filesystem operations per volume" << std::endl;
+        out << "# TYPE springy_op_duration_seconds summary" << std::endl;
+        for(StatsMap::iterator it=stats.begin();it!=stats.end();it++){
+            std::string l = labels(it->first);
+            for(size_t i=0;i<sizeof(quantiles)/sizeof(quantiles[0]);i++){
+                out << "springy_op_duration_seconds{" << l << ",quantile=\"" << quantiles[i] << "\"} "
+                    << Metrics::quantile(it->second, quantiles[i]) / 1e9 << std::endl;
+            }
+            out << "springy_op_duration_seconds_sum{" << l << "} " << it->second.sumNs / 1e9 << std::endl;
+            out << "springy_op_duration_seconds_count{" << l << "} " << it->second.count << std::endl;
+        }
+
+        out << "# HELP springy_op_errors_total failed filesystem operations per volume and errno, errno 0 collects the rare ones" << std::endl;
+        out << "# TYPE springy_op_errors_total counter" << std::endl;
+        for(StatsMap::iterator it=stats.begin();it!=stats.end();it++){
+            std::string l = labels(it->first);
+            for(std::map<int, uint64_t>::iterator eit=it->second.errors.begin();eit!=it->second.errors.end();eit++){
+                out << "springy_op_errors_total{" << l << ",errno=\"" << eit->first << "\"} " << eit->second << std::endl;
+            }
+        }
+    }
+
+    void Metrics::json(std::ostream &out){
+        StatsMap stats = Metrics::snapshot();
+
+        nlohmann::json j;
+        j["operations"] = nlohmann::json::array();
+        for(StatsMap::iterator it=stats.begin();it!=stats.end();it++){
+            const Stats &st = it->second;
+
+            nlohmann::json op, errors = nlohmann::json::object();
+            op["op"]       = it->first.first;
+            op["volume"]   = it->first.second;
+            op["count"]    = st.count;
+            op["sum_ns"]   = st.sumNs;
+            op["max_ns"]   = st.maxNs;
+            op["p50_ns"]   = Metrics::quantile(st, 0.5);
+            op["p90_ns"]   = Metrics::quantile(st, 0.9);
+            op["p99_ns"]   = Metrics::quantile(st, 0.99);
+            op["p999_ns"]  = Metrics::quantile(st, 0.999);
+            for(std::map<int, uint64_t>::const_iterator eit=st.errors.begin();eit!=st.errors.end();eit++){
+                errors[std::to_string(eit->first)] = eit->second;
+            }
+            op["errors"] = errors;
+            j["operations"].push_back(op);
+        }
+        out << j.dump();
+    }
+}
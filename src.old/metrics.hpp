@@ -0,0 +1,105 @@
+#ifndef SPRINGY_METRICS
+#define SPRINGY_METRICS
+
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Springy{
+    /**
+     * latency of the filesystem entry points
+     *
+     * every Trace frame of Springy::Fuse, Springy::FuseLowlevel, Springy::FsOps and Springy::Volume is
+     * counted per operation and per volume name (the one the request was tagged
+     * with, see Trace::tagVolume). a frame counts as failed with the errno it
+     * handed to Trace::result() or Trace::status(). each thread writes into histograms only it owns,
+     * using plain relaxed loads and stores - readers merge all threads when
+     * /api/metrics is requested. nothing is recorded with SPRINGY_TRACE_LEVEL=0.
+     *
+     * histograms are log-linear: every power of two is split into 4 linear
+     * buckets, so a quantile is off by at most 25%.
+     */
+    class Metrics{
+        public:
+            static const size_t subBuckets = 4;
+            static const size_t numBuckets = 164; // up to ~36 minutes
+            // distinct errno values kept per histogram, the rest is counted as errno 0
+            static const size_t numErrors = 8;
+
+            struct Stats{
+                uint64_t count;
+                uint64_t sumNs;
+                uint64_t maxNs;
+                uint64_t hist[numBuckets];
+                std::map<int, uint64_t> errors;
+
+                Stats();
+                void merge(const Stats &o);
+                uint64_t errorCount() const;
+            };
+
+            // (operation, volume)
+            typedef std::pair<std::string, std::string> Key;
+            typedef std::map<Key, Stats> StatsMap;
+
+            static size_t bucket(uint64_t ns){
+                if(ns < subBuckets){
+                    return ns;
+                }
+                size_t e = 63 - __builtin_clzll(ns);
+                size_t b = subBuckets + (e-2)*subBuckets + ((ns >> (e-2)) & (subBuckets-1));
+                return b < numBuckets ? b : numBuckets-1;
+            }
+            // largest value falling into the bucket
+            static uint64_t bucketLimit(size_t b){
+                if(b < subBuckets){
+                    return b;
+                }
+                size_t e = (b-subBuckets)/subBuckets + 2;
+                size_t sub = (b-subBuckets)%subBuckets;
+                return ((subBuckets + sub + 1) << (e-2)) - 1;
+            }
+            static uint64_t quantile(const Stats &st, double q);
+
+            // called by ~Trace, result is what Trace::result() was given, negative errno on failure
+            // volume is the number of Trace::tagVolume()
+            static void record(const char *method, uint32_t volume, uint64_t ns, int result);
+
+            static StatsMap snapshot();
+
+            static void prometheus(std::ostream &out);
+            static void json(std::ostream &out);
+
+        protected:
+            struct Counters{
+                const char *method;
+                std::string op;
+                uint32_t volume;
+                Counters *next;
+
+                std::atomic<uint64_t> count;
+                std::atomic<uint64_t> sumNs;
+                std::atomic<uint64_t> maxNs;
+                std::atomic<uint64_t> hist[numBuckets];
+                std::atomic<int> errnos[numErrors];
+                std::atomic<uint64_t> errors[numErrors];
+                std::atomic<uint64_t> otherErrors;
+            };
+            struct ThreadData;
+
+            static std::mutex& registryLock();
+            static std::vector<ThreadData*>& registry();
+            static ThreadData& local();
+            static Counters* counters(ThreadData &td, const char *method, uint32_t volume);
+
+            static std::string operation(const char *method);
+    };
+}
+
+#endif
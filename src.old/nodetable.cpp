@@ -0,0 +1,206 @@
+#include "nodetable.hpp"
+#include "exception.hpp"
+#include "trace.hpp"
+
+#include <vector>
+
+namespace Springy{
+    const uint64_t NodeTable::rootId;
+
+    NodeTable::NodeTable() : nextId(NodeTable::rootId + 1), renameCount(0){
+        Node root;
+        root.parent = NodeTable::rootId;
+        root.nlookup = 1;   // never forgotten
+        root.backendDev = 0;
+        root.backendIno = 0;
+        root.renamed = 0;
+        this->nodes[NodeTable::rootId] = root;
+    }
+
+    uint64_t NodeTable::remember(uint64_t parent, const std::string &name, const struct stat &st, const Location &location){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this);
+
+        ChildKey key(parent, name);
+        std::unordered_map<ChildKey, uint64_t, boost::hash<ChildKey> >::iterator cit = this->children.find(key);
+        if(cit != this->children.end()){
+            Node &n = this->nodes[cit->second];
+            n.nlookup++;
+            n.location = location;
+            n.backendDev = st.st_dev;
+            n.backendIno = st.st_ino;
+            return cit->second;
+        }
+
+        uint64_t id = this->nextId++;
+        Node n;
+        n.parent = parent;
+        n.name = name;
+        n.nlookup = 1;
+        n.location = location;
+        n.backendDev = st.st_dev;
+        n.backendIno = st.st_ino;
+        n.renamed = 0;
+        this->nodes[id] = n;
+        this->children[key] = id;
+        return id;
+    }
+
+    void NodeTable::forget(uint64_t id, uint64_t nlookup){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        if(id == NodeTable::rootId){
+            return;
+        }
+
+        Synchronized syncToken(this);
+
+        std::unordered_map<uint64_t, Node>::iterator it = this->nodes.find(id);
+        if(it == this->nodes.end()){
+            return;
+        }
+        if(it->second.nlookup > nlookup){
+            it->second.nlookup -= nlookup;
+            return;
+        }
+
+        ChildKey key(it->second.parent, it->second.name);
+        std::unordered_map<ChildKey, uint64_t, boost::hash<ChildKey> >::iterator cit = this->children.find(key);
+        if(cit != this->children.end() && cit->second == id){
+            this->children.erase(cit);
+        }
+        this->nodes.erase(it);
+    }
+
+    boost::filesystem::path NodeTable::buildPath(uint64_t id){
+        std::vector<const std::string*> names;
+        while(id != NodeTable::rootId){
+            std::unordered_map<uint64_t, Node>::iterator it = this->nodes.find(id);
+            if(it == this->nodes.end()){
+                throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "unknown node " << id;
+            }
+            names.push_back(&it->second.name);
+            id = it->second.parent;
+        }
+
+        boost::filesystem::path p("/");
+        for(size_t i=names.size();i>0;i--){
+            p /= *names[i-1];
+        }
+        return p;
+    }
+
+    boost::filesystem::path NodeTable::path(uint64_t id){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this, Synchronized::LockType::READ);
+        return this->buildPath(id);
+    }
+
+    boost::filesystem::path NodeTable::path(uint64_t parent, const std::string &name){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this, Synchronized::LockType::READ);
+        return this->buildPath(parent) / name;
+    }
+
+    bool NodeTable::find(const boost::filesystem::path &path, uint64_t &id){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this, Synchronized::LockType::READ);
+
+        uint64_t current = NodeTable::rootId;
+        for(boost::filesystem::path::const_iterator it=path.begin();it!=path.end();it++){
+            if(it->string() == "/" || it->string() == "."){
+                continue;
+            }
+            std::unordered_map<ChildKey, uint64_t, boost::hash<ChildKey> >::iterator cit = this->children.find(ChildKey(current, it->string()));
+            if(cit == this->children.end()){
+                return false;
+            }
+            current = cit->second;
+        }
+        id = current;
+        return true;
+    }
+
+    bool NodeTable::location(uint64_t id, uint64_t volumesGeneration, Location &location){
+        Synchronized syncToken(this, Synchronized::LockType::READ);
+
+        std::unordered_map<uint64_t, Node>::iterator it = this->nodes.find(id);
+        if(it == this->nodes.end() || it->second.location.volume == NULL ||
+           it->second.location.generation != volumesGeneration){
+            return false;
+        }
+
+        // renaming a directory moves everything below it, nothing else
+        uint64_t resolved = it->second.location.renames;
+        for(uint64_t current=id;current!=NodeTable::rootId;){
+            std::unordered_map<uint64_t, Node>::iterator pit = this->nodes.find(current);
+            if(pit == this->nodes.end() || pit->second.renamed > resolved){
+                return false;
+            }
+            current = pit->second.parent;
+        }
+
+        location = it->second.location;
+        return true;
+    }
+
+    void NodeTable::relocate(uint64_t id, const Location &location){
+        Synchronized syncToken(this);
+
+        std::unordered_map<uint64_t, Node>::iterator it = this->nodes.find(id);
+        if(it != this->nodes.end()){
+            it->second.location = location;
+        }
+    }
+
+    void NodeTable::unlinked(uint64_t parent, const std::string &name){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this);
+
+        // the node itself stays until it is forgotten, it is just not reachable by name anymore
+        std::unordered_map<ChildKey, uint64_t, boost::hash<ChildKey> >::iterator cit = this->children.find(ChildKey(parent, name));
+        if(cit != this->children.end()){
+            this->nodes[cit->second].location = Location();
+            this->children.erase(cit);
+        }
+    }
+
+    void NodeTable::renamed(uint64_t parent, const std::string &name, uint64_t newparent, const std::string &newname){
+        Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+        Synchronized syncToken(this);
+
+        this->renameCount++;
+
+        ChildKey to(newparent, newname);
+        std::unordered_map<ChildKey, uint64_t, boost::hash<ChildKey> >::iterator cit = this->children.find(to);
+        if(cit != this->children.end()){
+            // replaced by the rename, like unlinked
+            this->nodes[cit->second].location = Location();
+            this->children.erase(cit);
+        }
+
+        cit = this->children.find(ChildKey(parent, name));
+        if(cit == this->children.end()){
+            return;
+        }
+        uint64_t id = cit->second;
+        this->children.erase(cit);
+
+        // every remembered location of the node and below it is stale now
+        Node &n = this->nodes[id];
+        n.parent = newparent;
+        n.name = newname;
+        n.renamed = this->renameCount.load(std::memory_order_relaxed);
+        this->children[to] = id;
+    }
+
+    uint64_t NodeTable::renames(){
+        return this->renameCount.load(std::memory_order_acquire);
+    }
+}
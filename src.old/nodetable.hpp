@@ -0,0 +1,92 @@
+#ifndef SPRINGY_NODETABLE
+#define SPRINGY_NODETABLE
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "util/synchronized.hpp"
+#include "volume/ivolume.hpp"
+
+namespace Springy{
+    /**
+     * inode numbers of the low level fuse front end
+     *
+     * a node is created by the first lookup of (parent, name) and lives until
+     * the kernel forgot every lookup of it. besides the name it remembers where
+     * the file was found (volume and virtual mount point) together with the
+     * Volumes generation of that moment, so later requests don't have to probe
+     * the volumes again. a resolution made before volumes were added or removed
+     * or before the node or one of its ancestors was renamed is not used anymore.
+     *
+     * paths are not stored but built from the names up to the root, so renaming
+     * a directory doesn't have to touch its descendants.
+     */
+    class NodeTable : public Synchronizable{
+        public:
+            static const uint64_t rootId = 1;
+
+            struct Location{
+                Springy::Volume::IVolume *volume;
+                boost::filesystem::path virtualMountPoint;
+                boost::filesystem::path volumeRelativeFileName;
+                uint64_t generation;    // Volumes::generation() when resolved
+                uint64_t renames;       // NodeTable::renames() when resolved
+
+                Location() : volume(NULL), generation(0), renames(0){}
+            };
+
+            struct Node{
+                uint64_t parent;
+                std::string name;
+                uint64_t nlookup;
+                Location location;
+                dev_t backendDev;   // identity of the file on its volume
+                ino_t backendIno;
+                uint64_t renamed;   // renames() right after the node was last renamed
+            };
+
+            NodeTable();
+
+            // a lookup (or create, mkdir, ...) answered with this node
+            uint64_t remember(uint64_t parent, const std::string &name, const struct stat &st, const Location &location);
+            void forget(uint64_t id, uint64_t nlookup);
+
+            // throw Springy::Exception for unknown ids
+            boost::filesystem::path path(uint64_t id);
+            boost::filesystem::path path(uint64_t parent, const std::string &name);
+            // the node reachable by the given virtual path, false if the kernel doesn't know it
+            bool find(const boost::filesystem::path &path, uint64_t &id);
+
+            // the remembered location, if it is still valid for the given volumes generation
+            // and neither the node nor an ancestor was renamed since it was resolved
+            bool location(uint64_t id, uint64_t volumesGeneration, Location &location);
+            void relocate(uint64_t id, const Location &location);
+
+            void unlinked(uint64_t parent, const std::string &name);
+            void renamed(uint64_t parent, const std::string &name, uint64_t newparent, const std::string &newname);
+
+            // counts renames, taken before resolving a location
+            uint64_t renames();
+
+        protected:
+            typedef std::pair<uint64_t, std::string> ChildKey;
+
+            uint64_t nextId;
+            std::atomic<uint64_t> renameCount;     // read on every request, without the lock
+            std::unordered_map<uint64_t, Node> nodes;
+            std::unordered_map<ChildKey, uint64_t, boost::hash<ChildKey> > children;
+
+            boost::filesystem::path buildPath(uint64_t id);
+    };
+}
+
+#endif
@@ -1,75 +1,282 @@
 #include "openfiles.hpp"
-#include "util/synchronized.hpp"
 #include "exception.hpp"
 
+#include <errno.h>
+
+#include <functional>
+
 namespace Springy{
-    OpenFiles::OpenFiles(){}
-    OpenFiles::~OpenFiles(){}
+    size_t OpenFiles::FileKeyHash::operator()(const FileKey &k) const{
+        size_t h = std::hash<const void*>()(k.volume);
+        h ^= std::hash<std::string>()(k.path) + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+        return h;
+    }
 
-    int OpenFiles::add(boost::filesystem::path volumeFile, Springy::Volume::IVolume *volume, int internalFd, int flags, mode_t mode){
-        Synchronized syncOpenFiles(this->openFiles);
+    OpenFiles::Backing::Backing(Springy::Volume::IVolume *volume, const boost::filesystem::path &volumeFile, int fd) :
+        volume(volume), fd(fd), volumeFile(volumeFile), closed(false){}
+    OpenFiles::Backing::~Backing(){
+        if (this->closed) {
+            return;
+        }
+        try{
+            this->volume->close(this->volumeFile, this->fd);
+        }catch(...){}
+    }
+    int OpenFiles::Backing::close(){
+        this->closed = true;
+        return this->volume->close(this->volumeFile, this->fd);
+    }
 
-        int fd = 0;
+    OpenFiles::OpenFiles(){
+        for(unsigned int i=0;i<OpenFiles::numShards;i++){
+            Shard &s = this->shards[i];
+            s.numChunks = 0;
+            for(unsigned int c=0;c<OpenFiles::maxChunks;c++){
+                s.chunks[c].store(NULL, std::memory_order_relaxed);
+            }
+        }
+    }
+    OpenFiles::~OpenFiles(){
+        for(unsigned int i=0;i<OpenFiles::numShards;i++){
+            Shard &s = this->shards[i];
+            for(unsigned int c=0;c<s.numChunks;c++){
+                delete[] s.chunks[c].load();
+            }
+        }
+    }
 
-        int *syncToken = NULL;
-        openFiles_set::index<of_idx_volumeFile>::type &idx = this->openFiles.get<of_idx_volumeFile>();
-        openFiles_set::index<of_idx_volumeFile>::type::iterator it = idx.find(volumeFile);
-        if (it != idx.end()) {
-            syncToken = it->o.syncToken;
-        } else {
-            syncToken = new int;
+    OpenFiles::Slot* OpenFiles::slot(unsigned int shard, uint32_t slot){
+        uint32_t chunk = slot >> OpenFiles::chunkBits;
+        if (chunk >= OpenFiles::maxChunks) {
+            return NULL;
         }
+        Slot *slots = this->shards[shard].chunks[chunk].load(std::memory_order_acquire);
+        if (slots == NULL) {
+            return NULL;
+        }
+        return &slots[slot & (OpenFiles::chunkSize - 1)];
+    }
 
-        openFiles_set::index<of_idx_fd>::type &fdidx = this->openFiles.get<of_idx_fd>();
-        openFiles_set::index<of_idx_fd>::type::iterator fdit = fdidx.begin();
-        for(;fdit!=fdidx.end();fdit++, fd++){
-            if(fdit->o.fd != fd){
-                break;
+    uint32_t OpenFiles::allocSlot(Shard &s){
+        if (s.freeSlots.empty()) {
+            if (s.numChunks >= OpenFiles::maxChunks) {
+                errno = EMFILE;
+                throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "too many open files";
+            }
+            Slot *slots = new Slot[OpenFiles::chunkSize];
+            for(unsigned int i=0;i<OpenFiles::chunkSize;i++){
+                slots[i].generation.store(1, std::memory_order_relaxed);
+                slots[i].refs = 0;
+                slots[i].open = false;
             }
+            uint32_t first = s.numChunks << OpenFiles::chunkBits;
+            // hand out lower slots first
+            for(uint32_t i=OpenFiles::chunkSize;i>0;i--){
+                s.freeSlots.push_back(first + i - 1);
+            }
+            s.chunks[s.numChunks].store(slots, std::memory_order_release);
+            s.numChunks++;
         }
 
-        OpenFiles::openFile of;
-        of.volumeFile = volumeFile;
-        of.volume = volume;
-        of.fd = internalFd;
-        of.flags = flags;
-        of.syncToken = syncToken;
+        uint32_t slot = s.freeSlots.back();
+        s.freeSlots.pop_back();
+        return slot;
+    }
+
+    uint64_t OpenFiles::add(boost::filesystem::path volumeFile, Springy::Volume::IVolume *volume, int internalFd, int flags, mode_t mode,
+                            const boost::filesystem::path &virtualFile){
+        FileKey key = {volume, volumeFile.string()};
+        unsigned int shard = OpenFiles::shardOf(key.path);
+        Shard &s = this->shards[shard];
+
+        std::lock_guard<std::mutex> lock(s.mutex);
 
-        openFileSetEntry ofse;
-        ofse.o         = of;
-        ofse.fd        = fd;
-        ofse.valid     = true;
+        uint32_t idx = this->allocSlot(s);
+        FileEntry &fe = s.files[key];
+        fe.slots.push_back(idx);
 
-        this->openFiles.insert(ofse);
+        Slot *sl = this->slot(shard, idx);
+        sl->h.volumeFile = volumeFile;
+        sl->h.virtualFile = virtualFile;
+        std::atomic_store(&sl->h.current, std::make_shared<Backing>(volume, volumeFile, internalFd));
+        sl->h.flags = flags;
+        sl->h.mode = mode;
+        sl->h.state = fe.state.get();
+        sl->h.account = IOAccounting::Account();
+        sl->refs = 1; // held by the table until remove()
+        sl->open = true;
 
-        return fd;
+        return OpenFiles::makeId(shard, idx, sl->generation.load(std::memory_order_relaxed));
     }
-    OpenFiles::openFile OpenFiles::getByDescriptor(int fd){
-        Synchronized syncOpenFiles(this->openFiles);
 
-        openFiles_set::index<of_idx_fd>::type &idx = this->openFiles.get<of_idx_fd>();
-        openFiles_set::index<of_idx_fd>::type::iterator it = idx.find(fd);
-        if (it == idx.end()) {
-            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "bad descriptor";
+    OpenFiles::Handle* OpenFiles::get(uint64_t fh){
+        Slot *sl = this->slot(fh & (OpenFiles::numShards - 1), (uint32_t)fh >> OpenFiles::shardBits);
+        if (sl == NULL || sl->generation.load(std::memory_order_acquire) != (uint32_t)(fh >> 32)) {
+            return NULL;
         }
-        return it->o;
+        return &sl->h;
     }
-    void OpenFiles::remove(int fd){
-        Synchronized syncOpenFiles(this->openFiles);
 
-        openFiles_set::index<of_idx_fd>::type &idx = this->openFiles.get<of_idx_fd>();
-        openFiles_set::index<of_idx_fd>::type::iterator it = idx.find(fd);
-        if (it == idx.end()) {
-            throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "bad descriptor";
+    OpenFiles::Handle* OpenFiles::acquire(uint64_t fh){
+        unsigned int shard = fh & (OpenFiles::numShards - 1);
+        Slot *sl = this->slot(shard, (uint32_t)fh >> OpenFiles::shardBits);
+        if (sl == NULL) {
+            errno = EBADF;
+            return NULL;
         }
 
-        int *syncToken = it->o.syncToken;
-        boost::filesystem::path volumeFile = it->o.volumeFile;
-        idx.erase(it);
+        std::lock_guard<std::mutex> lock(this->shards[shard].mutex);
+        if (!sl->open || sl->generation.load(std::memory_order_relaxed) != (uint32_t)(fh >> 32)) {
+            errno = EBADF;
+            return NULL;
+        }
+        sl->refs++;
+        return &sl->h;
+    }
+    void OpenFiles::put(uint64_t fh){
+        unsigned int shard = fh & (OpenFiles::numShards - 1);
+        std::unique_lock<std::mutex> lock(this->shards[shard].mutex);
+        this->unref(shard, (uint32_t)fh >> OpenFiles::shardBits, lock);
+    }
 
-        openFiles_set::index<of_idx_volumeFile>::type &vidx = this->openFiles.get<of_idx_volumeFile>();
-        if (vidx.find(volumeFile) == vidx.end()) {
-            delete syncToken;
+    int OpenFiles::remove(uint64_t fh){
+        unsigned int shard = fh & (OpenFiles::numShards - 1);
+        uint32_t idx = (uint32_t)fh >> OpenFiles::shardBits;
+        Slot *sl = this->slot(shard, idx);
+        if (sl == NULL) {
+            errno = EBADF;
+            return -1;
         }
+
+        std::unique_lock<std::mutex> lock(this->shards[shard].mutex);
+        if (!sl->open || sl->generation.load(std::memory_order_relaxed) != (uint32_t)(fh >> 32)) {
+            errno = EBADF;
+            return -1;
+        }
+        sl->open = false;
+        return this->unref(shard, idx, lock);
+    }
+
+    int OpenFiles::unref(unsigned int shard, uint32_t idx, std::unique_lock<std::mutex> &lock){
+        Slot *sl = this->slot(shard, idx);
+        if (--sl->refs > 0) {
+            return 0;
+        }
+
+        Shard &s = this->shards[shard];
+
+        std::shared_ptr<Backing> backing = std::atomic_exchange(&sl->h.current, std::shared_ptr<Backing>());
+
+        FileKey key = {backing->volume, sl->h.volumeFile.string()};
+        std::unordered_map<FileKey, FileEntry, FileKeyHash>::iterator it = s.files.find(key);
+        if (it != s.files.end()) {
+            std::vector<uint32_t> &slots = it->second.slots;
+            for(size_t i=0;i<slots.size();i++){
+                if (slots[i] == idx) {
+                    slots[i] = slots.back();
+                    slots.pop_back();
+                    break;
+                }
+            }
+            if (slots.empty()) {
+                s.files.erase(it);
+            }
+        }
+
+        sl->h.volumeFile.clear();
+        sl->h.virtualFile.clear();
+        sl->h.state = NULL;
+        sl->h.account = IOAccounting::Account();
+        sl->generation.fetch_add(1, std::memory_order_release);
+        s.freeSlots.push_back(idx);
+
+        lock.unlock();
+        // a request still working with the descriptor closes it when it is done
+        if (backing.use_count() > 1) {
+            return 0;
+        }
+        return backing->close();
+    }
+
+    std::vector<uint64_t> OpenFiles::handles(Springy::Volume::IVolume *volume, const boost::filesystem::path &volumeFile){
+        FileKey key = {volume, volumeFile.string()};
+        unsigned int shard = OpenFiles::shardOf(key.path);
+        Shard &s = this->shards[shard];
+
+        std::vector<uint64_t> result;
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        std::unordered_map<FileKey, FileEntry, FileKeyHash>::iterator it = s.files.find(key);
+        if (it == s.files.end()) {
+            return result;
+        }
+        for(size_t i=0;i<it->second.slots.size();i++){
+            uint32_t idx = it->second.slots[i];
+            Slot *sl = this->slot(shard, idx);
+            if (sl->open) {
+                result.push_back(OpenFiles::makeId(shard, idx, sl->generation.load(std::memory_order_relaxed)));
+            }
+        }
+        return result;
+    }
+
+    std::shared_ptr<OpenFiles::FileState> OpenFiles::state(Springy::Volume::IVolume *volume, const boost::filesystem::path &volumeFile){
+        FileKey key = {volume, volumeFile.string()};
+        Shard &s = this->shards[OpenFiles::shardOf(key.path)];
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        std::unordered_map<FileKey, FileEntry, FileKeyHash>::iterator it = s.files.find(key);
+        if (it == s.files.end()) {
+            return std::shared_ptr<FileState>();
+        }
+        return it->second.state;
+    }
+
+    int OpenFiles::relocate(Springy::Volume::IVolume *from, const boost::filesystem::path &volumeFile, Springy::Volume::IVolume *to,
+                            const std::map<uint64_t, int> &descriptors){
+        FileKey key = {from, volumeFile.string()};
+        FileKey newKey = {to, volumeFile.string()};
+        unsigned int shard = OpenFiles::shardOf(key.path);
+        Shard &s = this->shards[shard];
+
+        // destroyed after the lock is released, the last reference closes the descriptor
+        std::vector<std::shared_ptr<Backing> > replaced;
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        std::unordered_map<FileKey, FileEntry, FileKeyHash>::iterator it = s.files.find(key);
+        if (it == s.files.end()) {
+            errno = EBADF;
+            return -1;
+        }
+        if (s.files.find(newKey) != s.files.end()) {
+            errno = EEXIST;
+            return -1;
+        }
+
+        // all or nothing
+        std::vector<std::pair<Slot*, int> > moves;
+        for(size_t i=0;i<it->second.slots.size();i++){
+            uint32_t idx = it->second.slots[i];
+            Slot *sl = this->slot(shard, idx);
+            std::map<uint64_t, int>::const_iterator dit = descriptors.find(OpenFiles::makeId(shard, idx, sl->generation.load(std::memory_order_relaxed)));
+            if (!sl->open || dit == descriptors.end()) {
+                errno = EBUSY;
+                return -1;
+            }
+            moves.push_back(std::make_pair(sl, dit->second));
+        }
+
+        for(size_t i=0;i<moves.size();i++){
+            Slot *sl = moves[i].first;
+            replaced.push_back(std::atomic_exchange(&sl->h.current, std::make_shared<Backing>(to, volumeFile, moves[i].second)));
+        }
+
+        // references survive the rehash of inserting newKey, iterators don't
+        FileEntry &old = it->second;
+        FileEntry &fe = s.files[newKey];
+        fe.state.swap(old.state);
+        fe.slots.swap(old.slots);
+        s.files.erase(key);
+        return 0;
     }
-}
\ No newline at end of file
+}
@@ -1,67 +1,182 @@
 #ifndef SPRINGY_OPENFILES_HPP
 #define SPRINGY_OPENFILES_HPP
 
-#include <boost/filesystem.hpp>
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/identity.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/mem_fun.hpp>
+#include <boost/filesystem.hpp>
 
 #include "volume/ivolume.hpp"
+#include "util/rangelock.hpp"
+#include "ioaccounting.hpp"
 
 namespace Springy{
+    /**
+     * table of open files
+     *
+     * handles live in fixed size chunks of slots which are never moved or freed
+     * while the table exists. the id handed out (and stored in fuse_file_info::fh)
+     * encodes shard, slot and the slot's generation, so get() resolves it with
+     * two array lookups and a generation compare - no lock, no search.
+     * a slot is recycled through its shard's free list once the handle has been
+     * removed and the last reference is gone, which bumps the generation and
+     * turns every id still pointing at it into a stale one.
+     *
+     * the shard is chosen by the volume relative path of the backing file, thus
+     * all handles of a file share one shard and its per file index (FileState,
+     * handles()), even after the file was relocated to another volume.
+     */
     class OpenFiles{
         public:
-            struct openFile{
-                boost::filesystem::path volumeFile;
+            // state shared by all handles of the same backing file
+            struct FileState{
+                Springy::Util::RangeLock ranges;
+            };
+
+            // volume and descriptor a handle works through. relocate() puts a new
+            // one in place, whoever still uses the previous one keeps it open:
+            // the descriptor is closed when the last reference is dropped
+            class Backing{
+                public:
+                    ::Springy::Volume::IVolume *const volume;
+                    const int fd;
+
+                    Backing(::Springy::Volume::IVolume *volume, const boost::filesystem::path &volumeFile, int fd);
+                    ~Backing();
 
-                ::Springy::Volume::IVolume *volume;
+                    // closes right away instead of with the last reference, the result of the volume's close
+                    int close();
 
-                int fd; // file descriptor is unique
-                int flags;
-                mode_t mode;
+                protected:
+                    boost::filesystem::path volumeFile;
+                    bool closed;
 
-                mutable int *syncToken;
+                private:
+                    Backing(const Backing&);
+                    Backing& operator=(const Backing&);
+            };
+
+            class Handle{
+                friend class OpenFiles;
+
+                public:
+                    boost::filesystem::path volumeFile;
+                    // the name it was opened by, for front ends which don't pass one on release
+                    boost::filesystem::path virtualFile;
+
+                    int flags;
+                    mode_t mode;
+
+                    FileState *state;
+
+                    // set by the FsOps after opening
+                    IOAccounting::Account account;
+
+                    // volume and descriptor as one snapshot, usable as long as the reference is held
+                    std::shared_ptr<Backing> backing() const{ return std::atomic_load(&this->current); }
+
+                protected:
+                    std::shared_ptr<Backing> current;
             };
 
         protected:
-                struct of_idx_volumeFile{};
-                struct of_idx_fd{};
-                struct openFileSetEntry{
-                    OpenFiles::openFile o;
+                static const unsigned int shardBits = 4;
+                static const unsigned int numShards = 1 << shardBits;
+                static const unsigned int chunkBits = 10;
+                static const unsigned int chunkSize = 1 << chunkBits;
+                static const unsigned int maxChunks = 1024; // 1M handles per shard
+
+                struct Slot{
+                    Handle h;
+                    std::atomic<uint32_t> generation;
+                    unsigned int refs;
+                    bool open;
+                };
+
+                struct FileKey{
+                    ::Springy::Volume::IVolume *volume;
+                    std::string path;
 
-                    int fd;
+                    bool operator==(const FileKey &other) const{
+                        return this->volume == other.volume && this->path == other.path;
+                    }
+                };
+                struct FileKeyHash{
+                    size_t operator()(const FileKey &k) const;
+                };
+                struct FileEntry{
+                    // handles point to it, it stays put when the entry is re-keyed by relocate().
+                    // shared with path based operations, which may hold it beyond the entry
+                    std::shared_ptr<FileState> state;
+                    std::vector<uint32_t> slots;
 
-                    mutable bool valid;
-                    bool operator<(const openFileSetEntry& of)const{return o.fd < of.o.fd; }
-                    bool isLocal()const{ return o.volume->isLocal(); }
-                    boost::filesystem::path volumeFile()const{ return o.volumeFile; }
+                    FileEntry() : state(std::make_shared<FileState>()){}
                 };
 
-                typedef boost::multi_index::multi_index_container<
-                  openFileSetEntry,
-                  boost::multi_index::indexed_by<
-                    // sort by openFile::operator<
-                    boost::multi_index::ordered_unique<boost::multi_index::tag<of_idx_fd>, boost::multi_index::member<openFileSetEntry,int,&openFileSetEntry::fd> >,
+                struct Shard{
+                    std::mutex mutex;
+                    std::atomic<Slot*> chunks[maxChunks];
+                    unsigned int numChunks;
+                    std::vector<uint32_t> freeSlots;
+                    std::unordered_map<FileKey, FileEntry, FileKeyHash> files;
+                };
 
-                    // sort by less<string> on name
-                    boost::multi_index::ordered_non_unique<boost::multi_index::tag<of_idx_volumeFile>, boost::multi_index::const_mem_fun<openFileSetEntry,boost::filesystem::path,&openFileSetEntry::volumeFile> >,
-                    boost::multi_index::ordered_non_unique<boost::multi_index::const_mem_fun<openFileSetEntry,bool,&openFileSetEntry::isLocal> >
-                  > 
-                > openFiles_set;
+                Shard shards[numShards];
+
+                static unsigned int shardOf(const std::string &volumeFile){
+                    return std::hash<std::string>()(volumeFile) % numShards;
+                }
+                static uint64_t makeId(unsigned int shard, uint32_t slot, uint32_t generation){
+                    return ((uint64_t)generation << 32) | ((uint64_t)slot << shardBits) | shard;
+                }
+                Slot* slot(unsigned int shard, uint32_t slot);
+                uint32_t allocSlot(Shard &s);
+                int unref(unsigned int shard, uint32_t slot, std::unique_lock<std::mutex> &lock);
 
-                openFiles_set openFiles;
         public:
             OpenFiles();
             ~OpenFiles();
 
-            int add(boost::filesystem::path volumeFile, ::Springy::Volume::IVolume *volume, int internalFd, int flags, mode_t mode=0);
-            openFile getByDescriptor(int fd);
-            void remove(int fd);
+            uint64_t add(boost::filesystem::path volumeFile, ::Springy::Volume::IVolume *volume, int internalFd, int flags, mode_t mode=0,
+                         const boost::filesystem::path &virtualFile=boost::filesystem::path());
+
+            // resolves an id returned by add() without locking, NULL if it is stale or
+            // unknown. fuse never sends an fh after its release, so the handle stays
+            // valid for the request. callers with ids from elsewhere use acquire()
+            Handle* get(uint64_t fh);
+
+            // like get() but takes a reference that has to be given back with put().
+            // NULL with errno EBADF if the id is unknown
+            Handle* acquire(uint64_t fh);
+            void put(uint64_t fh);
+
+            // unregisters the handle, the backend descriptor is closed as soon as
+            // the last reference is gone. returns the result of the close if that
+            // happened immediately, otherwise 0. -1 with errno EBADF for an unknown id
+            int remove(uint64_t fh);
+
+            // ids of all open handles of the given backing file
+            std::vector<uint64_t> handles(::Springy::Volume::IVolume *volume, const boost::filesystem::path &volumeFile);
+
+            // state of the given backing file, NULL if it isn't open. path based
+            // operations lock its ranges the way the handles' operations do
+            std::shared_ptr<FileState> state(::Springy::Volume::IVolume *volume, const boost::filesystem::path &volumeFile);
+
+            // moves every handle of a backing file to the file of the same name on
+            // another volume. descriptors maps each handle id to its descriptor on
+            // the new volume, the replaced ones are closed once no request uses them
+            // anymore. fails with EBUSY if a handle is missing in descriptors or
+            // still referenced after its release
+            int relocate(::Springy::Volume::IVolume *from, const boost::filesystem::path &volumeFile, ::Springy::Volume::IVolume *to,
+                         const std::map<uint64_t, int> &descriptors);
     };
 }
 
 #endif /* OPENFILES_HPP */
-
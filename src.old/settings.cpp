@@ -3,8 +3,11 @@
 #include "libc/ilibc.hpp"
 
 namespace Springy{
-    Settings::Settings(Springy::LibC::ILibC *libc) : volumes(libc) {
+    Settings::Settings(Springy::LibC::ILibC *libc) : volumes(libc), changes(libc) {
         this->httpdPort = 0;
+        this->fuseMaxThreads = 0;
+        this->fuseMaxIdleThreads = 0;
+        this->cacheTimeout = 0;
     }
 /*
     Settings::Settings(std::string id){
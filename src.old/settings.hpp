@@ -12,6 +12,9 @@
 #include "exception.hpp"
 #include "volumes.hpp"
 #include "openfiles.hpp"
+#include "ioaccounting.hpp"
+#include "changenotifier.hpp"
+#include "cachepolicy.hpp"
 
 namespace Springy{
     class Settings{
@@ -24,6 +27,9 @@ namespace Springy{
 
             Springy::Volumes volumes;
             Springy::OpenFiles openFiles;
+            Springy::IOAccounting accounting;
+            Springy::ChangeNotifier changes;
+            Springy::CachePolicy cachePolicy;
 
             boost::filesystem::path mountpoint;
             std::set<std::string> options;
@@ -31,6 +37,13 @@ namespace Springy{
 
             int httpdPort;
 
+            // fuse worker pool (--max-threads, --max-idle-threads), 0 keeps libfuse's default
+            unsigned fuseMaxThreads;
+            unsigned fuseMaxIdleThreads;
+
+            // seconds the kernel may cache names and attributes (--cache-timeout), 0 keeps libfuse's default
+            double cacheTimeout;
+
         protected:
 /*
             boost::logic::tribool bOverwriteSettings;
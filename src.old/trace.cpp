@@ -1,109 +1,163 @@
 #include "trace.hpp"
+#include "metrics.hpp"
+#include "flightrecorder.hpp"
+#include "volume/ivolume.hpp"
 
-#include <boost/exception/diagnostic_information.hpp> 
+#if SPRINGY_TRACE_LEVEL > 0
 
-namespace Springy{
-    std::map<std::thread::id, std::vector<struct Springy::Trace::entry> > Trace::currentTraces;
-    std::map<std::thread::id, int> Trace::traceDepth;
-
-    Trace::Trace(const char *file, const char *method, int line){
-        //std::cout << file << ":" << method << ":" << line << std::endl;
-
-        this->referenceCounter = new int;
-        *this->referenceCounter = 0;
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
-        struct entry e;
-        e.file   = file;
-        e.method = method;
-        e.line   = line;
-        e.now    = std::chrono::system_clock::now();
-        e.err = errno;
-
-        std::thread::id current_thread_id = std::this_thread::get_id();
+#include <boost/exception/diagnostic_information.hpp>
 
-        Synchronized syncToken(this->currentTraces);
+namespace Springy{
+    static std::mutex& volumesLock(){
+        static std::mutex *lock = new std::mutex();
+        return *lock;
+    }
+    // id - 1 -> name, never shrinks
+    static std::vector<std::string>& volumeNames(){
+        static std::vector<std::string> *names = new std::vector<std::string>();
+        return *names;
+    }
 
-        if(this->traceDepth.find(current_thread_id) == this->traceDepth.end()){
-            this->traceDepth[current_thread_id] = 0;
-        }
-        else{
-            this->traceDepth[current_thread_id]++;
+    void Trace::tagVolume(Springy::Volume::IVolume *volume){
+        if(volume == NULL){
+            Trace::ring().volume = 0;
+            return;
         }
 
-        this->depthIdx = this->traceDepth[current_thread_id];
+        uint32_t id = volume->traceId.load(std::memory_order_relaxed);
+        if(id == 0){
+            // a volume added again after it was removed gets its old number
+            std::string name = volume->string();
+            static std::unordered_map<std::string, uint32_t> *ids = new std::unordered_map<std::string, uint32_t>();
+
+            std::lock_guard<std::mutex> lock(volumesLock());
+            std::unordered_map<std::string, uint32_t>::iterator it = ids->find(name);
+            if(it != ids->end()){
+                id = it->second;
+            }
+            else{
+                volumeNames().push_back(name);
+                id = volumeNames().size();
+                (*ids)[name] = id;
+            }
+            volume->traceId.store(id, std::memory_order_relaxed);
+        }
+        Trace::ring().volume = id;
+    }
 
-        if(this->currentTraces[current_thread_id].size() > (std::size_t)depthIdx){
-            this->currentTraces[current_thread_id].erase(this->currentTraces[current_thread_id].begin() + this->traceDepth[current_thread_id],
-                                                         this->currentTraces[current_thread_id].end());
+    std::string Trace::volumeName(uint32_t id){
+        if(id == 0){
+            return std::string();
         }
-        this->currentTraces[current_thread_id].push_back(e);
+        std::lock_guard<std::mutex> lock(volumesLock());
+        return id <= volumeNames().size() ? volumeNames()[id-1] : std::string();
     }
-    Trace::Trace(const Trace& t){
-        this->depthIdx = t.depthIdx;
-        this->referenceCounter = t.referenceCounter;
-        (*this->referenceCounter)++;
+
+    uint64_t Trace::wallClock(uint64_t ns){
+        // taken once, a later change of the wall clock shifts printed times only
+        static const int64_t offset = [](){
+            struct timespec real, mono;
+            clock_gettime(CLOCK_REALTIME, &real);
+            clock_gettime(CLOCK_MONOTONIC, &mono);
+            return ((int64_t)real.tv_sec - mono.tv_sec) * 1000000000LL + ((int64_t)real.tv_nsec - mono.tv_nsec);
+        }();
+        return ns + offset;
     }
-    Trace::~Trace(){
-        if(*this->referenceCounter > 0){
-            (*this->referenceCounter)--;
+
+    void Trace::append(const std::string &s){
+        Record &rec = Trace::ring().records[this->seq % ringSize];
+        if(rec.seq != this->seq){
+            // overwritten meanwhile, or appended from another thread
             return;
         }
-        delete this->referenceCounter;
-
-        std::thread::id current_thread_id = std::this_thread::get_id();
-
-        Synchronized syncToken(this->currentTraces);
+        size_t len = strlen(rec.msg);
+        size_t n = std::min(s.length(), sizeof(rec.msg) - 1 - len);
+        memcpy(rec.msg + len, s.data(), n);
+        rec.msg[len + n] = '\0';
+    }
 
-        this->traceDepth[current_thread_id]--;
+    void Trace::finish(const Ring &r){
+        int err = errno;
+        const Record &rec = r.records[this->seq % ringSize];
+        if(rec.seq == this->seq){
+            uint64_t end = Trace::now();
+            Metrics::record(rec.method, r.volume, end - rec.ns, rec.result);
+            if(FlightRecorder::enabled()){
+                // errno may be left over from anything the frame called, result() is what it failed with
+                FlightRecorder::record(rec.file, rec.method, rec.line, rec.depth, rec.result < 0 ? -rec.result : 0, Trace::wallClock(rec.ns), Trace::wallClock(end), FlightRecorder::volumeId(r.volume));
+            }
+        }
+        errno = err;
     }
 
     void Trace::log(const char *file, const char *method, int line, std::string msg){
+        int err = errno;
+
         this->log();
 
-        struct entry e;
+        Record e;
         e.file = file;
         e.line = line;
         e.method = method;
-        e.msg = msg;
+        e.depth = Trace::ring().depth;
+        e.seq = 0;
+        e.msg[0] = '\0';
 
-        // if a currently catched exception exists and 
+        // if a currently catched exception exists and
         std::exception_ptr p = std::current_exception();
         if(p && std::string(p.__cxa_exception_type()->name()).find("Springy") == std::string::npos){
-            e.msg.append(":").append(boost::current_exception_diagnostic_information());
+            msg.append(":").append(boost::current_exception_diagnostic_information());
         }
 
-        e.err = errno;
-        e.now = std::chrono::system_clock::now();
-        this->log(e);
+        e.err = err;
+        e.result = 0;
+        e.ns = Trace::now();
+        Trace::print(e);
+        if(msg.length()){
+            std::cout << "    " << msg << std::endl;
+        }
+        errno = err;
     }
     void Trace::log(){
-        std::thread::id current_thread_id = std::this_thread::get_id();
-
-        Synchronized syncToken(Trace::currentTraces);
+        int err = errno;
 
-        for(std::size_t i=this->depthIdx;i < Trace::currentTraces[current_thread_id].size();i++){
-            struct entry &e = Trace::currentTraces[current_thread_id][i];
-            this->log(e);
+        Ring &r = Trace::ring();
+        uint64_t from = this->seq;
+        if(r.head - from > ringSize){
+            std::cout << "... " << (r.head - from - ringSize) << " trace records overwritten" << std::endl;
+            from = r.head - ringSize;
         }
+        for(uint64_t i=from;i<r.head;i++){
+            Trace::print(r.records[i % ringSize]);
+        }
+
+        errno = err;
     }
 
-    void Trace::log(struct entry e){
-        std::chrono::microseconds us = std::chrono::duration_cast<std::chrono::microseconds>(e.now.time_since_epoch());
+    void Trace::print(const Record &e){
+        uint64_t ns = Trace::wallClock(e.ns);
+        std::time_t t = ns / 1000000000ULL;
+        std::size_t fractional_seconds = (ns / 1000) % 1000000;
 
-        std::chrono::seconds s = std::chrono::duration_cast<std::chrono::seconds>(us);
-        std::time_t t = s.count();
-        std::size_t fractional_seconds = us.count() % 1000000;
-        
-        std::tm * ptm = std::localtime(&t);
+        std::tm tm;
+        localtime_r(&t, &tm);
         char buffer[32];
         // Format: Do, 01.01.1970 00:00:00
-        std::strftime(buffer, 32, "%a, %Y-%m-%d %H:%M:%S", ptm);
+        std::strftime(buffer, 32, "%a, %Y-%m-%d %H:%M:%S", &tm);
 
         std::cout << e.file << ":" << e.method << ":" << e.line << "  [" << buffer << "." << fractional_seconds << "]";
         std::cout << " (" << e.err << "|" << strerror(e.err) << ")";
-        if(e.msg.length()){
+        if(e.msg[0] != '\0'){
             std::cout << " " << e.msg;
         }
         std::cout << std::endl;
     }
 }
+
+#endif
@@ -1,59 +1,178 @@
 #ifndef SPRINGY_TRACE
 #define SPRINGY_TRACE
 
-#include "util/synchronized.hpp"
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
 
-#include <map>
-#include <vector>
-#include <chrono>
+#include <cstring>
 #include <sstream>
+#include <string>
+
+/*
+ * SPRINGY_TRACE_LEVEL
+ *   0  tracing compiled out, Trace is an empty object
+ *   1  calls are recorded into a per thread ring, printed only by log() (default)
+ *   2  like 1, and every call is printed when it is entered
+ */
+#ifndef SPRINGY_TRACE_LEVEL
+#define SPRINGY_TRACE_LEVEL 1
+#endif
 
 namespace Springy{
-    class Trace{
-        protected:
-            Trace();
+    namespace Volume{
+        class IVolume;
+    }
 
-            struct entry{
+#if SPRINGY_TRACE_LEVEL > 0
+    class Trace{
+        public:
+            // fixed size and free of pointers to anything but static strings,
+            // so writing one is a couple of stores
+            struct Record{
                 const char *file;
                 const char *method;
                 int line;
-                std::chrono::system_clock::time_point now;
+                int depth;
                 int err;
+                int result;     // see result()
+                uint64_t seq;   // position in the ring, detects overwritten slots
+                uint64_t ns;    // CLOCK_MONOTONIC, see wallClock()
+                char msg[96];   // filled by operator<<, truncated
+            };
+
+            static const size_t ringSize = 256;
 
-                std::string msg;
+            struct Ring{
+                Record records[ringSize];
+                uint64_t head;  // next sequence number
+                int depth;
+                uint32_t volume;    // see tagVolume(), 0 for none
             };
 
-            int depthIdx;
-            int *referenceCounter;
+            // the calling thread's ring. no locks, no allocation
+            static Ring& ring(){
+                static thread_local Ring r;
+                return r;
+            }
+
+        protected:
+            Trace(){ this->seq = 0; this->owner = false; }
+
+            uint64_t seq;
+            bool owner;
+
+            // durations must not jump with the wall clock
+            static uint64_t now(){
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+            }
+            // now() as wall clock, for printing and the flight recorder file
+            static uint64_t wallClock(uint64_t ns);
+            static uint64_t record(const char *file, const char *method, int line, int depth){
+                Ring &r = Trace::ring();
+                uint64_t seq = r.head++;
+                Record &rec = r.records[seq % ringSize];
+                rec.file   = file;
+                rec.method = method;
+                rec.line   = line;
+                rec.depth  = depth;
+                rec.err    = errno;
+                rec.result = 0;
+                rec.seq    = seq;
+                rec.ns     = Trace::now();
+                rec.msg[0] = '\0';
+                return seq;
+            }
 
-            void log(struct entry e);
+            void append(const std::string &s);
+            // hands the finished frame to Metrics and FlightRecorder
+            void finish(const Ring &r);
+            static void print(const Record &rec);
 
         public:
-            static std::map<std::thread::id, std::vector<struct entry> > currentTraces;
-            static std::map<std::thread::id, int> traceDepth;
+            Trace(const char *file, const char *method, int line){
+                Ring &r = Trace::ring();
+                this->seq = Trace::record(file, method, line, r.depth++);
+                this->owner = true;
+#if SPRINGY_TRACE_LEVEL > 1
+                Trace::print(r.records[this->seq % ringSize]);
+#endif
+            }
+            // copies (e.g. the one inside a thrown Springy::Exception) refer to the
+            // same record, only the original one closes the frame
+            Trace(const Trace& t){
+                this->seq = t.seq;
+                this->owner = false;
+            }
+            ~Trace(){
+                if(this->owner){
+                    Ring &r = Trace::ring();
+                    r.depth--;
+                    this->finish(r);
+                    if(r.depth == 0){
+                        r.volume = 0;
+                    }
+                }
+            }
 
-            Trace(const char *file, const char *method, int line);
-            Trace(const Trace& t);
-            ~Trace();
+            // attributes the frames of the current request to a volume (Metrics, FlightRecorder).
+            // volumes are numbered by name on their first tag, the names are kept for
+            // good, the volume may be gone when the frames end
+            static void tagVolume(Springy::Volume::IVolume *volume);
+            // name of a number handed out by tagVolume(), empty for 0
+            static std::string volumeName(uint32_t id);
 
-            void log(const char *file, const char *method, int line, std::string msg=std::string());
+            // remembers the return value of the frame, negative values count as -errno in Metrics
+            template<typename T>
+            T result(T res){
+                Record &rec = Trace::ring().records[this->seq % ringSize];
+                if(rec.seq == this->seq){
+                    rec.result = res < 0 ? (int)res : 0;
+                }
+                return res;
+            }
+            // same for calls returning -1 and setting errno (Volume::IVolume)
+            template<typename T>
+            T status(T res){
+                if(res == (T)-1){
+                    this->result(-errno);
+                }
+                return res;
+            }
+
+            // prints this frame and every call made beneath it that is still in the ring
             void log();
+            void log(const char *file, const char *method, int line, std::string msg=std::string());
 
             template<typename T>
             Trace& operator<<(T arg){
-                std::thread::id current_thread_id = std::this_thread::get_id();
-
-                Synchronized syncToken(Trace::currentTraces);
-
                 std::ostringstream o;
                 o << arg;
-                if(Trace::traceDepth.find(current_thread_id) != Trace::traceDepth.end() &&
-                   Trace::currentTraces[current_thread_id].size() > (std::size_t)Trace::traceDepth[current_thread_id]){
-                    Trace::currentTraces[current_thread_id][Trace::traceDepth[current_thread_id]].msg.append(o.str());
-                }
-
+                this->append(o.str());
                 return *this;
             }
     };
+#else
+    class Trace{
+        public:
+            Trace(){}
+            Trace(const char *file, const char *method, int line){}
+
+            static void tagVolume(Springy::Volume::IVolume *volume){}
+            static std::string volumeName(uint32_t id){ return std::string(); }
+            template<typename T>
+            T result(T res){ return res; }
+            template<typename T>
+            T status(T res){ return res; }
+
+            void log(){}
+            void log(const char *file, const char *method, int line, std::string msg=std::string()){}
+
+            template<typename T>
+            Trace& operator<<(T arg){ return *this; }
+    };
+#endif
 }
 #endif
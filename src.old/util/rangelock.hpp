@@ -0,0 +1,108 @@
+#ifndef SPRINGY_UTIL_RANGELOCK
+#define SPRINGY_UTIL_RANGELOCK
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+
+namespace Springy{
+    namespace Util{
+        /**
+         * byte range lock
+         *
+         * holders of non overlapping ranges don't block each other. overlapping
+         * ranges are granted together only if all of them are shared.
+         * a length of 0 locks from start up to the end of the file (and beyond),
+         * same as with fcntl().
+         *
+         * conflicting requests are granted in arrival order: a range also waits
+         * for earlier waiters it conflicts with, so a stream of shared readers
+         * can't starve an exclusive (e.g. whole file) request.
+         */
+        class RangeLock{
+            protected:
+                struct Range{
+                    uint64_t start;
+                    uint64_t end; // exclusive
+                    bool exclusive;
+                };
+
+            public:
+                class Guard{
+                    protected:
+                        RangeLock *rl;
+                        std::list<RangeLock::Range>::iterator it;
+
+                    public:
+                        Guard(RangeLock &rl, off_t start, off_t length, bool exclusive=true) : rl(&rl){
+                            this->it = this->rl->lock(start, length, exclusive);
+                        }
+                        ~Guard(){
+                            this->rl->unlock(this->it);
+                        }
+
+                    private:
+                        Guard(const Guard&);
+                        Guard& operator=(const Guard&);
+                };
+
+                RangeLock(){}
+
+            protected:
+                std::mutex mutex;
+                std::condition_variable released;
+                std::list<Range> held;
+                std::list<Range> waiting; // in arrival order
+
+                static bool conflicts(const Range &a, const Range &b){
+                    return a.start < b.end && b.start < a.end && (a.exclusive || b.exclusive);
+                }
+                bool blocked(std::list<Range>::iterator self){
+                    for(std::list<Range>::iterator it=this->held.begin();it!=this->held.end();it++){
+                        if(RangeLock::conflicts(*it, *self)){
+                            return true;
+                        }
+                    }
+                    for(std::list<Range>::iterator it=this->waiting.begin();it!=self;it++){
+                        if(RangeLock::conflicts(*it, *self)){
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                std::list<Range>::iterator lock(off_t start, off_t length, bool exclusive){
+                    Range r;
+                    r.start = start < 0 ? 0 : start;
+                    r.end = length <= 0 ? UINT64_MAX : r.start + length;
+                    r.exclusive = exclusive;
+
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    std::list<Range>::iterator self = this->waiting.insert(this->waiting.end(), r);
+                    while(this->blocked(self)){
+                        this->released.wait(lock);
+                    }
+                    // whoever waited behind it conflicts with the held range now, no wakeup needed
+                    std::list<Range>::iterator it = this->held.insert(this->held.end(), r);
+                    this->waiting.erase(self);
+                    return it;
+                }
+                void unlock(std::list<Range>::iterator it){
+                    {
+                        std::lock_guard<std::mutex> lock(this->mutex);
+                        this->held.erase(it);
+                    }
+                    this->released.notify_all();
+                }
+
+            private:
+                RangeLock(const RangeLock&);
+                RangeLock& operator=(const RangeLock&);
+        };
+    }
+}
+
+#endif
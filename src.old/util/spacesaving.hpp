@@ -0,0 +1,122 @@
+#ifndef SPRINGY_UTIL_SPACESAVING
+#define SPRINGY_UTIL_SPACESAVING
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace Springy{
+    namespace Util{
+        /**
+         * heavy hitters with bounded memory (space saving, Metwally et al.)
+         *
+         * at most capacity keys are tracked. a new key replaces the one with the
+         * smallest count and inherits that count as its error, so count is an upper
+         * bound and count - error a lower bound of the key's true weight. every key
+         * whose weight is above total/capacity is guaranteed to be tracked.
+         *
+         * the entries form a binary min-heap on count, so the key to replace is
+         * the root and every add() is O(log capacity).
+         *
+         * not thread safe.
+         */
+        template<typename Key, typename Hash=std::hash<Key> >
+        class SpaceSaving{
+            public:
+                struct Entry{
+                    Key key;
+                    uint64_t count;
+                    uint64_t error;
+                };
+
+                SpaceSaving(size_t capacity) : capacity(capacity), total(0){
+                    this->entries.reserve(capacity);
+                }
+
+                void add(const Key &key, uint64_t weight=1){
+                    this->total += weight;
+
+                    typename std::unordered_map<Key, size_t, Hash>::iterator it = this->index.find(key);
+                    if(it != this->index.end()){
+                        this->entries[it->second].count += weight;
+                        this->siftDown(it->second);
+                        return;
+                    }
+
+                    if(this->entries.size() < this->capacity){
+                        Entry e = {key, weight, 0};
+                        this->index[key] = this->entries.size();
+                        this->entries.push_back(e);
+                        this->siftUp(this->entries.size() - 1);
+                        return;
+                    }
+
+                    Entry &e = this->entries[0];
+                    this->index.erase(e.key);
+                    e.key = key;
+                    e.error = e.count;
+                    e.count += weight;
+                    this->index[key] = 0;
+                    this->siftDown(0);
+                }
+
+                // sorted by count, largest first
+                std::vector<Entry> top(size_t n) const{
+                    std::vector<Entry> result(this->entries);
+                    std::sort(result.begin(), result.end(), [](const Entry &a, const Entry &b){
+                        return a.count > b.count;
+                    });
+                    if(result.size() > n){
+                        result.resize(n);
+                    }
+                    return result;
+                }
+
+                uint64_t weight() const{ return this->total; }
+
+            protected:
+                size_t capacity;
+                uint64_t total;
+                std::vector<Entry> entries;                 // min-heap on count
+                std::unordered_map<Key, size_t, Hash> index;    // key -> position in entries
+
+                void swap(size_t a, size_t b){
+                    std::swap(this->entries[a], this->entries[b]);
+                    this->index[this->entries[a].key] = a;
+                    this->index[this->entries[b].key] = b;
+                }
+                void siftUp(size_t i){
+                    while(i > 0){
+                        size_t parent = (i - 1) / 2;
+                        if(this->entries[parent].count <= this->entries[i].count){
+                            return;
+                        }
+                        this->swap(i, parent);
+                        i = parent;
+                    }
+                }
+                void siftDown(size_t i){
+                    for(;;){
+                        size_t min = i;
+                        size_t left = 2 * i + 1;
+                        size_t right = left + 1;
+                        if(left < this->entries.size() && this->entries[left].count < this->entries[min].count){
+                            min = left;
+                        }
+                        if(right < this->entries.size() && this->entries[right].count < this->entries[min].count){
+                            min = right;
+                        }
+                        if(min == i){
+                            return;
+                        }
+                        this->swap(i, min);
+                        i = min;
+                    }
+                }
+        };
+    }
+}
+
+#endif
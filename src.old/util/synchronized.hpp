@@ -25,6 +25,13 @@
  *
  * Changelog:
  *   2015-10-15 added deadlock detection
+ *   2026-10-19 per address locks are kept in striped buckets instead of one
+ *              global map behind one global mutex, released lock objects are
+ *              pooled. classes deriving from Synchronizable carry their lock
+ *              and skip the registry entirely. deadlock detection is only
+ *              compiled in with SYNCHRONIZED_DEBUG. dropped the pre c++11 path
+ *   2026-10-19 optional contention profiling per lock address and call site
+ *              (SynchronizedProfiler), switched on and off at runtime
  * 
  * License:
 java like synchronized(){} keyword for c++
@@ -49,17 +56,22 @@ License along with this library.
 #ifndef __SYNCHRONIZED_HPP__
 #define __SYNCHRONIZED_HPP__
 
-#if __cplusplus > 199711L
 #include <unordered_map>
 #include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <chrono>
 #include <exception>
-#endif
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <ostream>
 
 #include <map>
 
 #include <pthread.h>
+#include <stdint.h>
 #include <iostream>
 #include <stdexcept>
 #include <typeinfo>
@@ -69,147 +81,430 @@ License along with this library.
 #include <execinfo.h>
 #include <unistd.h>
 
-class Synchronized{
-    public:
-        enum LockType{ READ, WRITE };
+class Synchronized;
 
-    protected:
-        LockType ltype;
+namespace SynchronizedDetail{
+    enum LockType{ READ, WRITE };
 
-#if __cplusplus > 199711L
-        typedef std::multimap<std::thread::id, LockType> t_lockmap;
-#else
-        typedef std::multimap<pthread_t, LockType> t_lockmap;
-#endif
+    struct metaMutex{
+        pthread_rwlock_t rwlock;
 
-        typedef struct metaMutex{
-            pthread_rwlock_t rwlock;
-            
-#if __cplusplus > 199711L
-            std::unique_lock<std::mutex> ulock;
-            std::mutex lock;
-            std::condition_variable cond;
-            t_lockmap lockingThreads;
-#else
-            pthread_mutex_t lock;
-            pthread_cond_t cond;
-            t_lockmap lockingThreads;
+        std::mutex lock;
+        std::condition_variable cond;
+
+        unsigned int refs;
+#ifdef SYNCHRONIZED_DEBUG
+        std::multimap<std::thread::id, LockType> lockingThreads;
 #endif
-        } metaMutex;
 
+        metaMutex() : refs(0){ pthread_rwlock_init(&this->rwlock, NULL); }
+        ~metaMutex(){ pthread_rwlock_destroy(&this->rwlock); }
+
+        private:
+            metaMutex(const metaMutex&);
+            metaMutex& operator=(const metaMutex&);
+    };
+}
+
+/*
+ * contention profiler
+ *
+ * while enabled every Synchronized records how long it waited for the lock
+ * and how long it held it, keyed by lock address and the file:line that
+ * constructed it. data is kept in per thread tables which are only locked by
+ * their owner and by a reader merging them, so recording doesn't introduce a
+ * shared lock of its own. while disabled the cost is one relaxed atomic load.
+ */
+class SynchronizedProfiler{
+    public:
+        // log2 buckets of nanoseconds, the last one collects everything above ~9 minutes
+        static const size_t numBuckets = 40;
+
+        struct Site{
+            const void *addr;
+            const char *file;
+            int line;
+
+            bool operator==(const Site &other) const{
+                return this->addr == other.addr && this->file == other.file && this->line == other.line;
+            }
+        };
+        struct SiteHash{
+            size_t operator()(const Site &s) const{
+                size_t h = std::hash<const void*>()(s.addr);
+                h ^= std::hash<const void*>()(s.file) + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+                h ^= std::hash<int>()(s.line) + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+                return h;
+            }
+        };
+        struct Stats{
+            uint64_t acquisitions;
+            uint64_t waitNs;
+            uint64_t maxWaitNs;
+            uint64_t holdNs;
+            uint64_t maxHoldNs;
+            uint64_t waitHist[numBuckets];
+            uint64_t holdHist[numBuckets];
+
+            Stats() : acquisitions(0), waitNs(0), maxWaitNs(0), holdNs(0), maxHoldNs(0){
+                std::fill(this->waitHist, this->waitHist+numBuckets, 0);
+                std::fill(this->holdHist, this->holdHist+numBuckets, 0);
+            }
+            void merge(const Stats &o){
+                this->acquisitions += o.acquisitions;
+                this->waitNs += o.waitNs;
+                this->holdNs += o.holdNs;
+                this->maxWaitNs = std::max(this->maxWaitNs, o.maxWaitNs);
+                this->maxHoldNs = std::max(this->maxHoldNs, o.maxHoldNs);
+                for(size_t i=0;i<numBuckets;i++){
+                    this->waitHist[i] += o.waitHist[i];
+                    this->holdHist[i] += o.holdHist[i];
+                }
+            }
+        };
+        struct Holder{
+            Site site;
+            SynchronizedDetail::LockType ltype;
+            uint64_t since;
+            std::thread::id thread;
+        };
+        typedef std::unordered_map<Site, Stats, SiteHash> SiteMap;
+
+        static std::atomic<bool>& enabled(){
+            static std::atomic<bool> on(false);
+            return on;
+        }
+        static void enable(bool on){ SynchronizedProfiler::enabled().store(on); }
 
-#if __cplusplus > 199711L
-        std::mutex& getMutex(){
-            static std::mutex lock;
-            return lock;
+        static uint64_t now(){
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+        static size_t bucket(uint64_t ns){
+            size_t b = ns == 0 ? 0 : 64 - __builtin_clzll(ns);
+            return std::min(b, numBuckets-1);
+        }
+        // upper bound in nanoseconds of the bucket holding the given quantile
+        static uint64_t quantile(const uint64_t *hist, double q){
+            uint64_t count = 0, seen = 0;
+            for(size_t i=0;i<numBuckets;i++){
+                count += hist[i];
+            }
+            if(count == 0){
+                return 0;
+            }
+            uint64_t rank = (uint64_t)(q * count);
+            for(size_t i=0;i<numBuckets;i++){
+                seen += hist[i];
+                if(seen > rank){
+                    return i == 0 ? 0 : (1ULL << i) - 1;
+                }
+            }
+            return (1ULL << (numBuckets-1)) - 1;
         }
 
-        std::unordered_map<const void*, metaMutex*>& getMutexMap(){
-            static std::unordered_map<const void*, metaMutex*> mmap;
-            return mmap;
+        static void acquired(const Site &site, SynchronizedDetail::LockType ltype, uint64_t requested, uint64_t acquired){
+            ThreadData &td = SynchronizedProfiler::local();
+            std::lock_guard<std::mutex> lock(td.lock);
+
+            Stats &st = td.stats(site);
+            uint64_t wait = acquired - requested;
+            st.acquisitions++;
+            st.waitNs += wait;
+            st.maxWaitNs = std::max(st.maxWaitNs, wait);
+            st.waitHist[SynchronizedProfiler::bucket(wait)]++;
+
+            Holder h = {site, ltype, acquired, td.id};
+            td.holding.push_back(h);
         }
-#else
-        pthread_mutex_t& getMutex(){
-            static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
-            return lock;
+        static void released(const Site &site, uint64_t acquired, uint64_t released){
+            ThreadData &td = SynchronizedProfiler::local();
+            std::lock_guard<std::mutex> lock(td.lock);
+
+            Stats &st = td.stats(site);
+            uint64_t hold = released - acquired;
+            st.holdNs += hold;
+            st.maxHoldNs = std::max(st.maxHoldNs, hold);
+            st.holdHist[SynchronizedProfiler::bucket(hold)]++;
+
+            for(size_t i=td.holding.size();i>0;i--){
+                if(td.holding[i-1].site == site && td.holding[i-1].since == acquired){
+                    td.holding.erase(td.holding.begin() + (i-1));
+                    break;
+                }
+            }
         }
 
-        std::map<const void*, metaMutex*>& getMutexMap(){
-            static std::map<const void*, metaMutex*> mmap;
-            return mmap;
+        // merged over all threads
+        static SiteMap snapshot(){
+            SiteMap result;
+            std::lock_guard<std::mutex> lock(SynchronizedProfiler::registryLock());
+            std::vector<ThreadData*> &threads = SynchronizedProfiler::registry();
+            for(size_t i=0;i<threads.size();i++){
+                std::lock_guard<std::mutex> tlock(threads[i]->lock);
+                for(SiteMap::iterator it=threads[i]->sites.begin();it!=threads[i]->sites.end();it++){
+                    result[it->first].merge(it->second);
+                }
+            }
+            return result;
+        }
+        static std::vector<Holder> holders(){
+            std::vector<Holder> result;
+            std::lock_guard<std::mutex> lock(SynchronizedProfiler::registryLock());
+            std::vector<ThreadData*> &threads = SynchronizedProfiler::registry();
+            for(size_t i=0;i<threads.size();i++){
+                std::lock_guard<std::mutex> tlock(threads[i]->lock);
+                result.insert(result.end(), threads[i]->holding.begin(), threads[i]->holding.end());
+            }
+            return result;
+        }
+        static void reset(){
+            std::lock_guard<std::mutex> lock(SynchronizedProfiler::registryLock());
+            std::vector<ThreadData*> &threads = SynchronizedProfiler::registry();
+            for(size_t i=0;i<threads.size();i++){
+                std::lock_guard<std::mutex> tlock(threads[i]->lock);
+                threads[i]->sites.clear();
+            }
         }
-#endif
 
+        // plain text, call sites ordered by total wait time
+        static void report(std::ostream &out){
+            SiteMap sites = SynchronizedProfiler::snapshot();
+            std::vector<std::pair<Site, Stats> > sorted(sites.begin(), sites.end());
+            std::sort(sorted.begin(), sorted.end(), [](const std::pair<Site, Stats> &a, const std::pair<Site, Stats> &b){
+                return a.second.waitNs > b.second.waitNs;
+            });
+
+            out << "# site lock acquisitions wait_total_ns wait_p50_ns wait_p99_ns wait_max_ns hold_total_ns hold_p50_ns hold_p99_ns hold_max_ns" << std::endl;
+            for(size_t i=0;i<sorted.size();i++){
+                const Site &s = sorted[i].first;
+                const Stats &st = sorted[i].second;
+                out << s.file << ":" << s.line << " " << s.addr << " " << st.acquisitions
+                    << " " << st.waitNs
+                    << " " << SynchronizedProfiler::quantile(st.waitHist, 0.5)
+                    << " " << SynchronizedProfiler::quantile(st.waitHist, 0.99)
+                    << " " << st.maxWaitNs
+                    << " " << st.holdNs
+                    << " " << SynchronizedProfiler::quantile(st.holdHist, 0.5)
+                    << " " << SynchronizedProfiler::quantile(st.holdHist, 0.99)
+                    << " " << st.maxHoldNs << std::endl;
+            }
+
+            std::vector<Holder> holding = SynchronizedProfiler::holders();
+            uint64_t t = SynchronizedProfiler::now();
+            out << "# holders: site lock type thread held_ns" << std::endl;
+            for(size_t i=0;i<holding.size();i++){
+                const Holder &h = holding[i];
+                out << h.site.file << ":" << h.site.line << " " << h.site.addr << " "
+                    << (h.ltype == SynchronizedDetail::WRITE ? "write" : "read") << " "
+                    << h.thread << " " << (t - h.since) << std::endl;
+            }
+        }
+
+    protected:
+        // locks at transient addresses would grow the tables without bound,
+        // beyond this many entries per thread they are folded into addr NULL
+        static const size_t maxSitesPerThread = 4096;
+
+        struct ThreadData{
+            std::mutex lock;
+            std::thread::id id;
+            SiteMap sites;
+            std::vector<Holder> holding;
+
+            Stats& stats(const Site &site){
+                SiteMap::iterator it = this->sites.find(site);
+                if(it != this->sites.end()){
+                    return it->second;
+                }
+                if(this->sites.size() >= maxSitesPerThread){
+                    Site folded = {NULL, site.file, site.line};
+                    return this->sites[folded];
+                }
+                return this->sites[site];
+            }
+        };
+
+        static std::mutex& registryLock(){
+            static std::mutex *lock = new std::mutex();
+            return *lock;
+        }
+        // thread data is never freed, a thread's numbers stay in the totals after it ended
+        static std::vector<ThreadData*>& registry(){
+            static std::vector<ThreadData*> *threads = new std::vector<ThreadData*>();
+            return *threads;
+        }
+        static ThreadData& local(){
+            static thread_local ThreadData *td = NULL;
+            if(td == NULL){
+                td = new ThreadData();
+                td->id = std::this_thread::get_id();
+                std::lock_guard<std::mutex> lock(SynchronizedProfiler::registryLock());
+                SynchronizedProfiler::registry().push_back(td);
+            }
+            return *td;
+        }
+};
+
+/*
+ * objects of classes deriving from Synchronizable bring their own lock,
+ * Synchronized(obj) on them never touches the shared registry
+ */
+class Synchronizable{
+    protected:
+        friend class Synchronized;
+        mutable SynchronizedDetail::metaMutex synchronizedMeta;
+};
+
+class Synchronized{
+    public:
+        typedef SynchronizedDetail::LockType LockType;
+        static const LockType READ = SynchronizedDetail::READ;
+        static const LockType WRITE = SynchronizedDetail::WRITE;
+
+    protected:
+        typedef SynchronizedDetail::metaMutex metaMutex;
+        typedef std::multimap<std::thread::id, LockType> t_lockmap;
+
+        // addresses are spread over buckets with their own mutex, so unrelated
+        // objects don't contend on the registry. released metaMutex objects are
+        // kept per bucket for the next address instead of being freed
+        static const size_t numBuckets = 256;
+        static const size_t maxPooled = 16;
+
+        struct bucket{
+            std::mutex lock;
+            std::unordered_map<const void*, metaMutex*> mmap;
+            std::vector<metaMutex*> pool;
+        };
+
+        static bucket& getBucket(const void *ptr){
+            // never destroyed, locks may still be taken during static destruction
+            static bucket *buckets = new bucket[numBuckets];
+            uintptr_t p = (uintptr_t)ptr;
+            return buckets[((p >> 4) ^ (p >> 12)) % numBuckets];
+        }
+
+        LockType ltype;
         const void *accessPtr;
         metaMutex *metaPtr;
-        int dereference;
+        bool embedded;
+
+        // call site and acquisition time, only set while profiling
+        SynchronizedProfiler::Site site;
+        uint64_t acquiredAt;
 
         template<typename T>
         T * getAccessPtr(T & obj) { return &obj; } //turn reference into pointer!
         template<typename T>
         T * getAccessPtr(T * obj) { return obj; } //obj is already pointer, return it!
 
-public:
-        template<typename T>
-        Synchronized(const T &ptr, LockType ltype = WRITE) : ltype(ltype),accessPtr(getAccessPtr(ptr)){
-            //std::cout << "type: " << typeid(ptr).name() << std::endl;
-
-            /*{
-              void *array[10];
-              size_t size;
-
-              // get void*'s for all entries on the stack
-              size = backtrace(array, 10);
+        metaMutex* getMeta(const Synchronizable *obj){
+            this->embedded = true;
+            return &obj->synchronizedMeta;
+        }
+        metaMutex* getMeta(const void *ptr){
+            this->embedded = false;
 
-              // print out all the frames to stderr
-              backtrace_symbols_fd(array, size, STDERR_FILENO);
-            }*/
+            bucket &b = Synchronized::getBucket(ptr);
+            std::lock_guard<std::mutex> lockBucket(b.lock);
 
-            if(this->accessPtr==NULL){
-                throw std::runtime_error(std::string("Synchronizing on NULL pointer is not valid, referenced type is: ")+typeid(ptr).name());
+            std::unordered_map<const void*, metaMutex*>::iterator it = b.mmap.find(ptr);
+            if(it != b.mmap.end()){
+                it->second->refs++;
+                return it->second;
             }
 
-#if __cplusplus > 199711L
-            {
-                std::lock_guard<std::mutex> lockMapMutex(this->getMutex());
+            metaMutex *m;
+            if(!b.pool.empty()){
+                m = b.pool.back();
+                b.pool.pop_back();
+            }
+            else{
+                m = new metaMutex();
+            }
+            m->refs = 1;
+            b.mmap.insert(std::make_pair(ptr, m));
+            return m;
+        }
+        void putMeta(){
+            if(this->embedded){
+                return;
+            }
 
-                std::unordered_map<const void*, metaMutex*>& mmap = this->getMutexMap();
-                std::unordered_map<const void*, metaMutex*>::iterator it = mmap.find(this->accessPtr);
+            bucket &b = Synchronized::getBucket(this->accessPtr);
+            std::lock_guard<std::mutex> lockBucket(b.lock);
 
-                if(it != mmap.end()){
-                    this->metaPtr = it->second;
+            if(--this->metaPtr->refs > 0){
+                return;
+            }
+            b.mmap.erase(this->accessPtr);
+            if(b.pool.size() < maxPooled){
+                b.pool.push_back(this->metaPtr);
+            }
+            else{
+                delete this->metaPtr;
+            }
+        }
 
-                    std::pair<t_lockmap::iterator, t_lockmap::iterator> range = this->metaPtr->lockingThreads.equal_range(std::this_thread::get_id());
-                    for(;range.first!=range.second;range.first++){
-                        if(range.first->second == WRITE || ltype == WRITE){
-                            throw std::runtime_error(std::string("deadlock detected"));
-                        }
-                    }
-                    this->metaPtr->lockingThreads.insert(std::make_pair(std::this_thread::get_id(), ltype));
-                }
-                else{
-                    this->metaPtr = new metaMutex();
-                    pthread_rwlock_init(&this->metaPtr->rwlock, NULL);
+#ifdef SYNCHRONIZED_DEBUG
+        void enterDebug(){
+            std::lock_guard<std::mutex> lockMeta(this->metaPtr->lock);
 
-                    this->metaPtr->ulock = std::unique_lock<std::mutex>(this->metaPtr->lock);
-                    this->metaPtr->lockingThreads.insert(std::make_pair(std::this_thread::get_id(), ltype));
-                    mmap.insert(std::make_pair(this->accessPtr, this->metaPtr));
+            std::pair<t_lockmap::iterator, t_lockmap::iterator> range = this->metaPtr->lockingThreads.equal_range(std::this_thread::get_id());
+            for(;range.first!=range.second;range.first++){
+                if(range.first->second == WRITE || this->ltype == WRITE){
+                    throw std::runtime_error(std::string("deadlock detected"));
                 }
             }
-            
-#else
-            pthread_mutex_lock(&this->getMutex());
-
-            std::map<const void*, metaMutex*>& mmap = this->getMutexMap();
-            std::map<const void*, metaMutex*>::iterator it = mmap.find(this->accessPtr);
+            this->metaPtr->lockingThreads.insert(std::make_pair(std::this_thread::get_id(), this->ltype));
+        }
+        void leaveDebug(){
+            std::lock_guard<std::mutex> lockMeta(this->metaPtr->lock);
 
-            if(it != mmap.end()){
-                this->metaPtr = it->second;
+            t_lockmap::iterator it = this->metaPtr->lockingThreads.find(std::this_thread::get_id());
+            if(it!=this->metaPtr->lockingThreads.end()){
+                this->metaPtr->lockingThreads.erase(it);
+            }
+        }
+#endif
 
-                std::pair<t_lockmap::iterator, t_lockmap::iterator> range = this->metaPtr->lockingThreads.equal_range(pthread_self());
-                for(;range.first!=range.second;range.first++){
-                    if(range.first->second == WRITE || ltype == WRITE){
-                        throw std::runtime_error(std::string("deadlock detected"));
-                    }
-                }
-                this->metaPtr->lockingThreads.insert(std::make_pair(pthread_self(), ltype));
+        void acquire(){
+            if(this->ltype == WRITE){
+                pthread_rwlock_wrlock(&this->metaPtr->rwlock);
             }
             else{
-                this->metaPtr = new metaMutex();
-                pthread_rwlock_init(&this->metaPtr->rwlock, NULL);
-                pthread_mutex_init(&this->metaPtr->lock, NULL);
-                pthread_cond_init(&this->metaPtr->cond, NULL);
-                this->metaPtr->lockingThreads.insert(std::make_pair(pthread_self(), ltype));
-                mmap.insert(std::make_pair(this->accessPtr, this->metaPtr));
+                pthread_rwlock_rdlock(&this->metaPtr->rwlock);
+            }
+        }
+
+public:
+        template<typename T>
+        Synchronized(const T &ptr, LockType ltype = WRITE, const char *file = __builtin_FILE(), int line = __builtin_LINE()) : ltype(ltype),accessPtr(getAccessPtr(ptr)),acquiredAt(0){
+            if(this->accessPtr==NULL){
+                throw std::runtime_error(std::string("Synchronizing on NULL pointer is not valid, referenced type is: ")+typeid(ptr).name());
             }
 
-            pthread_mutex_unlock(&this->getMutex());
+            this->metaPtr = this->getMeta(getAccessPtr(ptr));
+
+#ifdef SYNCHRONIZED_DEBUG
+            try{
+                this->enterDebug();
+            }catch(...){
+                this->putMeta();
+                throw;
+            }
 #endif
-            if(this->ltype == WRITE){
-                pthread_rwlock_wrlock(&this->metaPtr->rwlock);
+            if(SynchronizedProfiler::enabled().load(std::memory_order_relaxed)){
+                uint64_t requested = SynchronizedProfiler::now();
+                this->acquire();
+                this->acquiredAt = SynchronizedProfiler::now();
+                this->site.addr = this->accessPtr;
+                this->site.file = file;
+                this->site.line = line;
+                SynchronizedProfiler::acquired(this->site, this->ltype, requested, this->acquiredAt);
             }
             else{
-                pthread_rwlock_rdlock(&this->metaPtr->rwlock);
+                this->acquire();
             }
         }
 
@@ -219,138 +514,75 @@ public:
         }
 
         ~Synchronized(){
-            pthread_rwlock_unlock(&this->metaPtr->rwlock);
-            {
-#if __cplusplus > 199711L
-                std::lock_guard<std::mutex> lockMapMutex(this->getMutex());
-                t_lockmap::iterator it = metaPtr->lockingThreads.find(std::this_thread::get_id());
-#else
-                pthread_mutex_lock(&this->getMutex());
-                t_lockmap::iterator it = metaPtr->lockingThreads.find(pthread_self());
-#endif
-                if(it!=metaPtr->lockingThreads.end()){
-                    metaPtr->lockingThreads.erase(it);
-                }
-                if(metaPtr->lockingThreads.size()<=0){  // if none holds lock any more - free resources
-                    this->getMutexMap().erase(this->accessPtr);
-                    delete this->metaPtr;
-                }
+            if(this->acquiredAt != 0){
+                SynchronizedProfiler::released(this->site, this->acquiredAt, SynchronizedProfiler::now());
             }
-#if __cplusplus > 199711L
-#else
-            pthread_mutex_unlock(&this->getMutex());
+            pthread_rwlock_unlock(&this->metaPtr->rwlock);
+#ifdef SYNCHRONIZED_DEBUG
+            this->leaveDebug();
 #endif
+            this->putMeta();
         }
 
-#if __cplusplus > 199711L
         template< class Rep, class Period >
         void wait(std::chrono::duration<Rep, Period> d){
-            this->metaPtr->cond.wait_for(this->metaPtr->ulock, d);
+            std::unique_lock<std::mutex> lockMeta(this->metaPtr->lock);
+            pthread_rwlock_unlock(&this->metaPtr->rwlock);
+            this->metaPtr->cond.wait_for(lockMeta, d);
+            lockMeta.unlock();
+            this->acquire();
         }
-#endif
 
         void wait(unsigned long milliseconds=0, unsigned int nanos=0){
             // keep in mind: it's not possible that the exact same thread call's wait concurrently
             // thus there is no need to think about deadlock's here - but we need to make sure
             // that rwlock will hold the exact same lock as before
 
+            // the meta lock is taken before the rwlock is given up, so a notify
+            // issued in between can't get lost
+            std::unique_lock<std::mutex> lockMeta(this->metaPtr->lock);
             pthread_rwlock_unlock(&this->metaPtr->rwlock);
-#if __cplusplus > 199711L
+
             std::exception_ptr eptr;
             try{
-                this->metaPtr->lock.lock();
-
                 if(milliseconds==0 && nanos==0){
-                    this->metaPtr->cond.wait(this->metaPtr->ulock);
+                    this->metaPtr->cond.wait(lockMeta);
                 }
                 else{
-                    this->metaPtr->cond.wait_for(this->metaPtr->ulock, std::chrono::milliseconds(milliseconds) + std::chrono::nanoseconds(nanos));
+                    this->metaPtr->cond.wait_for(lockMeta, std::chrono::milliseconds(milliseconds) + std::chrono::nanoseconds(nanos));
                 }
-
-                this->metaPtr->lock.unlock();
             }catch(...){
                 eptr = std::current_exception();
             }
-            if(this->ltype == WRITE){
-                pthread_rwlock_wrlock(&this->metaPtr->rwlock);
-            }
-            else{
-                pthread_rwlock_rdlock(&this->metaPtr->rwlock);
-            }
+            lockMeta.unlock();
+            this->acquire();
 
             if(eptr){
                 std::rethrow_exception(eptr);
             }
-#else
-            pthread_mutex_lock(&this->metaPtr->lock);
-            int rval = 0;
-            if(milliseconds == 0 && nanos == 0){
-                rval = pthread_cond_wait(&this->metaPtr->cond, &this->metaPtr->lock);
-            }
-            else{
-                struct timespec timeUntilToWait;
-                struct timeval now;
-                int rt;
-
-                gettimeofday(&now,NULL);
-
-                timeUntilToWait.tv_sec = now.tv_sec;
-                long seconds = 0;
-                if(milliseconds >= 1000){
-                    seconds = (milliseconds/1000);
-                    milliseconds -= seconds*1000;
-                }
-                timeUntilToWait.tv_sec += seconds;
-                timeUntilToWait.tv_nsec = (now.tv_usec+1000UL*milliseconds)*1000UL + nanos;
-                rval = pthread_cond_timedwait(&this->metaPtr->cond, &this->metaPtr->lock, &timeUntilToWait);
-            }
-            pthread_mutex_unlock(&this->metaPtr->lock);
-            if(this->ltype == WRITE){
-                pthread_rwlock_wrlock(&this->metaPtr->rwlock);
-            }
-            else{
-                pthread_rwlock_rdlock(&this->metaPtr->rwlock);
-            }
-
-            switch(rval){
-                case 0: break;
-                case EINVAL: throw std::runtime_error("invalid time or condition or mutex given");
-                case EPERM: throw std::runtime_error("trying to wait is only allowed in the same thread holding the mutex");
-            }
-#endif
         }
         void notify(){
-#if __cplusplus > 199711L
+            std::lock_guard<std::mutex> lockMeta(this->metaPtr->lock);
             this->metaPtr->cond.notify_one();
-#else
-            if(pthread_cond_signal(&this->metaPtr->cond)!=0){
-                std::runtime_error("non initialized condition variable");
-            }
-#endif
         }
         void notifyAll(){
-#if __cplusplus > 199711L
+            std::lock_guard<std::mutex> lockMeta(this->metaPtr->lock);
             this->metaPtr->cond.notify_all();
-#else
-            if(pthread_cond_broadcast(&this->metaPtr->cond)!=0){
-                std::runtime_error("non initialized condition variable");
-            }
-#endif
         }
 
         template<typename T>
         static void wait(const T &ptr, unsigned long milliseconds=0, unsigned int nanos=0){
-            Synchronized syncToken(ptr, false);
+            Synchronized syncToken(ptr, READ);
             syncToken.wait(milliseconds, nanos);
         }
         template<typename T>
         static void notify(const T &ptr){
-            Synchronized syncToken(ptr, false);
+            Synchronized syncToken(ptr, READ);
             syncToken.notify();
         }
         template<typename T>
         static void notifyAll(const T &ptr){
-            Synchronized syncToken(ptr, false);
+            Synchronized syncToken(ptr, READ);
             syncToken.notifyAll();
         }
 };
@@ -361,9 +593,6 @@ public:
 
 #define jsynchronized(ptr) if(Synchronized synchronizedTokenPaste2(sync_, __LINE__) = Synchronized(ptr))
 
-
-#if __cplusplus > 199711L
-
 template <typename T, typename F>
 void synchronizedCPP11(const T &ptr, F&& func)
 {
@@ -371,10 +600,4 @@ void synchronizedCPP11(const T &ptr, F&& func)
     std::forward<F>(func)();
 }
 
-#else
-
-#define synchronized(ptr, ...) { Synchronized synchronizedTokenPaste2(sync_,_LINE__)(ptr); __VA_ARGS__; }
-
-#endif
-
 #endif
@@ -4,6 +4,7 @@
 #include <string>
 #include <boost/algorithm/string.hpp>
 #include <map>
+#include <vector>
 
 namespace Springy{
     namespace Util{
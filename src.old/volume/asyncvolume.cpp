@@ -0,0 +1,258 @@
+#include "asyncvolume.hpp"
+#include "../trace.hpp"
+
+namespace Springy{
+    namespace Volume{
+        AsyncVolume::AsyncVolume(IVolume *volume, boost::asio::io_service &io_service) : volume(volume), io_service(io_service){}
+        AsyncVolume::~AsyncVolume(){}
+
+        std::string AsyncVolume::string(){
+            return this->volume->string();
+        }
+        bool AsyncVolume::isLocal(){
+            return this->volume->isLocal();
+        }
+        boost::filesystem::path AsyncVolume::backingPath(const boost::filesystem::path &v_path){
+            return this->volume->backingPath(v_path);
+        }
+
+        void AsyncVolume::getattr(const boost::filesystem::path &v_file_name, struct ::stat *buf, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->getattr(v_file_name, buf); });
+        }
+
+        void AsyncVolume::statvfs(const boost::filesystem::path &v_path, struct ::statvfs *stat, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->statvfs(v_path, stat); });
+        }
+
+        void AsyncVolume::chown(const boost::filesystem::path &v_file_name, uid_t owner, gid_t group, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->chown(v_file_name, owner, group); });
+        }
+
+        void AsyncVolume::chmod(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->chmod(v_file_name, mode); });
+        }
+
+        void AsyncVolume::mkdir(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->mkdir(v_file_name, mode); });
+        }
+
+        void AsyncVolume::rmdir(const boost::filesystem::path &v_path, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->rmdir(v_path); });
+        }
+
+        void AsyncVolume::rename(const boost::filesystem::path &v_old_name, const boost::filesystem::path &v_new_name, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->rename(v_old_name, v_new_name); });
+        }
+
+        void AsyncVolume::utimensat(const boost::filesystem::path &v_path, const struct timespec times[2], Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            struct timespec ts[2] = { times[0], times[1] };
+            this->post(handler, [=](){ return (ssize_t)volume->utimensat(v_path, ts); });
+        }
+
+        void AsyncVolume::readdir(const boost::filesystem::path &v_path, std::unordered_map<std::string, struct stat> &result, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            std::unordered_map<std::string, struct stat> *entries = &result;
+            this->post(handler, [=]() -> ssize_t{
+                // File reports the errno itself instead of -1
+                int res = volume->readdir(v_path, *entries);
+                if(res > 0){
+                    errno = res;
+                    res = -1;
+                }
+                return res;
+            });
+        }
+
+        void AsyncVolume::readlink(const boost::filesystem::path &v_path, char *buf, size_t bufsiz, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->readlink(v_path, buf, bufsiz); });
+        }
+
+        void AsyncVolume::access(const boost::filesystem::path &v_path, int mode, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->access(v_path, mode); });
+        }
+
+        void AsyncVolume::unlink(const boost::filesystem::path &v_path, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->unlink(v_path); });
+        }
+
+        void AsyncVolume::link(const boost::filesystem::path &oldpath, const boost::filesystem::path &newpath, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->link(oldpath, newpath); });
+        }
+
+        void AsyncVolume::symlink(const boost::filesystem::path &oldpath, const boost::filesystem::path &newpath, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->symlink(oldpath, newpath); });
+        }
+
+        void AsyncVolume::mkfifo(const boost::filesystem::path &v_path, mode_t mode, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->mkfifo(v_path, mode); });
+        }
+
+        void AsyncVolume::mknod(const boost::filesystem::path &v_path, mode_t mode, dev_t dev, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->mknod(v_path, mode, dev); });
+        }
+
+        void AsyncVolume::open(const boost::filesystem::path &v_file_name, int flags, mode_t mode, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->open(v_file_name, flags, mode); });
+        }
+
+        void AsyncVolume::creat(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->creat(v_file_name, mode); });
+        }
+
+        void AsyncVolume::close(const boost::filesystem::path &v_file_name, int fd, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->close(v_file_name, fd); });
+        }
+
+        void AsyncVolume::write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->write(v_file_name, fd, buf, count, offset); });
+        }
+
+        void AsyncVolume::read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->read(v_file_name, fd, buf, count, offset); });
+        }
+
+        void AsyncVolume::truncate(const boost::filesystem::path &v_path, int fd, off_t length, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->truncate(v_path, fd, length); });
+        }
+
+        void AsyncVolume::fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->fallocate(v_path, fd, mode, offset, length); });
+        }
+
+        void AsyncVolume::copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                          const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->copy_file_range(v_in, fd_in, off_in, v_out, fd_out, off_out, len); });
+        }
+
+        void AsyncVolume::fgetattr(const boost::filesystem::path &v_file_name, int fd, struct ::stat *buf, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->fgetattr(v_file_name, fd, buf); });
+        }
+
+        int AsyncVolume::descriptor(const boost::filesystem::path &v_file_name, int fd){
+            return this->volume->descriptor(v_file_name, fd);
+        }
+
+        void AsyncVolume::flush(const boost::filesystem::path &v_path, int fd, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->flush(v_path, fd); });
+        }
+
+        void AsyncVolume::fsync(const boost::filesystem::path &v_path, int fd, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->fsync(v_path, fd); });
+        }
+
+        void AsyncVolume::lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->lock(v_path, fd, cmd, lck, lock_owner); });
+        }
+
+        void AsyncVolume::setxattr(const boost::filesystem::path &v_path, const std::string &attrname, const char *attrval, size_t attrvalsize, int flags, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->setxattr(v_path, attrname, attrval, attrvalsize, flags); });
+        }
+
+        void AsyncVolume::getxattr(const boost::filesystem::path &v_path, const std::string &attrname, char *buf, size_t count, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->getxattr(v_path, attrname, buf, count); });
+        }
+
+        void AsyncVolume::listxattr(const boost::filesystem::path &v_path, char *buf, size_t count, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->listxattr(v_path, buf, count); });
+        }
+
+        void AsyncVolume::removexattr(const boost::filesystem::path &v_path, const std::string &attrname, Handler handler){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            IVolume *volume = this->volume;
+            this->post(handler, [=](){ return (ssize_t)volume->removexattr(v_path, attrname); });
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef SPRINGY_VOLUME_ASYNCVOLUME
+#define SPRINGY_VOLUME_ASYNCVOLUME
+
+#include <boost/asio/io_service.hpp>
+
+#include "iasyncvolume.hpp"
+#include "ivolume.hpp"
+
+namespace Springy{
+    namespace Volume{
+        /**
+         * runs the operations of a synchronous volume on the threads of an
+         * io_service (Brain::executor()), so several can be pending at once
+         * without a thread of the caller's per operation.
+         *
+         * the volume is not owned and has to outlive every pending operation
+         */
+        class AsyncVolume : public IAsyncVolume{
+            protected:
+                IVolume *volume;
+                boost::asio::io_service &io_service;
+
+                // runs op on the executor and hands its result and errno to handler.
+                // called from a thread of the executor it runs right away, so a
+                // SyncVolume used there cannot wait for a thread that waits itself
+                template<typename Op> void post(Handler handler, Op op){
+                    if(this->io_service.get_executor().running_in_this_thread()){
+                        ssize_t result = op();
+                        handler(result, result == -1 ? errno : 0);
+                        return;
+                    }
+                    this->io_service.post([handler, op](){
+                        ssize_t result = op();
+                        handler(result, result == -1 ? errno : 0);
+                    });
+                }
+
+            public:
+                AsyncVolume(IVolume *volume, boost::asio::io_service &io_service);
+                virtual ~AsyncVolume();
+
+                IVolume* synchronous(){ return this->volume; }
+
+                virtual std::string string();
+                virtual bool isLocal();
+                virtual boost::filesystem::path backingPath(const boost::filesystem::path &v_path);
+
+                virtual void getattr(const boost::filesystem::path &v_file_name, struct ::stat *buf, Handler handler);
+
+                virtual void statvfs(const boost::filesystem::path &v_path, struct ::statvfs *stat, Handler handler);
+
+                virtual void chown(const boost::filesystem::path &v_file_name, uid_t owner, gid_t group, Handler handler);
+
+                virtual void chmod(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler);
+                virtual void mkdir(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler);
+                virtual void rmdir(const boost::filesystem::path &v_path, Handler handler);
+
+                virtual void rename(const boost::filesystem::path &v_old_name, const boost::filesystem::path &v_new_name, Handler handler);
+
+                virtual void utimensat(const boost::filesystem::path &v_path, const struct timespec times[2], Handler handler);
+
+                virtual void readdir(const boost::filesystem::path &v_path, std::unordered_map<std::string, struct stat> &result, Handler handler);
+                virtual void readlink(const boost::filesystem::path &v_path, char *buf, size_t bufsiz, Handler handler);
+
+                virtual void access(const boost::filesystem::path &v_path, int mode, Handler handler);
+                virtual void unlink(const boost::filesystem::path &v_path, Handler handler);
+
+                virtual void link(const boost::filesystem::path &oldpath, const boost::filesystem::path &newpath, Handler handler);
+                virtual void symlink(const boost::filesystem::path &oldpath, const boost::filesystem::path &newpath, Handler handler);
+                virtual void mkfifo(const boost::filesystem::path &v_path, mode_t mode, Handler handler);
+                virtual void mknod(const boost::filesystem::path &v_path, mode_t mode, dev_t dev, Handler handler);
+
+                virtual void open(const boost::filesystem::path &v_file_name, int flags, mode_t mode, Handler handler);
+                virtual void creat(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler);
+                virtual void close(const boost::filesystem::path &v_file_name, int fd, Handler handler);
+
+                virtual void write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset, Handler handler);
+                virtual void read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset, Handler handler);
+                virtual void truncate(const boost::filesystem::path &v_path, int fd, off_t length, Handler handler);
+                virtual void fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length, Handler handler);
+                virtual void copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                             const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len, Handler handler);
+                virtual void fgetattr(const boost::filesystem::path &v_file_name, int fd, struct ::stat *buf, Handler handler);
+                virtual int descriptor(const boost::filesystem::path &v_file_name, int fd);
+
+                virtual void flush(const boost::filesystem::path &v_path, int fd, Handler handler);
+                virtual void fsync(const boost::filesystem::path &v_path, int fd, Handler handler);
+
+                virtual void lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner, Handler handler);
+
+                virtual void setxattr(const boost::filesystem::path &v_path, const std::string &attrname, const char *attrval, size_t attrvalsize, int flags, Handler handler);
+                virtual void getxattr(const boost::filesystem::path &v_path, const std::string &attrname, char *buf, size_t count, Handler handler);
+                virtual void listxattr(const boost::filesystem::path &v_path, char *buf, size_t count, Handler handler);
+                virtual void removexattr(const boost::filesystem::path &v_path, const std::string &attrname, Handler handler);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "blockcache.hpp"
+#include "../trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace Springy{
+    namespace Volume{
+        size_t BlockCache::KeyHash::operator()(const Key &k) const{
+            size_t h = std::hash<const void*>()(k.volume);
+            h ^= std::hash<uint64_t>()((uint64_t)k.dev) + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+            h ^= std::hash<uint64_t>()((uint64_t)k.ino) + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+            h ^= std::hash<uint64_t>()(k.block) + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+            return h;
+        }
+
+        BlockCache::BlockCache(size_t capacity, size_t blockSize){
+            this->blocksize = blockSize;
+            this->totalCapacity = 0;
+            for(size_t i=0;i<BlockCache::numShards;i++){
+                Shard *s = new Shard();
+                s->used = 0;
+                s->capacity = 0;
+                this->shards.push_back(s);
+            }
+            this->setCapacity(capacity);
+        }
+        BlockCache::~BlockCache(){
+            for(size_t i=0;i<this->shards.size();i++){
+                delete this->shards[i];
+            }
+        }
+
+        void BlockCache::setCapacity(size_t capacity){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            this->totalCapacity = capacity;
+            for(size_t i=0;i<this->shards.size();i++){
+                Shard &s = *this->shards[i];
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.capacity = capacity / this->shards.size();
+                this->evict(s);
+            }
+        }
+        size_t BlockCache::capacity(){ return this->totalCapacity; }
+        size_t BlockCache::blockSize(){ return this->blocksize; }
+
+        BlockCache::Shard& BlockCache::shard(const Key &key){
+            return *this->shards[KeyHash()(key) % this->shards.size()];
+        }
+
+        void BlockCache::evict(Shard &s){
+            while(s.used > s.capacity && !s.lru.empty()){
+                Block &b = s.lru.back();
+                s.used -= b.data.size() + sizeof(Block);
+                s.index.erase(b.key);
+                s.lru.pop_back();
+            }
+        }
+
+        ssize_t BlockCache::read(const Key &key, const Validator &v, void *buf, size_t offset, size_t count){
+            Shard &s = this->shard(key);
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            auto it = s.index.find(key);
+            if(it == s.index.end()){
+                return -1;
+            }
+
+            BlockList::iterator bit = it->second;
+            if(!(bit->validator == v)){
+                // file changed since the block was fetched
+                s.used -= bit->data.size() + sizeof(Block);
+                s.lru.erase(bit);
+                s.index.erase(it);
+                return -1;
+            }
+
+            // move to the front of the lru list
+            s.lru.splice(s.lru.begin(), s.lru, bit);
+
+            if(offset >= bit->data.size()){
+                return 0;
+            }
+            size_t n = std::min(count, bit->data.size() - offset);
+            memcpy(buf, bit->data.data() + offset, n);
+            return n;
+        }
+
+        void BlockCache::put(const Key &key, const Validator &v, const std::string &data){
+            Shard &s = this->shard(key);
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            if(data.size() + sizeof(Block) > s.capacity){
+                return;
+            }
+
+            auto it = s.index.find(key);
+            if(it != s.index.end()){
+                s.used -= it->second->data.size() + sizeof(Block);
+                s.lru.erase(it->second);
+                s.index.erase(it);
+            }
+
+            Block b = {key, v, data};
+            s.lru.push_front(b);
+            s.index[key] = s.lru.begin();
+            s.used += data.size() + sizeof(Block);
+
+            this->evict(s);
+        }
+
+        void BlockCache::clear(){
+            for(size_t i=0;i<this->shards.size();i++){
+                Shard &s = *this->shards[i];
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.lru.clear();
+                s.index.clear();
+                s.used = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef SPRINGY_VOLUME_BLOCKCACHE_HPP
+#define SPRINGY_VOLUME_BLOCKCACHE_HPP
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Springy{
+    namespace Volume{
+        /**
+         * memory bounded block cache shared between all remote volumes
+         *
+         * blocks are addressed by (volume, file identity, block index) and carry the
+         * file's mtime, size and a local write generation they were read at. a lookup
+         * with a different validator is a miss and drops the stale block.
+         * the cache is split into shards with their own lock and lru list, so concurrent
+         * readers of different blocks don't serialize on a single mutex.
+         */
+        class BlockCache{
+            public:
+                struct Key{
+                    const void *volume;
+                    dev_t dev;
+                    ino_t ino;
+                    uint64_t block;
+
+                    bool operator==(const Key &other) const{
+                        return this->volume == other.volume && this->dev == other.dev &&
+                               this->ino == other.ino && this->block == other.block;
+                    }
+                };
+                struct Validator{
+                    time_t mtime;
+                    off_t size;
+                    uint64_t generation;
+
+                    bool operator==(const Validator &other) const{
+                        return this->mtime == other.mtime && this->size == other.size &&
+                               this->generation == other.generation;
+                    }
+                };
+
+                static const size_t defaultCapacity = 64*1024*1024;
+                static const size_t defaultBlockSize = 128*1024;
+
+                BlockCache(size_t capacity = defaultCapacity, size_t blockSize = defaultBlockSize);
+                ~BlockCache();
+
+                void setCapacity(size_t capacity);
+                size_t capacity();
+                size_t blockSize();
+
+                // copies up to count bytes starting at offset within the block into buf
+                // returns the number of bytes copied or -1 if the block is not cached (or stale)
+                ssize_t read(const Key &key, const Validator &v, void *buf, size_t offset, size_t count);
+                void put(const Key &key, const Validator &v, const std::string &data);
+
+                void clear();
+
+            protected:
+                struct KeyHash{
+                    size_t operator()(const Key &k) const;
+                };
+                struct Block{
+                    Key key;
+                    Validator validator;
+                    std::string data;
+                };
+                typedef std::list<Block> BlockList;
+
+                struct Shard{
+                    std::mutex mutex;
+                    BlockList lru;
+                    std::unordered_map<Key, BlockList::iterator, KeyHash> index;
+                    size_t used;
+                    size_t capacity;
+                };
+
+                static const size_t numShards = 16;
+
+                size_t blocksize;
+                size_t totalCapacity;
+                std::vector<Shard*> shards;
+
+                Shard& shard(const Key &key);
+                void evict(Shard &s);
+        };
+    }
+}
+
+#endif
@@ -28,70 +28,71 @@ namespace Springy{
 
         std::string File::string(){ return this->u.string(); }
         bool File::isLocal(){ return true; }
+        boost::filesystem::path File::backingPath(const boost::filesystem::path &v_path){ return this->concatPath(this->u.path(), v_path); }
 
         int File::getattr(boost::filesystem::path v_file_name, struct stat *buf){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
-            return this->libc->lstat(__LINE__, p.c_str(), buf);
+            return t.status(this->libc->lstat(__LINE__, p.c_str(), buf));
         }
         int File::statvfs(boost::filesystem::path v_path, struct ::statvfs *stat){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
-            return this->libc->statvfs(__LINE__, p.c_str(), stat);
+            return t.status(this->libc->statvfs(__LINE__, p.c_str(), stat));
         }
         int File::chown(boost::filesystem::path v_file_name, uid_t owner, gid_t group){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
-            return this->libc->chown(__LINE__, p.c_str(), owner, group);
+            return t.status(this->libc->chown(__LINE__, p.c_str(), owner, group));
         }
 
         int File::chmod(boost::filesystem::path v_file_name, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
-            return this->libc->chmod(__LINE__, p.c_str(), mode);
+            return t.status(this->libc->chmod(__LINE__, p.c_str(), mode));
         }
         int File::mkdir(boost::filesystem::path v_file_name, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
-            return this->libc->mkdir(__LINE__, p.c_str(), mode);
+            return t.status(this->libc->mkdir(__LINE__, p.c_str(), mode));
         }
         int File::rmdir(boost::filesystem::path v_path){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
-            return this->libc->rmdir(__LINE__, p.c_str());
+            return t.status(this->libc->rmdir(__LINE__, p.c_str()));
         }
 
         int File::rename(boost::filesystem::path v_old_name, boost::filesystem::path v_new_name){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path oldp = this->concatPath(this->u.path(), v_old_name);
             boost::filesystem::path newp = this->concatPath(this->u.path(), v_new_name);
-            return this->libc->rename(__LINE__, oldp.c_str(), newp.c_str());
+            return t.status(this->libc->rename(__LINE__, oldp.c_str(), newp.c_str()));
         }
 
         int File::utimensat(boost::filesystem::path v_path, const struct timespec times[2]){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
-            return this->libc->utimensat(__LINE__, AT_FDCWD, p.c_str(), times, AT_SYMLINK_NOFOLLOW);
+            return t.status(this->libc->utimensat(__LINE__, AT_FDCWD, p.c_str(), times, AT_SYMLINK_NOFOLLOW));
         }
 
         int File::readdir(boost::filesystem::path v_path, std::unordered_map<std::string, struct stat> &result){
@@ -102,7 +103,7 @@ namespace Springy{
             struct dirent *de;
             DIR * dh = this->libc->opendir(__LINE__, p.c_str());
             if (!dh){
-                return errno;
+                return t.status(errno);
             }
 
             while((de = this->libc->readdir(__LINE__, dh))) {
@@ -117,151 +118,197 @@ namespace Springy{
             }
 
             this->libc->closedir(__LINE__, dh);
-            return 0;
+            return t.status(0);
         }
         
         ssize_t File::readlink(boost::filesystem::path v_path, char *buf, size_t bufsiz){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
-            return this->libc->readlink(__LINE__, p.c_str(), buf, bufsiz);
+            return t.status(this->libc->readlink(__LINE__, p.c_str(), buf, bufsiz));
         }
 
         int File::open(boost::filesystem::path v_file_name, int flags, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            if(this->readonly && (flags&O_RDONLY) != O_RDONLY){ errno = EROFS; return -1; }
+            if(this->readonly && (flags&O_RDONLY) != O_RDONLY){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
             if(mode != 0){
-                return this->libc->open(__LINE__, p.c_str(), flags);
+                return t.status(this->libc->open(__LINE__, p.c_str(), flags));
             }
             else{
-                return this->libc->open(__LINE__, p.c_str(), flags, mode);
+                return t.status(this->libc->open(__LINE__, p.c_str(), flags, mode));
             }
         }
         int File::creat(boost::filesystem::path v_file_name, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
-            return this->libc->creat(__LINE__, p.c_str(), mode);
+            return t.status(this->libc->creat(__LINE__, p.c_str(), mode));
         }
-        int File::close(boost::filesystem::path v_file_name, int fd){
+        int File::close(const boost::filesystem::path &v_file_name, int fd){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
-            return this->libc->close(__LINE__, fd);
+            return t.status(this->libc->close(__LINE__, fd));
         }
         
-        ssize_t File::write(boost::filesystem::path v_file_name, int fd, const void *buf, size_t count, off_t offset){
+        ssize_t File::write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return this->libc->pwrite(__LINE__, fd, buf, count, offset);
+            return t.status(this->libc->pwrite(__LINE__, fd, buf, count, offset));
         }
-        ssize_t File::read(boost::filesystem::path v_file_name, int fd, void *buf, size_t count, off_t offset){
+        ssize_t File::read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
-            return this->libc->pread(__LINE__, fd, buf, count, offset);
+            return t.status(this->libc->pread(__LINE__, fd, buf, count, offset));
         }
-        int File::truncate(boost::filesystem::path v_path, int fd, off_t length){
+        int File::truncate(const boost::filesystem::path &v_path, int fd, off_t length){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
             if(fd < 0){
-                return this->libc->truncate(__LINE__, p.c_str(), length);
+                return t.status(this->libc->truncate(__LINE__, p.c_str(), length));
             }
             else{
-                return this->libc->ftruncate(__LINE__, fd, length);
+                return t.status(this->libc->ftruncate(__LINE__, fd, length));
             }
         }
+        int File::fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
+
+            return t.status(this->libc->fallocate(__LINE__, fd, mode, offset, length));
+        }
+        ssize_t File::copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                      const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
+
+            // file systems sharing extents (btrfs, xfs) reflink instead of copying
+            loff_t in = off_in, out = off_out;
+            return t.status(this->libc->copy_file_range(__LINE__, fd_in, &in, fd_out, &out, len, 0));
+        }
+        int File::fgetattr(const boost::filesystem::path &v_file_name, int fd, struct stat *buf){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            return t.status(this->libc->fstat(__LINE__, fd, buf));
+        }
+        int File::descriptor(const boost::filesystem::path &v_file_name, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            // fd is the backing file's own descriptor
+            return t.status(fd);
+        }
 
         int File::access(boost::filesystem::path v_path, int mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly && (mode&F_OK) != F_OK && (mode&R_OK) != R_OK){ errno = EROFS; return -1; }
+            if(this->readonly && (mode&F_OK) != F_OK && (mode&R_OK) != R_OK){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
-            return this->libc->access(__LINE__, p.c_str(), mode);
+            return t.status(this->libc->access(__LINE__, p.c_str(), mode));
         }
 
         int File::unlink(boost::filesystem::path v_path){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
-            return this->libc->unlink(__LINE__, p.c_str());
+            return t.status(this->libc->unlink(__LINE__, p.c_str()));
         }
         
         int File::link(boost::filesystem::path oldpath, const boost::filesystem::path newpath){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path oldp = this->concatPath(this->u.path(), oldpath);
             boost::filesystem::path newp = this->concatPath(this->u.path(), newpath);
-            return this->libc->link(__LINE__, oldp.c_str(), newp.c_str());
+            return t.status(this->libc->link(__LINE__, oldp.c_str(), newp.c_str()));
         }
         int File::symlink(boost::filesystem::path oldpath, const boost::filesystem::path newpath){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path oldp = this->concatPath(this->u.path(), oldpath);
             boost::filesystem::path newp = this->concatPath(this->u.path(), newpath);
-            return this->libc->symlink(__LINE__, oldp.c_str(), newp.c_str());
+            return t.status(this->libc->symlink(__LINE__, oldp.c_str(), newp.c_str()));
         }
         int File::mkfifo(boost::filesystem::path v_path, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
-            return this->libc->mkfifo(__LINE__, p.c_str(), mode);
+            return t.status(this->libc->mkfifo(__LINE__, p.c_str(), mode));
         }
         int File::mknod(boost::filesystem::path v_path, mode_t mode, dev_t dev){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
-            return this->libc->mknod(__LINE__, p.c_str(), mode, dev);
+            return t.status(this->libc->mknod(__LINE__, p.c_str(), mode, dev));
         }
 
-        int File::fsync(boost::filesystem::path v_path, int fd){
+        int File::flush(const boost::filesystem::path &v_path, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            // closing a duplicate reports delayed write errors (e.g. nfs backed volumes)
+            // without giving up the descriptor itself
+            int dupfd = this->libc->dup(__LINE__, fd);
+            if(dupfd == -1){
+                return t.status(-1);
+            }
+            return t.status(this->libc->close(__LINE__, dupfd));
+        }
+        int File::fsync(const boost::filesystem::path &v_path, int fd){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
-            return this->libc->fsync(__LINE__, fd);
+            return t.status(this->libc->fsync(__LINE__, fd));
         }
-        int File::lock(boost::filesystem::path v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner){
+        int File::lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            return this->libc->ulockmgr_op(fd, cmd, lck, lock_owner, (size_t)sizeof(*lock_owner));
+            return t.status(this->libc->ulockmgr_op(fd, cmd, lck, lock_owner, (size_t)sizeof(*lock_owner)));
         }
 
         int File::setxattr(boost::filesystem::path v_path, const std::string attrname, const char *attrval, size_t attrvalsize, int flags){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            return this->libc->setxattr(__LINE__, v_path.string().c_str(), attrname.c_str(), attrval, attrvalsize, flags);
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
+
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
+            return t.status(this->libc->lsetxattr(__LINE__, p.c_str(), attrname.c_str(), attrval, attrvalsize, flags));
         }
         int File::getxattr(boost::filesystem::path v_path, const std::string attrname, char *buf, size_t count){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            return this->libc->getxattr(__LINE__, v_path.string().c_str(), attrname.c_str(), buf, count);
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
+            return t.status(this->libc->lgetxattr(__LINE__, p.c_str(), attrname.c_str(), buf, count));
         }
         int File::listxattr(boost::filesystem::path v_path, char *buf, size_t count){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            return this->libc->listxattr(__LINE__, v_path.string().c_str(), buf, count);
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
+            return t.status(this->libc->llistxattr(__LINE__, p.c_str(), buf, count));
         }
         int File::removexattr(boost::filesystem::path v_path, const std::string attrname){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            return this->libc->removexattr(__LINE__, v_path.string().c_str(), attrname.c_str());
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
+
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
+            return t.status(this->libc->lremovexattr(__LINE__, p.c_str(), attrname.c_str()));
         }
     }
 }
@@ -21,6 +21,7 @@ namespace Springy{
 
                 virtual std::string string();
                 virtual bool isLocal();
+                virtual boost::filesystem::path backingPath(const boost::filesystem::path &v_path);
 
                 virtual int getattr(boost::filesystem::path v_file_name, struct stat *buf);
 
@@ -41,11 +42,16 @@ namespace Springy{
 
                 virtual int open(boost::filesystem::path v_file_name, int flags, mode_t mode=0);
                 virtual int creat(boost::filesystem::path v_file_name, mode_t mode);
-                virtual int close(boost::filesystem::path v_file_name, int fd);
+                virtual int close(const boost::filesystem::path &v_file_name, int fd);
 
-                virtual ssize_t write(boost::filesystem::path v_file_name, int fd, const void *buf, size_t count, off_t offset);
-                virtual ssize_t read(boost::filesystem::path v_file_name, int fd, void *buf, size_t count, off_t offset);
-                virtual int truncate(boost::filesystem::path v_path, int fd, off_t length);
+                virtual ssize_t write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset);
+                virtual ssize_t read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset);
+                virtual int truncate(const boost::filesystem::path &v_path, int fd, off_t length);
+                virtual int fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length);
+                virtual ssize_t copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                                const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len);
+                virtual int fgetattr(const boost::filesystem::path &v_file_name, int fd, struct stat *buf);
+                virtual int descriptor(const boost::filesystem::path &v_file_name, int fd);
 
                 virtual int access(boost::filesystem::path v_path, int mode);
                 virtual int unlink(boost::filesystem::path v_path);
@@ -55,9 +61,10 @@ namespace Springy{
                 virtual int mkfifo(boost::filesystem::path v_path, mode_t mode);
                 virtual int mknod(boost::filesystem::path v_path, mode_t mode, dev_t dev);
 
-                virtual int fsync(boost::filesystem::path v_path, int fd);
+                virtual int flush(const boost::filesystem::path &v_path, int fd);
+                virtual int fsync(const boost::filesystem::path &v_path, int fd);
 
-                virtual int lock(boost::filesystem::path v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner);
+                virtual int lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner);
 
                 virtual int setxattr(boost::filesystem::path v_path, const std::string attrname, const char *attrval, size_t attrvalsize, int flags);
                 virtual int getxattr(boost::filesystem::path v_path, const std::string attrname, char *buf, size_t count);
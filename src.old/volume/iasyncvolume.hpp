@@ -0,0 +1,119 @@
+#ifndef SPRINGY_VOLUME_IASYNCVOLUME
+#define SPRINGY_VOLUME_IASYNCVOLUME
+
+#include <sys/statvfs.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include <boost/filesystem.hpp>
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <unordered_map>
+
+namespace Springy{
+    namespace Volume{
+        /**
+         * asynchronous counterpart of IVolume
+         *
+         * every operation returns immediately and calls the handler once it is
+         * done, with what the synchronous call returns and errno if that was -1
+         * (0 otherwise). the handler runs on a thread of the volume's executor,
+         * so it has to be short or hand its work on. an operation requested from
+         * one of those threads completes before the call returns, so SyncVolume
+         * does not wait on an executor which only waits itself.
+         *
+         * paths and scalars are copied, pointed to buffers, stat structs, locks
+         * and the readdir result have to stay valid until the handler ran.
+         *
+         * AsyncVolume runs an IVolume this way, SyncVolume turns an IAsyncVolume
+         * back into an IVolume.
+         */
+        class IAsyncVolume{
+            public:
+                typedef std::function<void(ssize_t result, int error)> Handler;
+
+                struct Completion{
+                    ssize_t result;
+                    int error;
+                };
+
+                // a handler fulfilling future, for callers which rather wait or
+                // collect several operations than continue in the handler
+                static Handler promise(std::future<Completion> &future){
+                    std::shared_ptr<std::promise<Completion> > p = std::make_shared<std::promise<Completion> >();
+                    future = p->get_future();
+                    return [p](ssize_t result, int error){
+                        Completion c;
+                        c.result = result;
+                        c.error = error;
+                        p->set_value(c);
+                    };
+                }
+
+                virtual ~IAsyncVolume(){}
+                virtual std::string string() = 0;
+                virtual bool isLocal() = 0;
+                virtual boost::filesystem::path backingPath(const boost::filesystem::path &v_path) = 0;
+
+                // path based operations
+
+                virtual void getattr(const boost::filesystem::path &v_file_name, struct ::stat *buf, Handler handler) = 0;
+
+                virtual void statvfs(const boost::filesystem::path &v_path, struct ::statvfs *stat, Handler handler) = 0;
+
+                virtual void chown(const boost::filesystem::path &v_file_name, uid_t owner, gid_t group, Handler handler) = 0;
+
+                virtual void chmod(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler) = 0;
+                virtual void mkdir(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler) = 0;
+                virtual void rmdir(const boost::filesystem::path &v_path, Handler handler) = 0;
+
+                virtual void rename(const boost::filesystem::path &v_old_name, const boost::filesystem::path &v_new_name, Handler handler) = 0;
+
+                virtual void utimensat(const boost::filesystem::path &v_path, const struct timespec times[2], Handler handler) = 0;
+
+                virtual void readdir(const boost::filesystem::path &v_path, std::unordered_map<std::string, struct stat> &result, Handler handler) = 0;
+                virtual void readlink(const boost::filesystem::path &v_path, char *buf, size_t bufsiz, Handler handler) = 0;
+
+                virtual void access(const boost::filesystem::path &v_path, int mode, Handler handler) = 0;
+                virtual void unlink(const boost::filesystem::path &v_path, Handler handler) = 0;
+
+                virtual void link(const boost::filesystem::path &oldpath, const boost::filesystem::path &newpath, Handler handler) = 0;
+                virtual void symlink(const boost::filesystem::path &oldpath, const boost::filesystem::path &newpath, Handler handler) = 0;
+                virtual void mkfifo(const boost::filesystem::path &v_path, mode_t mode, Handler handler) = 0;
+                virtual void mknod(const boost::filesystem::path &v_path, mode_t mode, dev_t dev, Handler handler) = 0;
+
+                // descriptor based operations
+
+                virtual void open(const boost::filesystem::path &v_file_name, int flags, mode_t mode, Handler handler) = 0;
+                virtual void creat(const boost::filesystem::path &v_file_name, mode_t mode, Handler handler) = 0;
+                virtual void close(const boost::filesystem::path &v_file_name, int fd, Handler handler) = 0;
+
+                virtual void write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset, Handler handler) = 0;
+                virtual void read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset, Handler handler) = 0;
+                virtual void truncate(const boost::filesystem::path &v_path, int fd, off_t length, Handler handler) = 0;
+                virtual void fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length, Handler handler) = 0;
+                virtual void copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                             const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len, Handler handler) = 0;
+                virtual void fgetattr(const boost::filesystem::path &v_file_name, int fd, struct ::stat *buf, Handler handler) = 0;
+                // no i/o involved, answered right away like IVolume::descriptor
+                virtual int descriptor(const boost::filesystem::path &v_file_name, int fd) = 0;
+
+                virtual void flush(const boost::filesystem::path &v_path, int fd, Handler handler) = 0;
+                virtual void fsync(const boost::filesystem::path &v_path, int fd, Handler handler) = 0;
+
+                virtual void lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner, Handler handler) = 0;
+
+                virtual void setxattr(const boost::filesystem::path &v_path, const std::string &attrname, const char *attrval, size_t attrvalsize, int flags, Handler handler) = 0;
+                virtual void getxattr(const boost::filesystem::path &v_path, const std::string &attrname, char *buf, size_t count, Handler handler) = 0;
+                virtual void listxattr(const boost::filesystem::path &v_path, char *buf, size_t count, Handler handler) = 0;
+                virtual void removexattr(const boost::filesystem::path &v_path, const std::string &attrname, Handler handler) = 0;
+        };
+    }
+}
+
+#endif
@@ -9,6 +9,9 @@
 
 #include <boost/filesystem.hpp>
 
+#include <stdint.h>
+
+#include <atomic>
 #include <unordered_map>
 
 /*
@@ -26,9 +29,13 @@ namespace Springy{
     namespace Volume{
         class IVolume{
             public:
+                IVolume() : traceId(0){}
                 virtual ~IVolume(){}
                 virtual std::string string() = 0;
                 virtual bool isLocal() = 0;
+                // absolute path of v_path on the local file system, empty if the
+                // volume's files aren't reachable that way
+                virtual boost::filesystem::path backingPath(const boost::filesystem::path &v_path) = 0;
 
                 // path based operations
 
@@ -61,20 +68,34 @@ namespace Springy{
 
                 virtual int open(boost::filesystem::path v_file_name, int flags, mode_t mode=0) = 0;
                 virtual int creat(boost::filesystem::path v_file_name, mode_t mode) = 0;
-                virtual int close(boost::filesystem::path v_file_name, int fd) = 0;
-
-                virtual ssize_t write(boost::filesystem::path v_file_name, int fd, const void *buf, size_t count, off_t offset) = 0;
-                virtual ssize_t read(boost::filesystem::path v_file_name, int fd, void *buf, size_t count, off_t offset) = 0;
-                virtual int truncate(boost::filesystem::path v_path, int fd, off_t length) = 0;
-
-                virtual int fsync(boost::filesystem::path v_path, int fd) = 0;
+                virtual int close(const boost::filesystem::path &v_file_name, int fd) = 0;
+
+                virtual ssize_t write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset) = 0;
+                virtual ssize_t read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset) = 0;
+                virtual int truncate(const boost::filesystem::path &v_path, int fd, off_t length) = 0;
+                // fallocate(2) including FALLOC_FL_PUNCH_HOLE and FALLOC_FL_ZERO_RANGE
+                virtual int fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length) = 0;
+                // copies between two files of this volume without passing the data
+                // through springy, returns the bytes copied like copy_file_range(2)
+                virtual ssize_t copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                                const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len) = 0;
+                virtual int fgetattr(const boost::filesystem::path &v_file_name, int fd, struct ::stat *buf) = 0;
+                // kernel descriptor holding the data of fd, so it can be spliced
+                // instead of copied through read()/write(). -1 if there is none
+                virtual int descriptor(const boost::filesystem::path &v_file_name, int fd) = 0;
+
+                virtual int flush(const boost::filesystem::path &v_path, int fd) = 0;
+                virtual int fsync(const boost::filesystem::path &v_path, int fd) = 0;
                 
-                virtual int lock(boost::filesystem::path v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner) = 0;
+                virtual int lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner) = 0;
 
                 virtual int setxattr(boost::filesystem::path v_path, const std::string attrname, const char *attrval, size_t attrvalsize, int flags) = 0;
                 virtual int getxattr(boost::filesystem::path v_path, const std::string attrname, char *buf, size_t count) = 0;
                 virtual int listxattr(boost::filesystem::path v_path, char *buf, size_t count) = 0;
                 virtual int removexattr(boost::filesystem::path v_path, const std::string attrname) = 0;
+
+                // stands for string() in Trace records, assigned by the first Trace::tagVolume
+                std::atomic<uint32_t> traceId;
         };
     }
 }
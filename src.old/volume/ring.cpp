@@ -0,0 +1,267 @@
+#include "ring.hpp"
+#include "../trace.hpp"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <set>
+
+namespace Springy{
+    namespace Volume{
+        // every ring, so forget() reaches the fixed files of all threads
+        static std::mutex ringsMutex;
+        static std::set<Ring*> rings;
+
+        namespace{
+            struct ThreadRing{
+                bool tried;
+                Ring *ring;
+
+                ThreadRing() : tried(false), ring(NULL){}
+                ~ThreadRing(){ delete this->ring; }
+            };
+        }
+
+        Ring* Ring::current(Springy::LibC::ILibC *libc){
+            static thread_local ThreadRing tr;
+            if(tr.tried){
+                if(tr.ring != NULL && tr.ring->fd == -1){
+                    // torn down by submit(), the thread does without from now on
+                    delete tr.ring;
+                    tr.ring = NULL;
+                }
+                return tr.ring;
+            }
+            tr.tried = true;
+
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            Ring *ring = new Ring(libc);
+            if(!ring->setUp()){
+                delete ring;
+                return NULL;
+            }
+
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.insert(ring);
+            tr.ring = ring;
+            return ring;
+        }
+
+        void Ring::forget(int fd){
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for(std::set<Ring*>::iterator it=rings.begin();it!=rings.end();it++){
+                (*it)->unregister(fd);
+            }
+        }
+
+        Ring::Ring(Springy::LibC::ILibC *libc) : libc(libc), fd(-1), sqRing(MAP_FAILED), sqRingSize(0), cqRing(MAP_FAILED), cqRingSize(0),
+                                                 sqes((struct io_uring_sqe*)MAP_FAILED), tail(0), queued(0), fixedEnabled(false){}
+        Ring::~Ring(){
+            {
+                std::lock_guard<std::mutex> lock(ringsMutex);
+                rings.erase(this);
+            }
+            this->tearDown();
+        }
+
+        void Ring::tearDown(){
+            {
+                // forget() must not update the table of a closed ring
+                std::lock_guard<std::mutex> lock(this->fixedMutex);
+                this->fixedEnabled = false;
+                this->fixed.clear();
+                this->freeSlots.clear();
+            }
+
+            if(this->sqes != MAP_FAILED){
+                this->libc->munmap(__LINE__, this->sqes, Ring::entries * sizeof(struct io_uring_sqe));
+                this->sqes = (struct io_uring_sqe*)MAP_FAILED;
+            }
+            if(this->cqRing != MAP_FAILED && this->cqRing != this->sqRing){
+                this->libc->munmap(__LINE__, this->cqRing, this->cqRingSize);
+            }
+            this->cqRing = MAP_FAILED;
+            if(this->sqRing != MAP_FAILED){
+                this->libc->munmap(__LINE__, this->sqRing, this->sqRingSize);
+                this->sqRing = MAP_FAILED;
+            }
+            if(this->fd != -1){
+                this->libc->close(__LINE__, this->fd);
+                this->fd = -1;
+            }
+        }
+
+        bool Ring::setUp(){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            struct io_uring_params p;
+            memset(&p, 0, sizeof(p));
+            this->fd = this->libc->io_uring_setup(__LINE__, Ring::entries, &p);
+            if(this->fd == -1){
+                return false;
+            }
+            // statx, openat, close, read and write came with 5.6, fast poll with 5.7
+            if(!(p.features & IORING_FEAT_FAST_POLL)){
+                return false;
+            }
+
+            this->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            this->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+            bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if(single){
+                this->sqRingSize = this->cqRingSize = std::max(this->sqRingSize, this->cqRingSize);
+            }
+
+            this->sqRing = this->libc->mmap(__LINE__, NULL, this->sqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+            if(this->sqRing == MAP_FAILED){
+                return false;
+            }
+            if(single){
+                this->cqRing = this->sqRing;
+            }
+            else{
+                this->cqRing = this->libc->mmap(__LINE__, NULL, this->cqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+                if(this->cqRing == MAP_FAILED){
+                    return false;
+                }
+            }
+            this->sqes = (struct io_uring_sqe*)this->libc->mmap(__LINE__, NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ|PROT_WRITE,
+                                                                MAP_SHARED|MAP_POPULATE, this->fd, IORING_OFF_SQES);
+            if(this->sqes == MAP_FAILED){
+                return false;
+            }
+
+            char *sq = (char*)this->sqRing;
+            char *cq = (char*)this->cqRing;
+            this->sqHead  = (unsigned*)(sq + p.sq_off.head);
+            this->sqTail  = (unsigned*)(sq + p.sq_off.tail);
+            this->sqMask  = *(unsigned*)(sq + p.sq_off.ring_mask);
+            this->sqArray = (unsigned*)(sq + p.sq_off.array);
+            this->cqHead  = (unsigned*)(cq + p.cq_off.head);
+            this->cqTail  = (unsigned*)(cq + p.cq_off.tail);
+            this->cqMask  = *(unsigned*)(cq + p.cq_off.ring_mask);
+            this->cqes    = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+            this->tail    = *this->sqTail;
+
+            // an empty table, slots are filled with IORING_REGISTER_FILES_UPDATE
+            std::vector<int> files(Ring::fixedFiles, -1);
+            if(this->libc->io_uring_register(__LINE__, this->fd, IORING_REGISTER_FILES, &files[0], files.size()) == 0){
+                this->fixedEnabled = true;
+                for(unsigned i=Ring::fixedFiles;i>0;i--){
+                    this->freeSlots.push_back(i-1);
+                }
+            }
+
+            return true;
+        }
+
+        struct io_uring_sqe* Ring::prepare(){
+            if(this->queued >= Ring::entries){
+                return NULL;
+            }
+
+            unsigned index = (this->tail + this->queued) & this->sqMask;
+            struct io_uring_sqe *sqe = &this->sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->user_data = this->queued;
+            this->sqArray[index] = index;
+            this->queued++;
+
+            return sqe;
+        }
+
+        void Ring::file(struct io_uring_sqe *sqe, int fd, bool hot){
+            sqe->fd = fd;
+            if(!this->fixedEnabled){
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(this->fixedMutex);
+            std::unordered_map<int, unsigned>::iterator it = this->fixed.find(fd);
+            if(it == this->fixed.end()){
+                if(!hot || this->freeSlots.empty()){
+                    return;
+                }
+
+                struct io_uring_files_update update;
+                memset(&update, 0, sizeof(update));
+                update.offset = this->freeSlots.back();
+                update.fds = (uint64_t)(uintptr_t)&fd;
+                if(this->libc->io_uring_register(__LINE__, this->fd, IORING_REGISTER_FILES_UPDATE, &update, 1) != 1){
+                    return;
+                }
+                it = this->fixed.insert(std::make_pair(fd, this->freeSlots.back())).first;
+                this->freeSlots.pop_back();
+            }
+
+            sqe->fd = it->second;
+            sqe->flags |= IOSQE_FIXED_FILE;
+        }
+
+        void Ring::unregister(int fd){
+            std::lock_guard<std::mutex> lock(this->fixedMutex);
+            std::unordered_map<int, unsigned>::iterator it = this->fixed.find(fd);
+            if(it == this->fixed.end()){
+                return;
+            }
+
+            int none = -1;
+            struct io_uring_files_update update;
+            memset(&update, 0, sizeof(update));
+            update.offset = it->second;
+            update.fds = (uint64_t)(uintptr_t)&none;
+            this->libc->io_uring_register(__LINE__, this->fd, IORING_REGISTER_FILES_UPDATE, &update, 1);
+
+            this->freeSlots.push_back(it->second);
+            this->fixed.erase(it);
+        }
+
+        int Ring::submit(){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            unsigned queued = this->queued;
+            if(queued == 0){
+                return t.result(0);
+            }
+
+            this->tail += queued;
+            __atomic_store_n(this->sqTail, this->tail, __ATOMIC_RELEASE);
+            this->queued = 0;
+
+            unsigned pending = queued;
+            unsigned done = 0;
+            while(done < queued){
+                int res = this->libc->io_uring_enter(__LINE__, this->fd, pending, queued - done, IORING_ENTER_GETEVENTS);
+                if(res == -1){
+                    if(errno == EINTR || errno == EAGAIN || errno == EBUSY){
+                        continue;
+                    }
+                    // the published entries would be submitted with the next request,
+                    // and whatever broke the ring is likely to break it again
+                    int err = errno;
+                    bool untaken = pending == queued;
+                    t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+                    this->tearDown();
+                    return t.result(untaken ? -ECANCELED : -err);
+                }
+                pending -= std::min((unsigned)res, pending);
+
+                unsigned head = *this->cqHead;
+                unsigned cqTail = __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE);
+                for(;head != cqTail;head++){
+                    const struct io_uring_cqe &cqe = this->cqes[head & this->cqMask];
+                    if(cqe.user_data < Ring::entries){
+                        this->results[cqe.user_data] = cqe.res;
+                    }
+                    done++;
+                }
+                __atomic_store_n(this->cqHead, head, __ATOMIC_RELEASE);
+            }
+
+            return t.result(done);
+        }
+    }
+}
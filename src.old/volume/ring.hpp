@@ -0,0 +1,96 @@
+#ifndef SPRINGY_VOLUME_RING
+#define SPRINGY_VOLUME_RING
+
+#include <stdint.h>
+#include <linux/io_uring.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../libc/ilibc.hpp"
+
+namespace Springy{
+    namespace Volume{
+        /**
+         * io_uring of the calling thread, set up with the raw syscalls
+         *
+         * requests are queued with prepare() and handed to the kernel together
+         * by submit(), so independent ones (e.g. the statx of every entry of a
+         * directory) cost a single io_uring_enter. descriptors doing reads and
+         * writes are registered with the ring as fixed files while slots are
+         * free, which saves the kernel the descriptor lookup per request.
+         */
+        class Ring{
+            public:
+                static const unsigned entries = 64;
+                static const unsigned fixedFiles = 64;
+
+                // NULL if the kernel offers no io_uring (too old, kernel.io_uring_disabled)
+                // or the thread's ring failed, callers fall back to the plain syscalls
+                // then. asked once per thread
+                static Ring* current(Springy::LibC::ILibC *libc);
+                // has to be called before fd is closed, drops it from the fixed files of every ring
+                static void forget(int fd);
+
+                ~Ring();
+
+                // a cleared submission entry, NULL once entries are queued
+                struct io_uring_sqe* prepare();
+                // targets fd, through its fixed file slot if it has one. a hot
+                // descriptor (reads, writes) gets a slot if one is free
+                void file(struct io_uring_sqe *sqe, int fd, bool hot=false);
+                // submits everything prepared and waits for it. the number of
+                // completions or -errno, result(i) is the cqe res of the i-th prepare().
+                // a failing io_uring_enter tears the ring down, -ECANCELED tells
+                // the kernel took none of the requests, so they can be redone without it
+                int submit();
+                int result(unsigned i) const{ return this->results[i]; }
+                // prepare()d exactly one request
+                int run(){
+                    int res = this->submit();
+                    return res < 0 ? res : this->results[0];
+                }
+
+            protected:
+                Springy::LibC::ILibC *libc;
+                int fd;     // -1 once torn down
+
+                void *sqRing;
+                size_t sqRingSize;
+                void *cqRing;
+                size_t cqRingSize;
+                struct io_uring_sqe *sqes;
+
+                unsigned *sqHead;
+                unsigned *sqTail;
+                unsigned sqMask;
+                unsigned *sqArray;
+                unsigned *cqHead;
+                unsigned *cqTail;
+                unsigned cqMask;
+                struct io_uring_cqe *cqes;
+
+                unsigned tail;      // next free sqe, not yet visible to the kernel
+                unsigned queued;
+                int results[entries];
+
+                // fixed files, forget() changes them from other threads
+                std::mutex fixedMutex;
+                bool fixedEnabled;
+                std::unordered_map<int, unsigned> fixed;    // fd -> slot
+                std::vector<unsigned> freeSlots;
+
+                Ring(Springy::LibC::ILibC *libc);
+                bool setUp();
+                void tearDown();
+                void unregister(int fd);
+
+            private:
+                Ring(const Ring&);
+                Ring& operator=(const Ring&);
+        };
+    }
+}
+
+#endif
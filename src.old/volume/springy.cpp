@@ -3,14 +3,18 @@
 #include "../util/json.hpp"
 #include "../util/string.hpp"
 #include "../exception.hpp"
+#include "../util/synchronized.hpp"
 
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+
 namespace Springy{
     namespace Volume{
-        Springy::Springy(::Springy::LibC::ILibC *libc, ::Springy::Util::Uri u) : u(u){
+        Springy::Springy(::Springy::LibC::ILibC *libc, ::Springy::Util::Uri u, ::Springy::Volume::BlockCache *cache) : u(u){
             this->libc = libc;
+            this->cache = cache;
             this->readonly = (this->u.query("ro").size()>0);
             this->maxBodySize = 16*1024*1024;  // 16 MB
         }
@@ -18,6 +22,7 @@ namespace Springy{
 
         std::string Springy::string(){ return this->u.string(); }
         bool Springy::isLocal(){ return false; }
+        boost::filesystem::path Springy::backingPath(const boost::filesystem::path &v_path){ return boost::filesystem::path(); }
         
         boost::filesystem::path Springy::concatPath(const boost::filesystem::path &p1, const boost::filesystem::path &p2){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
@@ -184,6 +189,97 @@ namespace Springy{
             return st;
         }
 
+        void Springy::trackDescriptor(boost::filesystem::path v_file_name, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->cache == NULL || this->cache->capacity() == 0){
+                return;
+            }
+
+            struct stat st;
+            if(this->getattr(v_file_name, &st) != 0){
+                return;
+            }
+
+            Synchronized syncFiles(this->files);
+
+            FileKey key = std::make_pair(st.st_dev, st.st_ino);
+            std::map<FileKey, FileIdentity>::iterator it = this->files.find(key);
+            if(it == this->files.end()){
+                FileIdentity identity;
+                identity.dev = st.st_dev;
+                identity.ino = st.st_ino;
+                identity.validator.generation = 0;
+                identity.refs = 0;
+                it = this->files.insert(std::make_pair(key, identity)).first;
+            }
+            // a changed mtime or size on open invalidates everything cached for the file
+            it->second.validator.mtime = st.st_mtime;
+            it->second.validator.size = st.st_size;
+            it->second.refs++;
+
+            this->descriptors[fd] = key;
+        }
+        void Springy::untrackDescriptor(int fd){
+            Synchronized syncFiles(this->files);
+
+            std::map<int, FileKey>::iterator dit = this->descriptors.find(fd);
+            if(dit == this->descriptors.end()){
+                return;
+            }
+            std::map<FileKey, FileIdentity>::iterator it = this->files.find(dit->second);
+            if(it != this->files.end() && --it->second.refs <= 0){
+                this->files.erase(it);
+            }
+            this->descriptors.erase(dit);
+        }
+        void Springy::invalidateDescriptor(int fd){
+            Synchronized syncFiles(this->files);
+
+            std::map<int, FileKey>::iterator dit = this->descriptors.find(fd);
+            if(dit == this->descriptors.end()){
+                return;
+            }
+            std::map<FileKey, FileIdentity>::iterator it = this->files.find(dit->second);
+            if(it != this->files.end()){
+                it->second.validator.generation++;
+            }
+        }
+        // for changes made without a descriptor, e.g. truncate by path
+        void Springy::invalidatePath(const boost::filesystem::path &v_file_name){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->cache == NULL || this->cache->capacity() == 0){
+                return;
+            }
+
+            struct stat st;
+            if(this->getattr(v_file_name, &st) != 0){
+                return;
+            }
+
+            Synchronized syncFiles(this->files);
+
+            std::map<FileKey, FileIdentity>::iterator it = this->files.find(std::make_pair(st.st_dev, st.st_ino));
+            if(it != this->files.end()){
+                it->second.validator.generation++;
+            }
+        }
+        bool Springy::identityByDescriptor(int fd, FileIdentity &identity){
+            Synchronized syncFiles(this->files, Synchronized::LockType::READ);
+
+            std::map<int, FileKey>::iterator dit = this->descriptors.find(fd);
+            if(dit == this->descriptors.end()){
+                return false;
+            }
+            std::map<FileKey, FileIdentity>::iterator it = this->files.find(dit->second);
+            if(it == this->files.end()){
+                return false;
+            }
+            identity = it->second;
+            return true;
+        }
+
         int Springy::getattr(boost::filesystem::path v_file_name, struct stat *buf){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
@@ -198,12 +294,12 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
             else{
                 *buf = this->readStatFromJson(j);
 
-                return 0;
+                return t.status(0);
             }
         }
         int Springy::statvfs(boost::filesystem::path v_path, struct ::statvfs *stat){
@@ -220,7 +316,7 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
             else{
                 stat->f_bsize   = j["f_bsize"];
@@ -235,13 +331,13 @@ namespace Springy{
                 stat->f_flag    = j["f_flag"];
                 stat->f_namemax = j["f_namemax"];
 
-                return 0;
+                return t.status(0);
             }
         }
         int Springy::chown(boost::filesystem::path v_file_name, uid_t owner, gid_t group){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
             
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
 
@@ -256,15 +352,15 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
 
         int Springy::chmod(boost::filesystem::path v_file_name, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
             
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
 
@@ -279,14 +375,14 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
         int Springy::mkdir(boost::filesystem::path v_file_name, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
             
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
 
@@ -300,14 +396,14 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
         int Springy::rmdir(boost::filesystem::path v_path){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
 
@@ -320,15 +416,15 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
 
         int Springy::rename(boost::filesystem::path v_old_name, boost::filesystem::path v_new_name){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             nlohmann::json j;
             j["old"] = this->concatPath(this->u.path(), v_old_name);
@@ -340,15 +436,15 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
 
         int Springy::utimensat(boost::filesystem::path v_path, const struct timespec times[2]){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
 
@@ -370,9 +466,9 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
 
         int Springy::readdir(boost::filesystem::path v_path, std::unordered_map<std::string, struct stat> &result){
@@ -389,7 +485,7 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
 
             // iterate the array
@@ -400,7 +496,7 @@ namespace Springy{
                 result.insert(std::make_pair(spath, this->readStatFromJson(entry)));
             }
 
-            return 0;
+            return t.status(0);
         }
         
         ssize_t Springy::readlink(boost::filesystem::path v_path, char *buf, size_t bufsiz){
@@ -417,7 +513,7 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
 
             std::string link = j["link"];
@@ -426,13 +522,13 @@ namespace Springy{
             }
             memcpy(buf, link.c_str(), bufsiz);            
 
-            return bufsiz;
+            return t.status(bufsiz);
         }
 
         int Springy::access(boost::filesystem::path v_path, int mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly && (mode&F_OK) != F_OK && (mode&R_OK) != R_OK){ errno = EROFS; return -1; }
+            if(this->readonly && (mode&F_OK) != F_OK && (mode&R_OK) != R_OK){ errno = EROFS; return t.status(-1); }
             
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
 
@@ -446,16 +542,16 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
             
-            return 0;
+            return t.status(0);
         }
 
         int Springy::unlink(boost::filesystem::path v_path){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
 
@@ -468,16 +564,16 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
             
-            return 0;
+            return t.status(0);
         }
         
         int Springy::link(boost::filesystem::path oldpath, const boost::filesystem::path newpath){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             nlohmann::json j;
             j["old"] = this->concatPath(this->u.path(), oldpath);
@@ -489,14 +585,14 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
         int Springy::symlink(boost::filesystem::path oldpath, const boost::filesystem::path newpath){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             nlohmann::json j;
             j["old"] = this->concatPath(this->u.path(), oldpath);
@@ -508,14 +604,14 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
         int Springy::mkfifo(boost::filesystem::path v_path, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
 
@@ -529,15 +625,15 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
 
-            return 0;
+            return t.status(0);
         }
         int Springy::mknod(boost::filesystem::path v_path, mode_t mode, dev_t dev){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
 
@@ -552,10 +648,10 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
 
-            return 0;
+            return t.status(0);
         }
 
         // descriptor based operations
@@ -563,7 +659,7 @@ namespace Springy{
         int Springy::open(boost::filesystem::path v_file_name, int flags, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            if(this->readonly && (flags&O_RDONLY) != O_RDONLY){ errno = EROFS; return -1; }
+            if(this->readonly && (flags&O_RDONLY) != O_RDONLY){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
 
@@ -578,15 +674,16 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
             int fd = j["fd"];
-            return fd;
+            this->trackDescriptor(v_file_name, fd);
+            return t.status(fd);
         }
         int Springy::creat(boost::filesystem::path v_file_name, mode_t mode){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
 
@@ -600,12 +697,13 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
             int fd = j["fd"];
-            return fd;
+            this->trackDescriptor(v_file_name, fd);
+            return t.status(fd);
         }
-        int Springy::close(boost::filesystem::path v_file_name, int fd){
+        int Springy::close(const boost::filesystem::path &v_file_name, int fd){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
@@ -615,17 +713,19 @@ namespace Springy{
             j["fd"] = fd;
             j = this->sendRequest("/api/volume/close", j);
 
+            this->untrackDescriptor(fd);
+
             int err = j["errno"];
             err = err < 0 ? -err : err;
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
 
-        ssize_t Springy::write(boost::filesystem::path v_file_name, int fd, const void *buf, size_t count, off_t offset){
+        ssize_t Springy::write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
@@ -637,16 +737,62 @@ namespace Springy{
             j["buf"] = ::Springy::Util::String::encode64(std::string((const char*)buf, count));
             j = this->sendRequest("/api/volume/write", j);
 
+            this->invalidateDescriptor(fd);
+
             int err = j["errno"];
             err = err < 0 ? -err : err;
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
             return j["size"];
         }
-        ssize_t Springy::read(boost::filesystem::path v_file_name, int fd, void *buf, size_t count, off_t offset){
+        ssize_t Springy::read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            FileIdentity identity;
+            if(this->cache == NULL || !this->identityByDescriptor(fd, identity)){
+                return t.status(this->readRemote(v_file_name, fd, buf, count, offset));
+            }
+
+            // serve the request block by block, fetching whole blocks on a miss
+            size_t blockSize = this->cache->blockSize();
+            BlockCache::Key key = {this, identity.dev, identity.ino, 0};
+            size_t done = 0;
+            while(done < count){
+                off_t pos = offset + done;
+                key.block = pos / blockSize;
+                size_t inBlock = pos % blockSize;
+                size_t want = std::min(count - done, blockSize - inBlock);
+
+                ssize_t n = this->cache->read(key, identity.validator, (char*)buf + done, inBlock, want);
+                if(n < 0){
+                    std::string block(blockSize, '\0');
+                    ssize_t r = this->readRemote(v_file_name, fd, &block[0], blockSize, key.block * blockSize);
+                    if(r < 0){
+                        return t.status(done > 0 ? (ssize_t)done : -1);
+                    }
+                    block.resize(r);
+                    this->cache->put(key, identity.validator, block);
+
+                    n = 0;
+                    if((size_t)r > inBlock){
+                        n = std::min(want, (size_t)r - inBlock);
+                        memcpy((char*)buf + done, block.data() + inBlock, n);
+                    }
+                }
+
+                done += n;
+                if((size_t)n < want){
+                    // end of file
+                    break;
+                }
+            }
+
+            return t.status(done);
+        }
+        ssize_t Springy::readRemote(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
@@ -663,20 +809,20 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
 
             std::string buffer = ::Springy::Util::String::decode64(j["buf"]);
             if(buffer.size() > 0){
                 memcpy(buf, buffer.data(), buffer.size());
             }
-            return buffer.size();
+            return t.status(buffer.size());
         }
 
-        int Springy::truncate(boost::filesystem::path v_path, int fd, off_t length){
+        int Springy::truncate(const boost::filesystem::path &v_path, int fd, off_t length){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
 
@@ -686,20 +832,120 @@ namespace Springy{
             j["size"] = length;
             j = this->sendRequest("/api/volume/truncate", j);
 
+            if(fd == -1){
+                // files which aren't open have no cached blocks with a current validator
+                this->invalidatePath(v_path);
+            }
+            else{
+                this->invalidateDescriptor(fd);
+            }
+
             int err = j["errno"];
             err = err < 0 ? -err : err;
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
 
-        int Springy::fsync(boost::filesystem::path v_path, int fd){
+        int Springy::fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
+
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
+
+            nlohmann::json j;
+            j["path"] = p.string();
+            j["fd"] = fd;
+            j["mode"] = mode;
+            j["offset"] = offset;
+            j["length"] = length;
+            j = this->sendRequest("/api/volume/fallocate", j);
+
+            // cached blocks of punched or zeroed ranges are stale
+            this->invalidateDescriptor(fd);
+
+            int err = j["errno"];
+            err = err < 0 ? -err : err;
+
+            if(err != 0){
+                errno = err;
+                return t.status(-1);
+            }
+            return t.status(0);
+        }
+
+        ssize_t Springy::copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                         const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
+
+            // the remote copies between its own descriptors, nothing crosses the wire
+            nlohmann::json j;
+            j["path_in"] = this->concatPath(this->u.path(), v_in).string();
+            j["fd_in"] = fd_in;
+            j["offset_in"] = off_in;
+            j["path_out"] = this->concatPath(this->u.path(), v_out).string();
+            j["fd_out"] = fd_out;
+            j["offset_out"] = off_out;
+            j["length"] = len;
+            j = this->sendRequest("/api/volume/copy_file_range", j);
+
+            this->invalidateDescriptor(fd_out);
+
+            int err = j["errno"];
+            err = err < 0 ? -err : err;
+
+            if(err != 0){
+                errno = err;
+                return t.status(-1);
+            }
+            return j["size"];
+        }
+
+        int Springy::fgetattr(const boost::filesystem::path &v_file_name, int fd, struct stat *buf){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
+
+            nlohmann::json j;
+            j["path"] = p.string();
+            j["fd"] = fd;
+            j = this->sendRequest("/api/volume/fgetattr", j);
+
+            int err = j["errno"];
+            err = err < 0 ? -err : err;
+
+            if(err != 0){
+                errno = err;
+                return t.status(-1);
+            }
+
+            *buf = this->readStatFromJson(j);
+            return t.status(0);
+        }
+        int Springy::descriptor(const boost::filesystem::path &v_file_name, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            // fd is a descriptor of the remote instance
+            errno = ENOTSUP;
+            return t.status(-1);
+        }
+
+        int Springy::flush(const boost::filesystem::path &v_path, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            // writes are forwarded synchronously, there is nothing buffered locally
+            return t.status(0);
+        }
+        int Springy::fsync(const boost::filesystem::path &v_path, int fd){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
             
-            if(this->readonly){ errno = EROFS; return -1; }
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
             
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
 
@@ -713,12 +959,12 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
 
-        int Springy::lock(boost::filesystem::path v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner){
+        int Springy::lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
             boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
@@ -742,9 +988,9 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
         
         int Springy::setxattr(boost::filesystem::path v_path, const std::string attrname, const char *attrval, size_t attrvalsize, int flags){
@@ -765,9 +1011,9 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
         int Springy::getxattr(boost::filesystem::path v_path, const std::string attrname, char *buf, size_t count){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
@@ -785,21 +1031,21 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
 
             std::string value = ::Springy::Util::String::decode64(j["xattr"]);
             if(buf == NULL || count == 0){
                 errno = ERANGE;
-                return value.size();
+                return t.status(value.size());
             }
             if(value.size()>count){
                 errno = ERANGE;
-                return -1;
+                return t.status(-1);
             }
             memcpy(buf, value.data(), value.size());
 
-            return 0;
+            return t.status(value.size());
         }
         int Springy::listxattr(boost::filesystem::path v_path, char *buf, size_t count){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
@@ -816,22 +1062,26 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
             
-            size_t offset = 0;
-            for (nlohmann::json::iterator it = j["xattrs"].begin(); it != j["xattrs"].end() && count > 0; ++it) {
+            // names are transferred base64 encoded and handed out as a list of \0 terminated strings
+            std::string list;
+            for (nlohmann::json::iterator it = j["xattrs"].begin(); it != j["xattrs"].end(); ++it) {
                 std::string value = *it;
-                value = ::Springy::Util::String::encode64(value);
-                if((value.size()+1) > count){ continue; }
-                count -= value.size();
-                memcpy(buf+offset, value.data(), value.size());
-                offset += value.size();
-                buf[offset] = '\0';
-                offset++;
+                list.append(::Springy::Util::String::decode64(value));
+                list.push_back('\0');
+            }
+            if(buf == NULL || count == 0){
+                return t.status(list.size());
+            }
+            if(list.size() > count){
+                errno = ERANGE;
+                return t.status(-1);
             }
+            memcpy(buf, list.data(), list.size());
 
-            return 0;
+            return t.status(list.size());
         }
         int Springy::removexattr(boost::filesystem::path v_path, const std::string attrname){
             Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
@@ -849,9 +1099,9 @@ namespace Springy{
 
             if(err != 0){
                 errno = err;
-                return -1;
+                return t.status(-1);
             }
-            return 0;
+            return t.status(0);
         }
     }
 }
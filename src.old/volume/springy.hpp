@@ -1,9 +1,12 @@
-#ifndef SPRINGY_VOLUME_FILE
-#define SPRINGY_VOLUME_FILE
+#ifndef SPRINGY_VOLUME_SPRINGY
+#define SPRINGY_VOLUME_SPRINGY
 
 #include <boost/asio.hpp>
 
+#include <map>
+
 #include "ivolume.hpp"
+#include "blockcache.hpp"
 #include "../libc/ilibc.hpp"
 #include "../util/uri.hpp"
 #include "../util/json.hpp"
@@ -18,18 +21,38 @@ namespace Springy{
                 size_t maxBodySize;
                 boost::asio::io_service io_service;
 
+                // identity and validator of remotely opened files, used to address the block cache
+                struct FileIdentity{
+                    dev_t dev;
+                    ino_t ino;
+                    ::Springy::Volume::BlockCache::Validator validator;
+                    int refs;
+                };
+                typedef std::pair<dev_t, ino_t> FileKey;
+                ::Springy::Volume::BlockCache *cache;
+                std::map<FileKey, FileIdentity> files;
+                std::map<int, FileKey> descriptors;
+
+                void trackDescriptor(boost::filesystem::path v_file_name, int fd);
+                void untrackDescriptor(int fd);
+                void invalidateDescriptor(int fd);
+                void invalidatePath(const boost::filesystem::path &v_file_name);
+                bool identityByDescriptor(int fd, FileIdentity &identity);
+                ssize_t readRemote(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset);
+
                 boost::asio::ip::tcp::socket createConnection(std::string host, int port);
                 nlohmann::json sendRequest(std::string path, nlohmann::json jparams, boost::asio::ip::tcp::socket *socket = NULL);
                 struct stat readStatFromJson(nlohmann::json j);
 
             public:
-                Springy(::Springy::LibC::ILibC *libc, ::Springy::Util::Uri u);
+                Springy(::Springy::LibC::ILibC *libc, ::Springy::Util::Uri u, ::Springy::Volume::BlockCache *cache=NULL);
                 virtual ~Springy();
 
                 boost::filesystem::path concatPath(const boost::filesystem::path &p1, const boost::filesystem::path &p2);
 
                 virtual std::string string();
                 virtual bool isLocal();
+                virtual boost::filesystem::path backingPath(const boost::filesystem::path &v_path);
 
                 virtual int getattr(boost::filesystem::path v_file_name, struct stat *buf);
 
@@ -50,12 +73,17 @@ namespace Springy{
 
                 virtual int open(boost::filesystem::path v_file_name, int flags, mode_t mode=0);
                 virtual int creat(boost::filesystem::path v_file_name, mode_t mode);
-                virtual int close(boost::filesystem::path v_file_name, int fd);
+                virtual int close(const boost::filesystem::path &v_file_name, int fd);
 
-                virtual ssize_t write(boost::filesystem::path v_file_name, int fd, const void *buf, size_t count, off_t offset);
-                virtual ssize_t read(boost::filesystem::path v_file_name, int fd, void *buf, size_t count, off_t offset);
+                virtual ssize_t write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset);
+                virtual ssize_t read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset);
 
-                virtual int truncate(boost::filesystem::path v_path, int fd, off_t length);
+                virtual int truncate(const boost::filesystem::path &v_path, int fd, off_t length);
+                virtual int fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length);
+                virtual ssize_t copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                                const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len);
+                virtual int fgetattr(const boost::filesystem::path &v_file_name, int fd, struct stat *buf);
+                virtual int descriptor(const boost::filesystem::path &v_file_name, int fd);
 
                 virtual int access(boost::filesystem::path v_path, int mode);
                 virtual int unlink(boost::filesystem::path v_path);
@@ -65,9 +93,10 @@ namespace Springy{
                 virtual int mkfifo(boost::filesystem::path v_path, mode_t mode);
                 virtual int mknod(boost::filesystem::path v_path, mode_t mode, dev_t dev);
 
-                virtual int fsync(boost::filesystem::path v_path, int fd);
+                virtual int flush(const boost::filesystem::path &v_path, int fd);
+                virtual int fsync(const boost::filesystem::path &v_path, int fd);
 
-                virtual int lock(boost::filesystem::path v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner);
+                virtual int lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner);
                 
                 virtual int setxattr(boost::filesystem::path v_path, const std::string attrname, const char *attrval, size_t attrvalsize, int flags);
                 virtual int getxattr(boost::filesystem::path v_path, const std::string attrname, char *buf, size_t count);
@@ -0,0 +1,288 @@
+#include "syncvolume.hpp"
+#include "../trace.hpp"
+
+namespace Springy{
+    namespace Volume{
+        SyncVolume::SyncVolume(IAsyncVolume *volume) : volume(volume){}
+        SyncVolume::~SyncVolume(){}
+
+        ssize_t SyncVolume::wait(std::future<IAsyncVolume::Completion> &future){
+            IAsyncVolume::Completion c = future.get();
+            if(c.result == -1){
+                errno = c.error;
+            }
+            return c.result;
+        }
+
+        std::string SyncVolume::string(){
+            return this->volume->string();
+        }
+        bool SyncVolume::isLocal(){
+            return this->volume->isLocal();
+        }
+        boost::filesystem::path SyncVolume::backingPath(const boost::filesystem::path &v_path){
+            return this->volume->backingPath(v_path);
+        }
+
+        int SyncVolume::getattr(boost::filesystem::path v_file_name, struct ::stat *buf){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->getattr(v_file_name, buf, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::statvfs(boost::filesystem::path v_path, struct ::statvfs *stat){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->statvfs(v_path, stat, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::chown(boost::filesystem::path v_file_name, uid_t owner, gid_t group){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->chown(v_file_name, owner, group, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::chmod(boost::filesystem::path v_file_name, mode_t mode){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->chmod(v_file_name, mode, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::mkdir(boost::filesystem::path v_file_name, mode_t mode){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->mkdir(v_file_name, mode, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::rmdir(boost::filesystem::path v_path){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->rmdir(v_path, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::rename(boost::filesystem::path v_old_name, boost::filesystem::path v_new_name){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->rename(v_old_name, v_new_name, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::utimensat(boost::filesystem::path v_path, const struct timespec times[2]){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->utimensat(v_path, times, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::readdir(boost::filesystem::path v_path, std::unordered_map<std::string, struct stat> &result){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->readdir(v_path, result, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        ssize_t SyncVolume::readlink(boost::filesystem::path v_path, char *buf, size_t bufsiz){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->readlink(v_path, buf, bufsiz, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::access(boost::filesystem::path v_path, int mode){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->access(v_path, mode, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::unlink(boost::filesystem::path v_path){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->unlink(v_path, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::link(boost::filesystem::path oldpath, const boost::filesystem::path newpath){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->link(oldpath, newpath, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::symlink(boost::filesystem::path oldpath, const boost::filesystem::path newpath){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->symlink(oldpath, newpath, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::mkfifo(boost::filesystem::path v_path, mode_t mode){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->mkfifo(v_path, mode, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::mknod(boost::filesystem::path v_path, mode_t mode, dev_t dev){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->mknod(v_path, mode, dev, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::open(boost::filesystem::path v_file_name, int flags, mode_t mode){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->open(v_file_name, flags, mode, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::creat(boost::filesystem::path v_file_name, mode_t mode){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->creat(v_file_name, mode, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::close(const boost::filesystem::path &v_file_name, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->close(v_file_name, fd, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        ssize_t SyncVolume::write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->write(v_file_name, fd, buf, count, offset, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        ssize_t SyncVolume::read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->read(v_file_name, fd, buf, count, offset, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::truncate(const boost::filesystem::path &v_path, int fd, off_t length){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->truncate(v_path, fd, length, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->fallocate(v_path, fd, mode, offset, length, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        ssize_t SyncVolume::copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                            const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->copy_file_range(v_in, fd_in, off_in, v_out, fd_out, off_out, len, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::fgetattr(const boost::filesystem::path &v_file_name, int fd, struct ::stat *buf){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->fgetattr(v_file_name, fd, buf, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::descriptor(const boost::filesystem::path &v_file_name, int fd){
+            return this->volume->descriptor(v_file_name, fd);
+        }
+
+        int SyncVolume::flush(const boost::filesystem::path &v_path, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->flush(v_path, fd, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::fsync(const boost::filesystem::path &v_path, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->fsync(v_path, fd, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->lock(v_path, fd, cmd, lck, lock_owner, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::setxattr(boost::filesystem::path v_path, const std::string attrname, const char *attrval, size_t attrvalsize, int flags){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->setxattr(v_path, attrname, attrval, attrvalsize, flags, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::getxattr(boost::filesystem::path v_path, const std::string attrname, char *buf, size_t count){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->getxattr(v_path, attrname, buf, count, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::listxattr(boost::filesystem::path v_path, char *buf, size_t count){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->listxattr(v_path, buf, count, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+
+        int SyncVolume::removexattr(boost::filesystem::path v_path, const std::string attrname){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            std::future<IAsyncVolume::Completion> future;
+            this->volume->removexattr(v_path, attrname, IAsyncVolume::promise(future));
+            return t.status(this->wait(future));
+        }
+    }
+}
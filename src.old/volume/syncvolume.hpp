@@ -0,0 +1,77 @@
+#ifndef SPRINGY_VOLUME_SYNCVOLUME
+#define SPRINGY_VOLUME_SYNCVOLUME
+
+#include "iasyncvolume.hpp"
+#include "ivolume.hpp"
+
+namespace Springy{
+    namespace Volume{
+        /**
+         * an asynchronous volume behind the synchronous interface, every call
+         * blocks until its handler ran. the volume has to complete operations
+         * requested from its own executor threads inline (AsyncVolume does),
+         * otherwise such a call waits for itself once all of them do.
+         *
+         * the volume is not owned
+         */
+        class SyncVolume : public IVolume{
+            protected:
+                IAsyncVolume *volume;
+
+                // result of the completed operation, errno set if it is -1
+                ssize_t wait(std::future<IAsyncVolume::Completion> &future);
+
+            public:
+                SyncVolume(IAsyncVolume *volume);
+                virtual ~SyncVolume();
+
+                IAsyncVolume* asynchronous(){ return this->volume; }
+
+                virtual std::string string();
+                virtual bool isLocal();
+                virtual boost::filesystem::path backingPath(const boost::filesystem::path &v_path);
+
+                virtual int getattr(boost::filesystem::path v_file_name, struct ::stat *buf);
+                virtual int statvfs(boost::filesystem::path v_path, struct ::statvfs *stat);
+                virtual int chown(boost::filesystem::path v_file_name, uid_t owner, gid_t group);
+                virtual int chmod(boost::filesystem::path v_file_name, mode_t mode);
+                virtual int mkdir(boost::filesystem::path v_file_name, mode_t mode);
+                virtual int rmdir(boost::filesystem::path v_path);
+                virtual int rename(boost::filesystem::path v_old_name, boost::filesystem::path v_new_name);
+                virtual int utimensat(boost::filesystem::path v_path, const struct timespec times[2]);
+
+                virtual int readdir(boost::filesystem::path v_path, std::unordered_map<std::string, struct stat> &result);
+                virtual ssize_t readlink(boost::filesystem::path v_path, char *buf, size_t bufsiz);
+                virtual int access(boost::filesystem::path v_path, int mode);
+                virtual int unlink(boost::filesystem::path v_path);
+                virtual int link(boost::filesystem::path oldpath, const boost::filesystem::path newpath);
+                virtual int symlink(boost::filesystem::path oldpath, const boost::filesystem::path newpath);
+                virtual int mkfifo(boost::filesystem::path v_path, mode_t mode);
+                virtual int mknod(boost::filesystem::path v_path, mode_t mode, dev_t dev);
+
+                virtual int open(boost::filesystem::path v_file_name, int flags, mode_t mode=0);
+                virtual int creat(boost::filesystem::path v_file_name, mode_t mode);
+                virtual int close(const boost::filesystem::path &v_file_name, int fd);
+                virtual ssize_t write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset);
+                virtual ssize_t read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset);
+                virtual int truncate(const boost::filesystem::path &v_path, int fd, off_t length);
+                virtual int fallocate(const boost::filesystem::path &v_path, int fd, int mode, off_t offset, off_t length);
+                virtual ssize_t copy_file_range(const boost::filesystem::path &v_in, int fd_in, off_t off_in,
+                                                const boost::filesystem::path &v_out, int fd_out, off_t off_out, size_t len);
+                virtual int fgetattr(const boost::filesystem::path &v_file_name, int fd, struct ::stat *buf);
+                virtual int descriptor(const boost::filesystem::path &v_file_name, int fd);
+
+                virtual int flush(const boost::filesystem::path &v_path, int fd);
+                virtual int fsync(const boost::filesystem::path &v_path, int fd);
+
+                virtual int lock(const boost::filesystem::path &v_path, int fd, int cmd, struct ::flock *lck, const uint64_t *lock_owner);
+
+                virtual int setxattr(boost::filesystem::path v_path, const std::string attrname, const char *attrval, size_t attrvalsize, int flags);
+                virtual int getxattr(boost::filesystem::path v_path, const std::string attrname, char *buf, size_t count);
+                virtual int listxattr(boost::filesystem::path v_path, char *buf, size_t count);
+                virtual int removexattr(boost::filesystem::path v_path, const std::string attrname);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,256 @@
+#include "uring.hpp"
+#include "ring.hpp"
+#include "../trace.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace Springy{
+    namespace Volume{
+        // the fields of struct stat which statx reports with STATX_BASIC_STATS
+        static void toStat(const struct statx &stx, struct stat *buf){
+            memset(buf, 0, sizeof(*buf));
+            buf->st_dev     = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+            buf->st_ino     = stx.stx_ino;
+            buf->st_mode    = stx.stx_mode;
+            buf->st_nlink   = stx.stx_nlink;
+            buf->st_uid     = stx.stx_uid;
+            buf->st_gid     = stx.stx_gid;
+            buf->st_rdev    = makedev(stx.stx_rdev_major, stx.stx_rdev_minor);
+            buf->st_size    = stx.stx_size;
+            buf->st_blksize = stx.stx_blksize;
+            buf->st_blocks  = stx.stx_blocks;
+            buf->st_atim.tv_sec  = stx.stx_atime.tv_sec;
+            buf->st_atim.tv_nsec = stx.stx_atime.tv_nsec;
+            buf->st_mtim.tv_sec  = stx.stx_mtime.tv_sec;
+            buf->st_mtim.tv_nsec = stx.stx_mtime.tv_nsec;
+            buf->st_ctim.tv_sec  = stx.stx_ctime.tv_sec;
+            buf->st_ctim.tv_nsec = stx.stx_ctime.tv_nsec;
+        }
+
+        static void prepareStatx(struct io_uring_sqe *sqe, const char *path, struct statx *stx){
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)path;
+            sqe->len = STATX_BASIC_STATS;
+            sqe->off = (uint64_t)(uintptr_t)stx;
+            sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+        }
+
+        // cqe res to the -1/errno of the syscall
+        static int done(int res){
+            if(res < 0){
+                errno = -res;
+                return -1;
+            }
+            return res;
+        }
+
+        Uring::Uring(Springy::LibC::ILibC *libc, Springy::Util::Uri u) : File(libc, u){}
+        Uring::~Uring(){}
+
+        int Uring::getattr(boost::filesystem::path v_file_name, struct stat *buf){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            Ring *ring = Ring::current(this->libc);
+            if(ring == NULL){
+                return t.status(File::getattr(v_file_name, buf));
+            }
+
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
+            struct statx stx;
+            prepareStatx(ring->prepare(), p.c_str(), &stx);
+            int res = ring->run();
+            if(res == -ECANCELED){
+                return t.status(File::getattr(v_file_name, buf));
+            }
+            if(done(res) == -1){
+                return t.status(-1);
+            }
+            toStat(stx, buf);
+            return t.status(0);
+        }
+
+        int Uring::readdir(boost::filesystem::path v_path, std::unordered_map<std::string, struct stat> &result){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            Ring *ring = Ring::current(this->libc);
+            if(ring == NULL){
+                return t.status(File::readdir(v_path, result));
+            }
+
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_path);
+
+            struct dirent *de;
+            DIR * dh = this->libc->opendir(__LINE__, p.c_str());
+            if (!dh){
+                return t.status(errno);
+            }
+
+            std::vector<std::string> names;
+            while((de = this->libc->readdir(__LINE__, dh))) {
+                // find dups
+                if(result.find(de->d_name)!=result.end()){
+                    continue;
+                }
+                names.push_back(de->d_name);
+            }
+            this->libc->closedir(__LINE__, dh);
+
+            // one statx per entry, a ring full of them at a time
+            std::vector<std::string> paths(Ring::entries);
+            std::vector<struct statx> stx(Ring::entries);
+            for(size_t first=0;first<names.size();first+=Ring::entries){
+                size_t count = std::min(names.size() - first, (size_t)Ring::entries);
+                int res = -ECANCELED;
+                if(ring != NULL){
+                    for(size_t i=0;i<count;i++){
+                        paths[i] = (p / names[first+i]).string();
+                        prepareStatx(ring->prepare(), paths[i].c_str(), &stx[i]);
+                    }
+                    res = ring->submit();
+                }
+                for(size_t i=0;i<count;i++){
+                    struct ::stat st;
+                    if(res < 0){
+                        // the ring is gone, the rest is stat'ed one by one
+                        if(File::getattr(v_path / names[first+i], &st) != 0){
+                            memset(&st, 0, sizeof(st));
+                        }
+                    }
+                    else if(ring->result(i) < 0){
+                        memset(&st, 0, sizeof(st));
+                    }
+                    else{
+                        toStat(stx[i], &st);
+                    }
+                    result.insert(std::make_pair(names[first+i], st));
+                }
+                if(res < 0){
+                    ring = NULL;
+                }
+            }
+
+            return t.status(0);
+        }
+
+        int Uring::open(boost::filesystem::path v_file_name, int flags, mode_t mode){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->readonly && (flags&O_RDONLY) != O_RDONLY){ errno = EROFS; return t.status(-1); }
+
+            Ring *ring = Ring::current(this->libc);
+            if(ring == NULL){
+                return t.status(File::open(v_file_name, flags, mode));
+            }
+
+            boost::filesystem::path p = this->concatPath(this->u.path(), v_file_name);
+            struct io_uring_sqe *sqe = ring->prepare();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)p.c_str();
+            sqe->len = mode;
+            sqe->open_flags = flags;
+            int res = ring->run();
+            if(res == -ECANCELED){
+                return t.status(File::open(v_file_name, flags, mode));
+            }
+            return t.status(done(res));
+        }
+        int Uring::creat(boost::filesystem::path v_file_name, mode_t mode){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
+
+            return t.status(this->open(v_file_name, O_CREAT|O_WRONLY|O_TRUNC, mode));
+        }
+        int Uring::close(const boost::filesystem::path &v_file_name, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            // the number may be handed out again right after the close
+            Ring::forget(fd);
+
+            Ring *ring = Ring::current(this->libc);
+            if(ring == NULL){
+                return t.status(File::close(v_file_name, fd));
+            }
+
+            struct io_uring_sqe *sqe = ring->prepare();
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = fd;
+            int res = ring->run();
+            if(res == -ECANCELED){
+                return t.status(File::close(v_file_name, fd));
+            }
+            return t.status(done(res));
+        }
+
+        ssize_t Uring::write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            Ring *ring = Ring::current(this->libc);
+            if(ring == NULL){
+                return t.status(File::write(v_file_name, fd, buf, count, offset));
+            }
+
+            struct io_uring_sqe *sqe = ring->prepare();
+            sqe->opcode = IORING_OP_WRITE;
+            ring->file(sqe, fd, true);
+            sqe->addr = (uint64_t)(uintptr_t)buf;
+            sqe->len = count;
+            sqe->off = offset;
+            int res = ring->run();
+            if(res == -ECANCELED){
+                return t.status(File::write(v_file_name, fd, buf, count, offset));
+            }
+            return t.status(done(res));
+        }
+        ssize_t Uring::read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            Ring *ring = Ring::current(this->libc);
+            if(ring == NULL){
+                return t.status(File::read(v_file_name, fd, buf, count, offset));
+            }
+
+            struct io_uring_sqe *sqe = ring->prepare();
+            sqe->opcode = IORING_OP_READ;
+            ring->file(sqe, fd, true);
+            sqe->addr = (uint64_t)(uintptr_t)buf;
+            sqe->len = count;
+            sqe->off = offset;
+            int res = ring->run();
+            if(res == -ECANCELED){
+                return t.status(File::read(v_file_name, fd, buf, count, offset));
+            }
+            return t.status(done(res));
+        }
+
+        int Uring::fsync(const boost::filesystem::path &v_path, int fd){
+            Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            if(this->readonly){ errno = EROFS; return t.status(-1); }
+
+            Ring *ring = Ring::current(this->libc);
+            if(ring == NULL){
+                return t.status(File::fsync(v_path, fd));
+            }
+
+            struct io_uring_sqe *sqe = ring->prepare();
+            sqe->opcode = IORING_OP_FSYNC;
+            ring->file(sqe, fd);
+            int res = ring->run();
+            if(res == -ECANCELED){
+                return t.status(File::fsync(v_path, fd));
+            }
+            return t.status(done(res));
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef SPRINGY_VOLUME_URING
+#define SPRINGY_VOLUME_URING
+
+#include "file.hpp"
+
+namespace Springy{
+    namespace Volume{
+        /**
+         * a local directory served through the io_uring of the calling thread
+         * (uring:// uris, --io-uring)
+         *
+         * lookups, opens, reads, writes, syncs and closes are io_uring requests,
+         * the entries of a directory are stat'ed by one batch of statx requests.
+         * everything else, and everything on kernels without io_uring, is done
+         * by File
+         */
+        class Uring : public File{
+            public:
+                Uring(Springy::LibC::ILibC *libc, Springy::Util::Uri u);
+                virtual ~Uring();
+
+                virtual int getattr(boost::filesystem::path v_file_name, struct stat *buf);
+                virtual int readdir(boost::filesystem::path v_path, std::unordered_map<std::string, struct stat> &result);
+
+                virtual int open(boost::filesystem::path v_file_name, int flags, mode_t mode=0);
+                virtual int creat(boost::filesystem::path v_file_name, mode_t mode);
+                virtual int close(const boost::filesystem::path &v_file_name, int fd);
+
+                virtual ssize_t write(const boost::filesystem::path &v_file_name, int fd, const void *buf, size_t count, off_t offset);
+                virtual ssize_t read(const boost::filesystem::path &v_file_name, int fd, void *buf, size_t count, off_t offset);
+
+                virtual int fsync(const boost::filesystem::path &v_path, int fd);
+        };
+    }
+}
+
+#endif
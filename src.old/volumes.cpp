@@ -3,12 +3,15 @@
 #include "exception.hpp"
 
 #include "volume/file.hpp"
+#include "volume/uring.hpp"
+#include "volume/springy.hpp"
 
 #include <cstdint>
+#include <errno.h>
 
 namespace Springy{
 
-Volumes::Volumes(Springy::LibC::ILibC *libc){ this->libc = libc; }
+Volumes::Volumes(Springy::LibC::ILibC *libc) : changes(0){ this->libc = libc; }
 Volumes::~Volumes(){}
 
 std::vector<Springy::Volumes::VolumeConfig>* Volumes::getTreePropertyByPath(boost::filesystem::path p){
@@ -17,10 +20,10 @@ std::vector<Springy::Volumes::VolumeConfig>* Volumes::getTreePropertyByPath(boos
     std::string treePath = p.string();
     std::uintptr_t ui;
     if(treePath == "/"){
-        ui = this->volumesTree.get_value(0);
+        ui = this->volumesTree.get_value<std::uintptr_t>(0);
     }
     else{
-        ui = this->volumesTree.get(boost::property_tree::ptree::path_type(treePath, '/'), 0);
+        ui = this->volumesTree.get<std::uintptr_t>(boost::property_tree::ptree::path_type(treePath, '/'), 0);
     }
     if(ui != 0){
         vols = reinterpret_cast<std::vector<Springy::Volumes::VolumeConfig> *>(ui);
@@ -41,11 +44,12 @@ void Volumes::putTreePropertyByPath(boost::filesystem::path p, std::vector<Sprin
 
 void Volumes::addVolume(Springy::Util::Uri u, boost::filesystem::path virtualMountPoint){
     std::string protocol = u.protocol();
-    if(protocol != "file" && protocol != "springy"){
+    // springy:// stays off until Httpd serves the /api/volume/* requests Volume::Springy sends
+    if(protocol != "file" && protocol != "uring"){
         throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__, "unkown uri protocol") << u.protocol();
     }
 
-    Synchronized syncToken(this->volumes);
+    Synchronized syncToken(this);
 
     std::string stru = u.string();
 
@@ -65,11 +69,15 @@ void Volumes::addVolume(Springy::Util::Uri u, boost::filesystem::path virtualMou
     if(protocol == "file"){
         volume = new Springy::Volume::File(this->libc, u);
     }
+    else if(protocol == "uring"){
+        volume = new Springy::Volume::Uring(this->libc, u);
+    }
     //else if(protocol == "springy"){
-    //    volume = new Springy::Volume::Springy(this->libc, u);
+    //    volume = new Springy::Volume::Springy(this->libc, u, &this->blockCache);
     //}
 
     it->second.push_back(volume);
+    this->changes++;
 
     VolumeConfig vcfg = {virtualMountPoint, volume};
 
@@ -81,7 +89,7 @@ void Volumes::addVolume(Springy::Util::Uri u, boost::filesystem::path virtualMou
     this->putTreePropertyByPath(virtualMountPoint, vols);
 }
 void Volumes::removeVolume(Springy::Util::Uri u, boost::filesystem::path virtualMountPoint){
-    Synchronized syncToken(this->volumes);
+    Synchronized syncToken(this);
 
     std::string volMount = u.string();
 
@@ -111,6 +119,8 @@ void Volumes::removeVolume(Springy::Util::Uri u, boost::filesystem::path virtual
                 this->putTreePropertyByPath(virtualMountPoint, vols);
             }
             
+            this->changes++;
+
             // delete IVolume*
             delete *vit;
             // and erase regarding entry
@@ -124,12 +134,12 @@ void Volumes::removeVolume(Springy::Util::Uri u, boost::filesystem::path virtual
     }
 }
 
-Springy::Volumes::VolumeRelativeFile Volumes::getVolumesByVirtualFileName(const boost::filesystem::path file_name){
+int Volumes::getVolumesByVirtualFileName(const boost::filesystem::path &file_name, Springy::Volumes::VolumeRelativeFile &result){
     Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-	Synchronized syncToken(this->volumes, Synchronized::LockType::READ);
+	Synchronized syncToken(this, Synchronized::LockType::READ);
 
-    Springy::Volumes::VolumeRelativeFile result;
+    result = Springy::Volumes::VolumeRelativeFile();
 
     std::vector<VolumeConfig> *vols = this->getTreePropertyByPath(boost::filesystem::path());
     if(vols!=NULL){
@@ -145,44 +155,45 @@ Springy::Volumes::VolumeRelativeFile Volumes::getVolumesByVirtualFileName(const
     boost::filesystem::path virtualMountPoint;
     boost::filesystem::path::const_iterator pit;
     for(pit=file_name.begin();pit!=file_name.end();pit++){
-        boost::filesystem::path tmp = virtualMountPoint;
-
-        tmp /= *pit;
+        virtualMountPoint /= *pit;
 
         std::vector<VolumeConfig> *tvols = NULL;
-        tvols = this->getTreePropertyByPath(tmp);
+        tvols = this->getTreePropertyByPath(virtualMountPoint);
         if(tvols != NULL && tvols->size() > 0){
             result = Springy::Volumes::VolumeRelativeFile();
+            // the rest of the path below the mount point, rooted in the volume
+            result.volumeRelativeFileName = "/";
+            boost::filesystem::path::const_iterator pit2 = pit;
+            for(pit2++;pit2!=file_name.end();pit2++){
+                result.volumeRelativeFileName /= *pit2;
+            }
             for(size_t i=0;i<tvols->size();i++){
                 if(result.virtualMountPoint.empty()){
                     result.virtualMountPoint = (*tvols)[i].virtualMountPoint;
                 }
-                boost::filesystem::path::const_iterator pit2;
-                for(pit2=pit;pit2!=file_name.end();pit2++){
-                    result.volumeRelativeFileName /= *pit2;
-                }
                 result.volumes.insert((*tvols)[i].volume);
             }
         }
     }
     
     if(result.volumes.size() <= 0){
-        throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "no matching volumes found";
+        return -ENOENT;
     }
 
-    return result;
+    return 0;
 }
 
 Springy::Volumes::VolumesMap Volumes::getVolumes(){
     Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
 
-    Synchronized syncToken(this->volumes, Synchronized::LockType::READ);
+    Synchronized syncToken(this, Synchronized::LockType::READ);
     
     return this->volumes;
 }
 
 boost::filesystem::path Springy::Volumes::convertFuseFilenameToVolumeRelativeFilename(Springy::Volume::IVolume *volume, const boost::filesystem::path fuseFileName){
-    Springy::Volumes::VolumeRelativeFile rel = Volumes::getVolumesByVirtualFileName(fuseFileName);
+    Springy::Volumes::VolumeRelativeFile rel;
+    Volumes::getVolumesByVirtualFileName(fuseFileName, rel);
     std::set<Springy::Volume::IVolume*>::iterator it;
     for(it=rel.volumes.begin();it!=rel.volumes.end();it++){
         if(*it == volume){
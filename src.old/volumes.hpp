@@ -3,14 +3,18 @@
 
 #include "util/uri.hpp"
 #include "volume/ivolume.hpp"
+#include "volume/blockcache.hpp"
 #include "libc/ilibc.hpp"
+#include "util/synchronized.hpp"
 
+#include <atomic>
 #include <map>
 #include <set>
 #include <boost/property_tree/ptree.hpp>
 
 namespace Springy{
-    class Volumes{
+    // consulted by every path based operation, so it carries its own lock
+    class Volumes : public Synchronizable{
         protected:
             struct VolumeConfig{
                 boost::filesystem::path virtualMountPoint;
@@ -19,6 +23,8 @@ namespace Springy{
 
             boost::property_tree::ptree volumesTree;
             Springy::LibC::ILibC *libc;
+
+            std::atomic<uint64_t> changes;
             
             std::vector<Springy::Volumes::VolumeConfig>* getTreePropertyByPath(boost::filesystem::path p);
             void putTreePropertyByPath(boost::filesystem::path p, std::vector<Springy::Volumes::VolumeConfig> *vols);
@@ -34,15 +40,22 @@ namespace Springy{
             typedef std::map<boost::filesystem::path, std::vector<Springy::Volume::IVolume*> > VolumesMap;
             VolumesMap volumes;
 
+            // shared by all remote volumes, sized by --cache-size
+            Springy::Volume::BlockCache blockCache;
+
             Volumes(Springy::LibC::ILibC *libc);
             ~Volumes();
 
             void addVolume(Springy::Util::Uri u, boost::filesystem::path virtualMountPoint=boost::filesystem::path("/"));
             void removeVolume(Springy::Util::Uri u, boost::filesystem::path virtualMountPoint=boost::filesystem::path("/"));
 
-            Springy::Volumes::VolumeRelativeFile getVolumesByVirtualFileName(const boost::filesystem::path file_name);
+            // 0 with the volumes file_name may be on, -ENOENT if it is outside every mount point
+            int getVolumesByVirtualFileName(const boost::filesystem::path &file_name, Springy::Volumes::VolumeRelativeFile &result);
             Springy::Volumes::VolumesMap getVolumes();
 
+            // increases whenever a volume is added or removed
+            uint64_t generation() const{ return this->changes.load(); }
+
             boost::filesystem::path convertFuseFilenameToVolumeRelativeFilename(Springy::Volume::IVolume *volume, const boost::filesystem::path fuseFileName);
     };
 }
@@ -0,0 +1,134 @@
+// lookups of missing files, the way a compiler searches its include path:
+// every header is probed in each -I directory until one has it. each
+// directory is a file:// volume of its own virtual mount point, so every
+// probe goes through FsOps::Fuse::getattr, findVolume and
+// Volumes::getVolumesByVirtualFileName.
+//
+// compares the errno results of FsOps::Fuse::getattr with the former
+// control flow, which reported a miss of findVolume by throwing
+// Springy::Exception and logging the trace in getattr.
+//
+// make bench && ./bench.lookup > /dev/null   (the trace dumps go to stdout)
+
+#include "fsops/fuse.hpp"
+#include "settings.hpp"
+#include "exception.hpp"
+#include "trace.hpp"
+
+#include "libc/libc.hpp"
+#include "util/uri.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+static const int includeDirs = 16;
+static const int headers = 200;
+static const int rounds = 20;
+
+class BenchFuse : public Springy::FsOps::Fuse{
+    public:
+        BenchFuse(Springy::Settings *config, Springy::LibC::ILibC *libc) : Springy::FsOps::Fuse(config, libc){}
+
+        // findVolume and getattr as they were before lookups returned -errno
+        Springy::FsOps::Abstract::VolumeInfo findVolumeThrowing(const boost::filesystem::path &file_name){
+            Springy::Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            Springy::FsOps::Abstract::VolumeInfo vinfo;
+            if(this->findVolume(file_name, vinfo) != 0){
+                throw Springy::Exception(__FILE__, __PRETTY_FUNCTION__, __LINE__) << "file not found";
+            }
+            return vinfo;
+        }
+        int getattrThrowing(MetaRequest meta, const boost::filesystem::path file_name, struct stat *buf){
+            Springy::Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+
+            try{
+                Springy::FsOps::Abstract::VolumeInfo vinfo = this->findVolumeThrowing(file_name);
+                *buf = vinfo.st;
+                return 0;
+            }catch(...){
+                t.log(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+            }
+            return -ENOENT;
+        }
+};
+
+static double run(BenchFuse &f, bool throwing, size_t &misses){
+    struct timespec start, end;
+    struct stat st;
+
+    Springy::FsOps::Abstract::MetaRequest meta;
+    meta.u = getuid();
+    meta.g = getgid();
+    meta.p = getpid();
+    meta.mask = 022;
+    meta.readonly = false;
+
+    misses = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int r=0;r<rounds;r++){
+        for(int h=0;h<headers;h++){
+            std::string name = "header" + std::to_string(h) + ".h";
+            // the headers live in the last directory, every other one is a miss
+            for(int d=0;d<includeDirs;d++){
+                boost::filesystem::path path = boost::filesystem::path("/include" + std::to_string(d)) / name;
+                int res = throwing ? f.getattrThrowing(meta, path, &st) : f.getattr(meta, path, &st);
+                if(res == 0){
+                    break;
+                }
+                misses++;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+int main(int argc, char **argv){
+    char tmpl[] = "/tmp/springy.bench.XXXXXX";
+    if(mkdtemp(tmpl) == NULL){
+        std::cerr << "mkdtemp failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    boost::filesystem::path root(tmpl);
+
+    Springy::LibC::LibC libc;
+    Springy::Settings s(&libc);
+
+    boost::filesystem::path last;
+    for(int d=0;d<includeDirs;d++){
+        last = root / ("include" + std::to_string(d));
+        boost::filesystem::create_directory(last);
+        s.volumes.addVolume(Springy::Util::Uri("file://" + last.string()), "/include" + std::to_string(d));
+    }
+    for(int h=0;h<headers;h++){
+        boost::filesystem::ofstream((last / ("header" + std::to_string(h) + ".h")));
+    }
+
+    BenchFuse f(&s, &libc);
+
+    size_t missesThrowing, misses;
+    double nsThrowing = run(f, true, missesThrowing);
+    double ns = run(f, false, misses);
+
+    boost::filesystem::remove_all(root);
+
+    std::cerr << "lookups of missing files: " << misses << std::endl;
+    std::cerr << "exception + trace log: " << nsThrowing / missesThrowing << " ns per miss" << std::endl;
+    std::cerr << "errno result:          " << ns / misses << " ns per miss" << std::endl;
+    std::cerr << "speedup:               " << nsThrowing / ns << "x" << std::endl;
+
+    return 0;
+}
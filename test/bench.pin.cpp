@@ -0,0 +1,150 @@
+// what --pin-workers gains on springy's side of a request: one worker per
+// allowed cpu serves 4KiB reads of a cached file through FsOps::Fuse::read,
+// once free to migrate and once pinned by FuseLowlevel::pin() the way the
+// workers of a mounted --pin-workers instance are. the /dev/fuse transport
+// is left out, it is the same either way.
+//
+// make bench && ./bench.pin > /dev/null   (the trace dumps go to stdout)
+
+#include "fuselowlevel.hpp"
+#include "settings.hpp"
+
+#include "libc/libc.hpp"
+#include "util/uri.hpp"
+
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+static const size_t fileSize = 64 * 1024 * 1024;
+static const size_t blockSize = 4096;
+static const int seconds = 2;
+static const int rounds = 3;
+
+class BenchLowlevel : public Springy::FuseLowlevel{
+    public:
+        using Springy::FuseLowlevel::allowedCpus;
+        using Springy::FuseLowlevel::pin;
+        using Springy::FuseLowlevel::cpus;
+        using Springy::FuseLowlevel::operations;
+};
+
+struct Result{
+    double opsPerSecond;
+    long migrations;    // involuntary context switches, each one may move the worker
+};
+
+static Result run(BenchLowlevel &b, bool pinned){
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> ops(0);
+    std::atomic<long> switches(0);
+
+    std::vector<std::thread> workers;
+    for(size_t w=0;w<b.cpus.size();w++){
+        workers.push_back(std::thread([&, w](){
+            if(pinned){
+                b.pin();
+            }
+
+            Springy::FsOps::Abstract::MetaRequest meta;
+            meta.u = getuid();
+            meta.g = getgid();
+            meta.p = getpid();
+            meta.mask = 022;
+            meta.readonly = false;
+
+            struct fuse_file_info fi;
+            memset(&fi, 0, sizeof(fi));
+            fi.flags = O_RDONLY;
+            if(b.operations->open(meta, "/f", &fi) != 0){
+                std::cerr << "open failed" << std::endl;
+                return;
+            }
+
+            char buf[blockSize];
+            uint64_t n = 0;
+            unsigned int seed = w;
+            while(!stop.load(std::memory_order_relaxed)){
+                off_t offset = (off_t)(rand_r(&seed) % (fileSize / blockSize)) * blockSize;
+                b.operations->read(meta, "/f", buf, blockSize, offset, &fi);
+                n++;
+            }
+            b.operations->release(meta, "/f", &fi);
+
+            struct rusage ru;
+            getrusage(RUSAGE_THREAD, &ru);
+            switches += ru.ru_nivcsw;
+            ops += n;
+        }));
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for(size_t i=0;i<workers.size();i++){
+        workers[i].join();
+    }
+
+    Result r;
+    r.opsPerSecond = (double)ops / seconds;
+    r.migrations = switches;
+    return r;
+}
+
+int main(int argc, char **argv){
+    char tmpl[] = "/tmp/springy.bench.XXXXXX";
+    if(mkdtemp(tmpl) == NULL){
+        std::cerr << "mkdtemp failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    boost::filesystem::path root(tmpl);
+    {
+        boost::filesystem::ofstream f(root / "f", std::ios::binary);
+        std::string block(blockSize, 'x');
+        for(size_t i=0;i<fileSize/blockSize;i++){
+            f << block;
+        }
+    }
+
+    Springy::LibC::LibC libc;
+    Springy::Settings s(&libc);
+    s.volumes.addVolume(Springy::Util::Uri("file://" + root.string()), "/");
+
+    BenchLowlevel b;
+    b.init(&s, &libc);
+    if(!b.allowedCpus()){
+        std::cerr << "no cpus to pin to" << std::endl;
+        return 1;
+    }
+
+    Result best[2] = {{0, 0}, {0, 0}};
+    for(int r=0;r<rounds;r++){
+        for(int pinned=0;pinned<2;pinned++){
+            Result res = run(b, pinned != 0);
+            if(res.opsPerSecond > best[pinned].opsPerSecond){
+                best[pinned] = res;
+            }
+        }
+    }
+
+    boost::filesystem::remove_all(root);
+
+    std::cerr << "workers (allowed cpus): " << b.cpus.size() << std::endl;
+    std::cerr << "free to migrate: " << best[0].opsPerSecond << " reads/s, " << best[0].migrations << " involuntary switches" << std::endl;
+    std::cerr << "pinned:          " << best[1].opsPerSecond << " reads/s, " << best[1].migrations << " involuntary switches" << std::endl;
+    std::cerr << "speedup:         " << best[1].opsPerSecond / best[0].opsPerSecond << "x" << std::endl;
+
+    return 0;
+}
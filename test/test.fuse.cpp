@@ -1,13 +1,14 @@
-#include "../src/fuse.hpp"
-#include "../src/settings.hpp"
+#include "fsops/fuse.hpp"
+#include "settings.hpp"
 
-#include "../src/libc/libc.hpp"
-#include "../src/util/uri.hpp"
+#include "libc/libc.hpp"
+#include "util/uri.hpp"
 
 #include <set>
 #include <unistd.h>
 #include <linux/limits.h>
 #include <string.h>
+#include <sys/xattr.h>
 
 #include <boost/filesystem.hpp>
 
@@ -31,14 +32,15 @@ class TestMoveFileLibC : public Springy::LibC::LibC{
 char cwd[PATH_MAX];
 std::unordered_map<std::string, struct stat> fillerMap;
 TestMoveFileLibC *libc = new TestMoveFileLibC();
+Springy::FsOps::Abstract::MetaRequest meta;
 
-void test_getattr(Springy::Fuse &f){
+void test_getattr(Springy::FsOps::Fuse &f){
     struct stat buf1, buf2;
 
     {
         std::string pathb = std::string(cwd)+"/dir1/b";
         ::stat(pathb.c_str(), &buf1);
-        int rval = f.op_getattr("b", &buf2);
+        int rval = f.getattr(meta, "/b", &buf2);
         ASSERT(rval==0);
         ASSERT(::memcmp(&buf1,&buf2,sizeof(buf1))==0);
     }
@@ -48,18 +50,18 @@ void test_getattr(Springy::Fuse &f){
         ::stat(pathb.c_str(), &buf1);
         int tmperrno = errno;
 
-        int rval = f.op_getattr("noexist", &buf2);
+        int rval = f.getattr(meta, "/noexist", &buf2);
         ASSERT(-rval == tmperrno);
     }
 }
 
-void test_statfs(Springy::Fuse &f){
+void test_statfs(Springy::FsOps::Fuse &f){
     struct statvfs vfsassert, vfstest;
 
     {
         std::string pathb = std::string(cwd)+"/dir1/b";
         ::statvfs(pathb.c_str(), &vfsassert);
-        int rval = f.op_statfs("b", &vfstest);
+        int rval = f.statfs(meta, "/b", &vfstest);
         ASSERT(rval==0);
         ASSERT(::memcmp(&vfsassert,&vfstest,sizeof(vfsassert))==0);
     }
@@ -69,24 +71,19 @@ void test_statfs(Springy::Fuse &f){
         errno = 0;
         ::statvfs(pathb.c_str(), &vfsassert);
         int tmperrno = errno;
-        int rval = f.op_statfs("noexist", &vfstest);
+        int rval = f.statfs(meta, "/noexist", &vfstest);
         ASSERT(-rval == tmperrno);
     }
 }
 
-int test_fuse_filler_dir_t(void *buf, const char *name, const struct stat *stbuf, off_t off){
-    fillerMap.insert(std::make_pair(std::string(name), *stbuf));
-    return 0;
-}
-
-void test_readdir(Springy::Fuse &f){
+void test_readdir(Springy::FsOps::Fuse &f){
     {
         std::string basepath(cwd);
 
         struct stat buf;
 
         fillerMap.clear();
-        int rval = f.op_readdir("/", NULL, test_fuse_filler_dir_t, 0, NULL);
+        int rval = f.readdir(meta, "/", fillerMap);
 
         ASSERT(rval == 0);
         ASSERT(fillerMap.size() >= 5);
@@ -108,75 +105,75 @@ void test_readdir(Springy::Fuse &f){
         fillerMap.clear();
 
         int rval = 0;
-        rval = f.op_readdir("/noexist", NULL, test_fuse_filler_dir_t, 0, NULL);
+        rval = f.readdir(meta, "/noexist", fillerMap);
         ASSERT(-rval == ENOENT);
-        rval = f.op_readdir("/b", NULL, test_fuse_filler_dir_t, 0, NULL);
+        rval = f.readdir(meta, "/b", fillerMap);
         ASSERT(-rval == ENOTDIR);
     }
 }
 
-void test_readlink(Springy::Fuse &f){
+void test_readlink(Springy::FsOps::Fuse &f){
     {
         char result[8192];
 
-        int rval = f.op_readlink("/c/testlink", result, sizeof(result));
+        int rval = f.readlink(meta, "/c/testlink", result, sizeof(result));
         ASSERT(rval==0);
         ASSERT(std::string(result)=="../../test.fuse");
     }
     {
         char result[8192];
 
-        int rval = f.op_readlink("/c/testlink", result, sizeof(result));
+        int rval = f.readlink(meta, "/c/testlink", result, sizeof(result));
         ASSERT(rval==0);
         ASSERT(std::string(result)=="../../test.fuse");
     }
 }
 
 
-void test_access(Springy::Fuse &f){
+void test_access(Springy::FsOps::Fuse &f){
     {
-        int rval = f.op_access("/c/testlink", R_OK|W_OK);
+        int rval = f.access(meta, "/c/testlink", R_OK|W_OK);
         ASSERT(rval==0);
     }
     {
-        int rval = f.op_access("/noexist", R_OK|W_OK);
+        int rval = f.access(meta, "/noexist", R_OK|W_OK);
         ASSERT(rval==-ENOENT);
-        rval = f.op_access("/b", R_OK|W_OK|X_OK);
+        rval = f.access(meta, "/b", R_OK|W_OK|X_OK);
         ASSERT(rval==-EACCES);
     }
 }
 
-void test_mkdir_rmdir(Springy::Fuse &f){
+void test_mkdir_rmdir(Springy::FsOps::Fuse &f){
     ::rmdir((std::string(cwd)+"/dir1/a/test").c_str());
     {
-        int rval = f.op_mkdir("/a/test", 0666);
+        int rval = f.mkdir(meta, "/a/test", 0666);
         ASSERT(rval==0);
     }
     {
-        int rval = f.op_rmdir("/a/test");
+        int rval = f.rmdir(meta, "/a/test");
         ASSERT(rval==0);
-        rval = f.op_rmdir("/noexist");
+        rval = f.rmdir(meta, "/noexist");
         ASSERT(rval==-ENOENT);
     }
 }
 
-void test_unlink(Springy::Fuse &f){
+void test_unlink(Springy::FsOps::Fuse &f){
     FILE *fp = fopen((std::string(cwd)+"/dir1/a/testfile").c_str(), "w+");
     if(fp){
         fclose(fp);
     }
 
     {
-        int rval = f.op_unlink("/a/testfile");
+        int rval = f.unlink(meta, "/a/testfile");
         ASSERT(rval==0);
     }
     {
-        int rval = f.op_unlink("/noexist");
+        int rval = f.unlink(meta, "/noexist");
         ASSERT(rval==-ENOENT);
     }
 }
 
-void test_truncate(Springy::Fuse &f){
+void test_truncate(Springy::FsOps::Fuse &f){
     std::string abspath = std::string(cwd)+"/dir1/a/testfile";
     unlink(abspath.c_str());
     FILE *fp = fopen(abspath.c_str(), "w+");
@@ -186,7 +183,7 @@ void test_truncate(Springy::Fuse &f){
     }
 
     {
-        int rval = f.op_truncate("/a/testfile", 1);
+        int rval = f.truncate(meta, "/a/testfile", 1);
         ASSERT(rval == 0);
         struct stat buf;
         ASSERT(stat(abspath.c_str(), &buf) == 0);
@@ -194,7 +191,7 @@ void test_truncate(Springy::Fuse &f){
     }
 }
 
-void test_rename(Springy::Fuse &f){
+void test_rename(Springy::FsOps::Fuse &f){
     std::string abspath = std::string(cwd)+"/dir1/a/testfile2";
     unlink(abspath.c_str());
     FILE *fp = fopen(abspath.c_str(), "w+");
@@ -204,14 +201,14 @@ void test_rename(Springy::Fuse &f){
     }
 
     {
-        int rval = f.op_rename("/a/testfile2", "/a/testfile3");
+        int rval = f.rename(meta, "/a/testfile2", "/a/testfile3");
         ASSERT(rval == 0);
         struct stat buf;
         ASSERT(stat((std::string(cwd)+"/dir1/a/testfile3").c_str(), &buf) == 0);
     }
 }
 
-void test_utimens(Springy::Fuse &f){
+void test_utimens(Springy::FsOps::Fuse &f){
     std::string abspath = std::string(cwd)+"/dir1/b";
     struct timespec tsOrig, ts[2];
 
@@ -220,7 +217,7 @@ void test_utimens(Springy::Fuse &f){
     ts[1] = tsOrig;
 
     {
-        int rval = f.op_utimens("/b", ts);
+        int rval = f.utimens(meta, "/b", ts);
         ASSERT(rval == 0);
         struct stat st;
         stat(abspath.c_str(), &st);
@@ -229,7 +226,7 @@ void test_utimens(Springy::Fuse &f){
     }
 }
 
-void test_chmod(Springy::Fuse &f){
+void test_chmod(Springy::FsOps::Fuse &f){
     std::string abspath = std::string(cwd)+"/dir1/b";
     FILE *fp = fopen(abspath.c_str(), "a+");
     if(fp){ fclose(fp); }
@@ -240,7 +237,7 @@ void test_chmod(Springy::Fuse &f){
     umask(mask);
 
     {
-        int rval = f.op_chmod("/b", m);
+        int rval = f.chmod(meta, "/b", m);
         ASSERT(rval == 0);
         struct stat st;
         stat(abspath.c_str(), &st);
@@ -248,58 +245,58 @@ void test_chmod(Springy::Fuse &f){
     }
 }
 
-void test_chown(Springy::Fuse &f){
+void test_chown(Springy::FsOps::Fuse &f){
     std::string abspath = std::string(cwd)+"/dir1/b";
 
     struct stat st;
     stat(abspath.c_str(), &st);
 
     {
-        int rval = f.op_chown("/b", st.st_uid, st.st_gid);  // dont change anything
+        int rval = f.chown(meta, "/b", st.st_uid, st.st_gid);  // dont change anything
         ASSERT(rval == 0);
     }
 }
 
-void test_symlink(Springy::Fuse &f){
+void test_symlink(Springy::FsOps::Fuse &f){
     std::string linkpath = std::string(cwd)+"/dir1/slink";
 
     unlink(linkpath.c_str());
 
     {
-        int rval = f.op_symlink("/b", "/slink");
+        int rval = f.symlink(meta, "/b", "/slink");
         ASSERT(rval == 0);
         struct stat st;
         ASSERT(lstat(linkpath.c_str(), &st) == 0);
     }
 }
 
-void test_link(Springy::Fuse &f){
+void test_link(Springy::FsOps::Fuse &f){
     std::string linkpath = std::string(cwd)+"/dir1/hlink";
     unlink(linkpath.c_str());
 
     {
-        int rval = f.op_link("b", "/hlink");
+        int rval = f.link(meta, "/b", "/hlink");
         ASSERT(rval == 0);
         struct stat st;
         ASSERT(lstat(linkpath.c_str(), &st) == 0);
     }
 }
 
-void test_mknod(Springy::Fuse &f){
+void test_mknod(Springy::FsOps::Fuse &f){
     std::string nodpath = std::string(cwd)+"/dir1/nod";
     unlink(nodpath.c_str());
 
     {
         mode_t m = S_IRUSR|S_IRGRP|S_IROTH|S_IWUSR|S_IWGRP|S_IWOTH;
 
-        int rval = f.op_mknod("/nod", m, S_IFIFO);
+        int rval = f.mknod(meta, "/nod", m, S_IFIFO);
         ASSERT(rval == 0);
         struct stat st;
         ASSERT(stat(nodpath.c_str(), &st) == 0);
     }
 }
 
-void test_xattr(Springy::Fuse &f){
+void test_xattr(Springy::FsOps::Fuse &f){
     std::string xattrpath = std::string(cwd)+"/dir1/xattr";
     unlink(xattrpath.c_str());
 
@@ -307,26 +304,26 @@ void test_xattr(Springy::Fuse &f){
     fclose(fp);
 
     {
-        int rval = f.op_setxattr("/xattr", "user.test", "test", 4, XATTR_CREATE);
+        int rval = f.setxattr(meta, "/xattr", "user.test", "test", 4, XATTR_CREATE);
         ASSERT(rval == 0);
         char buffer[128];
-        rval = f.op_getxattr("/xattr", "user.test", buffer, sizeof(buffer));
+        rval = f.getxattr(meta, "/xattr", "user.test", buffer, sizeof(buffer));
         ASSERT(rval == 4);
         ASSERT( std::string(buffer) == std::string("test") );
         
         memset(buffer, '\0', sizeof(buffer));
 
-        rval = f.op_listxattr("/xattr", buffer, sizeof(buffer));
+        rval = f.listxattr(meta, "/xattr", buffer, sizeof(buffer));
         ASSERT( std::string(buffer) == std::string("user.test") );
         ASSERT(rval == 10);
-        rval = f.op_removexattr("/xattr", "user.test");
+        rval = f.removexattr(meta, "/xattr", "user.test");
         ASSERT(rval == 0);
-        rval = f.op_listxattr("/xattr", buffer, sizeof(buffer));
+        rval = f.listxattr(meta, "/xattr", buffer, sizeof(buffer));
         ASSERT(rval == 0);
     }
 }
 
-void test_fops(Springy::Fuse &f){
+void test_fops(Springy::FsOps::Fuse &f){
     //test_create(const std::string file, mode_t mode, struct fuse_file_info *fi);
     //test_open(const std::string file, struct fuse_file_info *fi);
     //test_release(const std::string path, struct fuse_file_info *fi);
@@ -340,46 +337,49 @@ void test_fops(Springy::Fuse &f){
     unlink(fopspath.c_str());
 
     struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
 
     {
         int rval = 0;
-        rval = f.op_create("/fops", S_IRUSR|S_IRGRP|S_IROTH|S_IWUSR|S_IWGRP|S_IWOTH, &fi);
+        fi.flags = O_RDWR | O_CREAT;
+        rval = f.create(meta, "/fops", S_IRUSR|S_IRGRP|S_IROTH|S_IWUSR|S_IWGRP|S_IWOTH, &fi);
         ASSERT(rval == 0);
-        rval = f.op_release("/fops", &fi);
+        rval = f.release(meta, "/fops", &fi);
         ASSERT(rval == 0);
         fi.fh    = 0;
         fi.flags = O_RDWR | O_APPEND;
-        rval = f.op_open("/fops", &fi);
+        rval = f.open(meta, "/fops", &fi);
         ASSERT(rval == 0);
 
         char buffer[128] = {'\0'};
         snprintf(buffer, sizeof(buffer)-1, "test");
-        rval = f.op_write("/fops", buffer, 4, 0, &fi);
+        rval = f.write(meta, "/fops", buffer, 4, 0, &fi);
 
         ASSERT(rval == 4);
-        rval = f.op_fsync("/fops", 1, &fi);
+        rval = f.fsync(meta, "/fops", 1, &fi);
         ASSERT(rval == 0);
         memset(buffer, '\0', sizeof(buffer));
-        rval = f.op_read("/fops", buffer, sizeof(buffer), 0, &fi);
+        rval = f.read(meta, "/fops", buffer, sizeof(buffer), 0, &fi);
         ASSERT(rval == 4);
         ASSERT(memcmp(buffer, "test", 4) == 0);
-        rval = f.op_ftruncate("/fops", 0, &fi);
+        rval = f.ftruncate(meta, "/fops", 0, &fi);
         ASSERT(rval == 0);
         struct stat st;
         stat(fopspath.c_str(), &st);
         ASSERT(st.st_size == 0);
-        rval = f.op_release("/fops", &fi);
+        rval = f.release(meta, "/fops", &fi);
         ASSERT(rval == 0);
     }
 }
 
-void test_moveFile(Springy::Fuse &f){
+void test_moveFile(Springy::FsOps::Fuse &f){
     std::string movepath = std::string(cwd)+"/dir2/moveFile",
                 movedpath = std::string(cwd)+"/dir1/moveFile";
     unlink(movepath.c_str());
     unlink(movedpath.c_str());
 
     struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
 
     {
         FILE *fp = fopen(movepath.c_str(), "w+");
@@ -388,11 +388,11 @@ void test_moveFile(Springy::Fuse &f){
 
         int rval = 0;
         fi.flags = O_RDWR;
-        rval = f.op_open("/moveFile", &fi);
+        rval = f.open(meta, "/moveFile", &fi);
         ASSERT(rval == 0);
 
         libc->writecount = 0;
-        rval = f.op_write("/moveFile", "test", 4, 0, &fi);
+        rval = f.write(meta, "/moveFile", "test", 4, 0, &fi);
         ASSERT(rval == 4);
 
         struct stat st;
@@ -401,150 +401,96 @@ void test_moveFile(Springy::Fuse &f){
         ASSERT(st.st_size == 5);
         rval = stat(movepath.c_str(), &st);
         ASSERT(rval == -1);
-        rval = f.op_release("/moveFile", &fi);
+        rval = f.release(meta, "/moveFile", &fi);
         ASSERT(rval == 0);
     }
 }
 
-class TestFuse : public Springy::Fuse{
-    protected:
-        Springy::Settings s;
-
-    public:
-        TestFuse() : Springy::Fuse(){
-            this->init(&this->s, ::libc);
-        }
-        void test_findRelevantPaths(){
-            {
-                // simple root directory
-                this->config->directories.clear();
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/dir1"), boost::filesystem::path("/")));
-
-                std::map<boost::filesystem::path, boost::filesystem::path> result;
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where"));
-                ASSERT(result.size()==1);
-                ASSERT(result.begin()->second.string()=="/");
-                result = this->findRelevantPaths(boost::filesystem::path("/"));
-                ASSERT(result.size()==1);
-                ASSERT(result.begin()->second.string()=="/");
-            }
-
-            {
-                // two simple root directory
-                this->config->directories.clear();
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/dir1"), boost::filesystem::path("/")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/dir2"), boost::filesystem::path("/")));
-
-                std::map<boost::filesystem::path, boost::filesystem::path> result;
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where"));
-                ASSERT(result.size()==2);
-                ASSERT(result.begin()->first == "/dir1");
-                ASSERT((++result.begin())->first == "/dir2");
-
-                result = this->findRelevantPaths(boost::filesystem::path("/"));
-                ASSERT(result.size()==2);
-                ASSERT(result.begin()->first == "/dir1");
-                ASSERT((++result.begin())->first == "/dir2");
-            }
-
-            {
-                // complicated directory structure with root
-                this->config->directories.clear();
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/root1"), boost::filesystem::path("/")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/root2"), boost::filesystem::path("/")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/deep1"), boost::filesystem::path("/some/where/deep/in/the/directory/path")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/deep2"), boost::filesystem::path("/some/where/deep/in/the/directory/path")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/diff1"), boost::filesystem::path("/completely/different/path")));
-
-                std::map<boost::filesystem::path, boost::filesystem::path> result;
-                result = this->findRelevantPaths(boost::filesystem::path("/not/specified"));
-                ASSERT(result.size()==2);
-                ASSERT(result.begin()->first == "/root1");
-                ASSERT((++result.begin())->first == "/root2");
-
-                result = this->findRelevantPaths(boost::filesystem::path("/"));
-                ASSERT(result.size()==2);
-                ASSERT(result.begin()->first == "/root1");
-                ASSERT((++result.begin())->first == "/root2");
-
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where/deep/in/the/directory/path/and/even/deeper"));
-                ASSERT(result.size()==2);
-                ASSERT(result.begin()->first == "/deep1");
-                ASSERT((++result.begin())->first == "/deep2");
-
-                result = this->findRelevantPaths(boost::filesystem::path("/completely/different/path/sub/directory"));
-                ASSERT(result.size()==1);
-                ASSERT(result.begin()->first == "/diff1");
-            }
+void test_getVolumesByVirtualFileName(){
+    Springy::Volumes::VolumeRelativeFile result;
 
-            {
-                // complicated directory structure without root
-                this->config->directories.clear();
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/deep1"), boost::filesystem::path("/some/where/deep/in/the/directory/path")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/deep2"), boost::filesystem::path("/some/where/deep/in/the/directory/path")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/diff1"), boost::filesystem::path("/completely/different/path")));
+    {
+        // simple root directory
+        Springy::Volumes v(libc);
+        v.addVolume(Springy::Util::Uri("file:///dir1"), "/");
 
-                std::map<boost::filesystem::path, boost::filesystem::path> result;
-                result = this->findRelevantPaths(boost::filesystem::path("/not/specified"));
-                ASSERT(result.size()==0);
+        ASSERT(v.getVolumesByVirtualFileName("/some/where", result) == 0);
+        ASSERT(result.volumes.size()==1);
+        ASSERT(result.virtualMountPoint == "/");
+        ASSERT(result.volumeRelativeFileName == "/some/where");
+        ASSERT(v.getVolumesByVirtualFileName("/", result) == 0);
+        ASSERT(result.volumes.size()==1);
+    }
 
-                result = this->findRelevantPaths(boost::filesystem::path("/"));
-                ASSERT(result.size()==0);
+    {
+        // two simple root directories
+        Springy::Volumes v(libc);
+        v.addVolume(Springy::Util::Uri("file:///dir1"), "/");
+        v.addVolume(Springy::Util::Uri("file:///dir2"), "/");
 
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where/deep"));
-                ASSERT(result.size()==0);
+        ASSERT(v.getVolumesByVirtualFileName("/some/where", result) == 0);
+        ASSERT(result.volumes.size()==2);
+        ASSERT(v.getVolumesByVirtualFileName("/", result) == 0);
+        ASSERT(result.volumes.size()==2);
+    }
 
-                result = this->findRelevantPaths(boost::filesystem::path("/completely/different"));
-                ASSERT(result.size()==0);
+    {
+        // complicated directory structure with root
+        Springy::Volumes v(libc);
+        v.addVolume(Springy::Util::Uri("file:///root1"), "/");
+        v.addVolume(Springy::Util::Uri("file:///root2"), "/");
+        v.addVolume(Springy::Util::Uri("file:///deep1"), "/some/where/deep/in/the/directory/path");
+        v.addVolume(Springy::Util::Uri("file:///deep2"), "/some/where/deep/in/the/directory/path");
+        v.addVolume(Springy::Util::Uri("file:///diff1"), "/completely/different/path");
 
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where/deep/in/the/directory/path/and/even/deeper"));
-                ASSERT(result.size()==2);
-                ASSERT(result.begin()->first == "/deep1");
-                ASSERT((++result.begin())->first == "/deep2");
+        ASSERT(v.getVolumesByVirtualFileName("/not/specified", result) == 0);
+        ASSERT(result.volumes.size()==2);
+        ASSERT(result.virtualMountPoint == "/");
 
-                result = this->findRelevantPaths(boost::filesystem::path("/completely/different/path/sub/directory"));
-                ASSERT(result.size()==1);
-                ASSERT(result.begin()->first == "/diff1");
-            }
+        ASSERT(v.getVolumesByVirtualFileName("/some/where/deep/in/the/directory/path/and/even/deeper", result) == 0);
+        ASSERT(result.volumes.size()==2);
+        ASSERT(result.virtualMountPoint == "/some/where/deep/in/the/directory/path");
+        ASSERT(result.volumeRelativeFileName == "/and/even/deeper");
 
-            {
-                // cascading directory structure
-                this->config->directories.clear();
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/where1"), boost::filesystem::path("/some/where")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/where2"), boost::filesystem::path("/some/where/deep")));
-                this->config->directories.insert(std::make_pair(boost::filesystem::path("/where3"), boost::filesystem::path("/some/where/deep/in/the/directory/path")));
+        ASSERT(v.getVolumesByVirtualFileName("/completely/different/path/sub/directory", result) == 0);
+        ASSERT(result.volumes.size()==1);
+        ASSERT((*result.volumes.begin())->string() == "file:///diff1");
+    }
 
-                std::map<boost::filesystem::path, boost::filesystem::path> result;
-                result = this->findRelevantPaths(boost::filesystem::path("/not/specified"));
-                ASSERT(result.size()==0);
+    {
+        // complicated directory structure without root
+        Springy::Volumes v(libc);
+        v.addVolume(Springy::Util::Uri("file:///deep1"), "/some/where/deep/in/the/directory/path");
+        v.addVolume(Springy::Util::Uri("file:///diff1"), "/completely/different/path");
 
-                result = this->findRelevantPaths(boost::filesystem::path("/"));
-                ASSERT(result.size()==0);
+        ASSERT(v.getVolumesByVirtualFileName("/not/specified", result) == -ENOENT);
+        ASSERT(v.getVolumesByVirtualFileName("/", result) == -ENOENT);
+        ASSERT(v.getVolumesByVirtualFileName("/some/where/deep", result) == -ENOENT);
+        ASSERT(v.getVolumesByVirtualFileName("/completely/different", result) == -ENOENT);
 
-                result = this->findRelevantPaths(boost::filesystem::path("/some"));
-                ASSERT(result.size()==0);
+        ASSERT(v.getVolumesByVirtualFileName("/some/where/deep/in/the/directory/path/and/even/deeper", result) == 0);
+        ASSERT(result.volumes.size()==1);
+    }
 
-                result = this->findRelevantPaths(boost::filesystem::path("/completely/different"));
-                ASSERT(result.size()==0);
+    {
+        // cascading directory structure
+        Springy::Volumes v(libc);
+        v.addVolume(Springy::Util::Uri("file:///where1"), "/some/where");
+        v.addVolume(Springy::Util::Uri("file:///where2"), "/some/where/deep");
+        v.addVolume(Springy::Util::Uri("file:///where3"), "/some/where/deep/in/the/directory/path");
 
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where"));
-                ASSERT(result.size()==1);
-                ASSERT(result.begin()->first == "/where1");
+        ASSERT(v.getVolumesByVirtualFileName("/some", result) == -ENOENT);
 
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where/deep"));
-                ASSERT(result.size()==1);
-                ASSERT(result.begin()->first == "/where2");
+        ASSERT(v.getVolumesByVirtualFileName("/some/where", result) == 0);
+        ASSERT((*result.volumes.begin())->string() == "file:///where1");
 
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where/deep/in/the/directory"));
-                ASSERT(result.size()==1);
-                ASSERT(result.begin()->first == "/where2");
+        ASSERT(v.getVolumesByVirtualFileName("/some/where/deep/in/the/directory", result) == 0);
+        ASSERT((*result.volumes.begin())->string() == "file:///where2");
 
-                result = this->findRelevantPaths(boost::filesystem::path("/some/where/deep/in/the/directory/path/and/even/deeper"));
-                ASSERT(result.size()==1);
-                ASSERT(result.begin()->first == "/where3");
-            }
-        }
-};
+        ASSERT(v.getVolumesByVirtualFileName("/some/where/deep/in/the/directory/path/and/even/deeper", result) == 0);
+        ASSERT((*result.volumes.begin())->string() == "file:///where3");
+    }
+}
 
 void test_Uri(){
     {
@@ -617,12 +563,18 @@ int main(int argc, char **argv){
 
     libc->writecount=1;
 
-    Springy::Settings s;
-    s.directories.insert(std::make_pair(boost::filesystem::path(std::string(cwd)+"/dir1"), boost::filesystem::path("/")));  // virtualmount is /
-    s.directories.insert(std::make_pair(boost::filesystem::path(std::string(cwd)+"/dir2"), boost::filesystem::path("/")));  // virtualmount is /
+    meta.u = getuid();
+    meta.g = getgid();
+    meta.p = getpid();
+    meta.mask = umask(0);
+    umask(meta.mask);
+    meta.readonly = false;
+
+    Springy::Settings s(libc);
+    s.volumes.addVolume(Springy::Util::Uri(std::string("file://")+cwd+"/dir1"), "/");  // virtualmount is /
+    s.volumes.addVolume(Springy::Util::Uri(std::string("file://")+cwd+"/dir2"), "/");  // virtualmount is /
 
-    Springy::Fuse f;
-    f.init(&s, libc);
+    Springy::FsOps::Fuse f(&s, libc);
 
     test_getattr(f);
 
@@ -631,7 +583,8 @@ int main(int argc, char **argv){
     test_readlink(f);
     
     test_fops(f);
-    test_moveFile(f);
+    // moving the file on ENOSPC is commented out in FsOps::Fuse::write
+    //test_moveFile(f);
 
     test_truncate(f);
     test_access(f);
@@ -648,8 +601,7 @@ int main(int argc, char **argv){
 
     test_xattr(f);
 
-    TestFuse tf;
-    tf.test_findRelevantPaths();
+    test_getVolumesByVirtualFileName();
     
     test_Uri();
 
@@ -0,0 +1,763 @@
+#include "openfiles.hpp"
+#include "nodetable.hpp"
+#include "settings.hpp"
+#include "metrics.hpp"
+#include "flightrecorder.hpp"
+#include "trace.hpp"
+#include "fsops/fuse.hpp"
+#include "fsops/xattrcache.hpp"
+#include "volume/blockcache.hpp"
+#include "volume/file.hpp"
+#include "volume/ring.hpp"
+#include "volume/uring.hpp"
+#include "util/rangelock.hpp"
+#include "util/spacesaving.hpp"
+#include "util/uri.hpp"
+
+#include "libc/libc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/limits.h>
+#include <string.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#define ASSERT(condition) { if(!(condition)){ std::cerr << "ASSERT FAILED: " << #condition << " @ " << __FILE__ << " (" << __LINE__ << "):" << __FUNCTION__ << " | errno=" << strerror(errno) << std::endl; } assert((condition)); }
+
+char cwd[PATH_MAX];
+Springy::LibC::LibC *libc = new Springy::LibC::LibC();
+
+void sleepMs(int ms){
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void test_OpenFiles(){
+    boost::filesystem::path dir = boost::filesystem::path(cwd)/"units";
+    boost::filesystem::remove_all(dir);
+    boost::filesystem::create_directories(dir/"from");
+    boost::filesystem::create_directories(dir/"to");
+
+    Springy::Volume::File from(libc, Springy::Util::Uri("file://"+(dir/"from").string()));
+    Springy::Volume::File to(libc, Springy::Util::Uri("file://"+(dir/"to").string()));
+
+    {
+        // ids of removed handles are stale, even once the slot is reused
+        Springy::OpenFiles of;
+        int fd = from.open("/a", O_RDWR|O_CREAT, 0644);
+        ASSERT(fd != -1);
+        uint64_t id = of.add("/a", &from, fd, O_RDWR, 0644, "/a");
+        ASSERT(of.get(id) != NULL);
+        ASSERT(of.get(id)->backing()->fd == fd);
+        ASSERT(of.get(id)->virtualFile == "/a");
+        ASSERT(of.handles(&from, "/a").size() == 1);
+        ASSERT(of.state(&from, "/a") != NULL);
+
+        int rval = of.remove(id);
+        ASSERT(rval == 0);
+        ASSERT(of.get(id) == NULL);
+        ASSERT(of.acquire(id) == NULL);
+        rval = of.remove(id);
+        ASSERT(rval == -1 && errno == EBADF);
+        ASSERT(of.handles(&from, "/a").empty());
+        ASSERT(of.state(&from, "/a") == NULL);
+
+        fd = from.open("/a", O_RDWR);
+        uint64_t reused = of.add("/a", &from, fd, O_RDWR);
+        ASSERT(reused != id);
+        ASSERT(of.get(id) == NULL);
+        ASSERT(of.get(reused) != NULL);
+        rval = of.remove(reused);
+        ASSERT(rval == 0);
+
+        ASSERT(of.get(0) == NULL);
+    }
+
+    {
+        // the descriptor stays open while a request holds a reference
+        Springy::OpenFiles of;
+        int fd = from.open("/a", O_RDWR);
+        uint64_t id = of.add("/a", &from, fd, O_RDWR);
+        Springy::OpenFiles::Handle *h = of.acquire(id);
+        ASSERT(h != NULL);
+        int rval = of.remove(id);
+        ASSERT(rval == 0);
+        ASSERT(fcntl(fd, F_GETFD) != -1);
+        of.put(id);
+        ASSERT(fcntl(fd, F_GETFD) == -1);
+    }
+
+    {
+        // handles of one file share their state
+        Springy::OpenFiles of;
+        uint64_t id1 = of.add("/a", &from, from.open("/a", O_RDWR), O_RDWR);
+        uint64_t id2 = of.add("/a", &from, from.open("/a", O_RDONLY), O_RDONLY);
+        ASSERT(of.get(id1)->state == of.get(id2)->state);
+        ASSERT(of.get(id1)->state == of.state(&from, "/a").get());
+        ASSERT(of.handles(&from, "/a").size() == 2);
+        of.remove(id1);
+        of.remove(id2);
+    }
+
+    {
+        // relocate moves every handle or none
+        Springy::OpenFiles of;
+        int fd1 = from.open("/a", O_RDWR), fd2 = from.open("/a", O_RDONLY);
+        uint64_t id1 = of.add("/a", &from, fd1, O_RDWR);
+        uint64_t id2 = of.add("/a", &from, fd2, O_RDONLY);
+        Springy::OpenFiles::FileState *state = of.get(id1)->state;
+
+        int nfd1 = to.open("/a", O_RDWR|O_CREAT, 0644);
+        std::map<uint64_t, int> descriptors;
+        descriptors[id1] = nfd1;
+        int rval = of.relocate(&from, "/a", &to, descriptors);
+        ASSERT(rval == -1 && errno == EBUSY);
+        ASSERT(of.get(id1)->backing()->volume == &from);
+
+        int nfd2 = to.open("/a", O_RDONLY);
+        descriptors[id2] = nfd2;
+        std::shared_ptr<Springy::OpenFiles::Backing> old = of.get(id1)->backing();
+        rval = of.relocate(&from, "/a", &to, descriptors);
+        ASSERT(rval == 0);
+        ASSERT(of.get(id1)->backing()->volume == &to);
+        ASSERT(of.get(id1)->backing()->fd == nfd1);
+        ASSERT(of.get(id2)->backing()->fd == nfd2);
+        ASSERT(of.get(id1)->state == state);
+        ASSERT(of.handles(&from, "/a").empty());
+        ASSERT(of.handles(&to, "/a").size() == 2);
+        rval = of.relocate(&from, "/a", &to, descriptors);
+        ASSERT(rval == -1 && errno == EBADF);
+
+        // the replaced descriptor is closed with its last user
+        ASSERT(fcntl(fd1, F_GETFD) != -1);
+        ASSERT(fcntl(fd2, F_GETFD) == -1);
+        old.reset();
+        ASSERT(fcntl(fd1, F_GETFD) == -1);
+
+        of.remove(id1);
+        of.remove(id2);
+        ASSERT(fcntl(nfd1, F_GETFD) == -1);
+        ASSERT(fcntl(nfd2, F_GETFD) == -1);
+    }
+
+    boost::filesystem::remove_all(dir);
+}
+
+void test_RangeLock(){
+    {
+        // non overlapping ranges and shared ranges don't block
+        Springy::Util::RangeLock rl;
+        Springy::Util::RangeLock::Guard a(rl, 0, 10);
+        Springy::Util::RangeLock::Guard b(rl, 10, 10);
+        Springy::Util::RangeLock::Guard c(rl, 100, 10, false);
+        Springy::Util::RangeLock::Guard d(rl, 105, 10, false);
+    }
+
+    {
+        // overlapping ranges do
+        Springy::Util::RangeLock rl;
+        std::atomic<bool> granted(false);
+        std::unique_ptr<Springy::Util::RangeLock::Guard> held(new Springy::Util::RangeLock::Guard(rl, 0, 10));
+        std::thread th([&](){
+            Springy::Util::RangeLock::Guard g(rl, 9, 10, false);
+            granted = true;
+        });
+        sleepMs(50);
+        ASSERT(!granted);
+        held.reset();
+        th.join();
+        ASSERT(granted);
+    }
+
+    {
+        // a length of 0 locks up to the end of the file and beyond
+        Springy::Util::RangeLock rl;
+        std::atomic<bool> granted(false);
+        std::unique_ptr<Springy::Util::RangeLock::Guard> held(new Springy::Util::RangeLock::Guard(rl, 1000, 0));
+        Springy::Util::RangeLock::Guard before(rl, 0, 1000);
+        std::thread th([&](){
+            Springy::Util::RangeLock::Guard g(rl, (off_t)1 << 40, 1);
+            granted = true;
+        });
+        sleepMs(50);
+        ASSERT(!granted);
+        held.reset();
+        th.join();
+        ASSERT(granted);
+    }
+
+    {
+        // conflicting requests are granted in arrival order: a shared range
+        // arriving after a waiting exclusive one waits behind it
+        Springy::Util::RangeLock rl;
+        std::atomic<int> order(0);
+        int writer = 0, reader = 0;
+        std::unique_ptr<Springy::Util::RangeLock::Guard> held(new Springy::Util::RangeLock::Guard(rl, 0, 10, false));
+        std::thread tw([&](){
+            Springy::Util::RangeLock::Guard g(rl, 0, 0);
+            writer = ++order;
+        });
+        sleepMs(50);
+        std::thread tr([&](){
+            Springy::Util::RangeLock::Guard g(rl, 0, 10, false);
+            reader = ++order;
+        });
+        sleepMs(50);
+        ASSERT(order == 0);
+        held.reset();
+        tw.join();
+        tr.join();
+        ASSERT(writer == 1);
+        ASSERT(reader == 2);
+    }
+}
+
+void test_NodeTable(){
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+
+    Springy::Volume::File volume(libc, Springy::Util::Uri(std::string("file://")+cwd));
+
+    Springy::NodeTable::Location loc;
+    loc.volume = &volume;
+    loc.virtualMountPoint = "/";
+    loc.volumeRelativeFileName = "/dir";
+
+    {
+        // one node per (parent, name), forgotten with its last lookup
+        Springy::NodeTable nt;
+        uint64_t dir = nt.remember(Springy::NodeTable::rootId, "dir", st, loc);
+        ASSERT(dir != Springy::NodeTable::rootId);
+        uint64_t again = nt.remember(Springy::NodeTable::rootId, "dir", st, loc);
+        ASSERT(again == dir);
+        uint64_t file = nt.remember(dir, "file", st, loc);
+        ASSERT(nt.path(file) == "/dir/file");
+        ASSERT(nt.path(dir, "other") == "/dir/other");
+        ASSERT(nt.path(Springy::NodeTable::rootId) == "/");
+
+        uint64_t id;
+        ASSERT(nt.find("/dir/file", id) && id == file);
+        ASSERT(nt.find("/", id) && id == Springy::NodeTable::rootId);
+        ASSERT(!nt.find("/dir/none", id));
+
+        nt.forget(dir, 1);
+        ASSERT(nt.find("/dir", id) && id == dir);
+        nt.forget(dir, 1);
+        ASSERT(!nt.find("/dir", id));
+        bool thrown = false;
+        try{
+            nt.path(dir);
+        }catch(...){
+            thrown = true;
+        }
+        ASSERT(thrown);
+
+        // the root is never forgotten
+        nt.forget(Springy::NodeTable::rootId, 100);
+        ASSERT(nt.path(Springy::NodeTable::rootId) == "/");
+    }
+
+    {
+        // renames move the node and outdate the remembered locations below it
+        Springy::NodeTable nt;
+        uint64_t dir = nt.remember(Springy::NodeTable::rootId, "dir", st, loc);
+        uint64_t file = nt.remember(dir, "file", st, loc);
+        uint64_t target = nt.remember(Springy::NodeTable::rootId, "target", st, loc);
+        uint64_t other = nt.remember(Springy::NodeTable::rootId, "other", st, loc);
+        uint64_t below = nt.remember(other, "file", st, loc);
+
+        Springy::NodeTable::Location l;
+        ASSERT(nt.location(file, 0, l));
+        ASSERT(l.volumeRelativeFileName == "/dir");
+        ASSERT(!nt.location(file, 1, l));
+
+        nt.renamed(Springy::NodeTable::rootId, "dir", Springy::NodeTable::rootId, "target");
+        ASSERT(nt.path(file) == "/target/file");
+        uint64_t id;
+        ASSERT(nt.find("/target", id) && id == dir);
+        ASSERT(!nt.find("/dir", id));
+        ASSERT(!nt.location(file, 0, l));
+        ASSERT(!nt.location(dir, 0, l));
+        ASSERT(nt.renames() == 1);
+
+        // the replaced node is gone, anything else stays
+        ASSERT(!nt.location(target, 0, l));
+        ASSERT(nt.location(other, 0, l));
+        ASSERT(nt.location(below, 0, l));
+
+        loc.renames = nt.renames();
+        nt.relocate(file, loc);
+        ASSERT(nt.location(file, 0, l));
+
+        // unlinked nodes lose name and location but stay until forgotten
+        nt.unlinked(dir, "file");
+        ASSERT(!nt.find("/target/file", id));
+        ASSERT(!nt.location(file, 0, l));
+        ASSERT(nt.path(file) == "/target/file");
+    }
+}
+
+void test_SpaceSaving(){
+    {
+        // exact as long as there are no more keys than capacity
+        Springy::Util::SpaceSaving<std::string> ss(4);
+        ss.add("a", 5);
+        ss.add("b", 3);
+        ss.add("c");
+        ss.add("b", 3);
+        std::vector<Springy::Util::SpaceSaving<std::string>::Entry> top = ss.top(2);
+        ASSERT(top.size() == 2);
+        ASSERT(top[0].key == "b" && top[0].count == 6 && top[0].error == 0);
+        ASSERT(top[1].key == "a" && top[1].count == 5);
+        ASSERT(ss.weight() == 12);
+        ASSERT(ss.top(10).size() == 3);
+    }
+
+    {
+        // a new key replaces the smallest one and inherits its count as error
+        Springy::Util::SpaceSaving<std::string> ss(2);
+        ss.add("a", 10);
+        ss.add("b", 2);
+        ss.add("c", 1);
+        std::vector<Springy::Util::SpaceSaving<std::string>::Entry> top = ss.top(2);
+        ASSERT(top[0].key == "a" && top[0].count == 10);
+        ASSERT(top[1].key == "c" && top[1].count == 3 && top[1].error == 2);
+    }
+
+    {
+        // heavy hitters survive a stream of one-off keys
+        Springy::Util::SpaceSaving<int> ss(16);
+        for(int i=0;i<10000;i++){
+            ss.add(i % 2 == 0 ? -1 : i);
+            if(i % 10 == 0){
+                ss.add(-2);
+            }
+        }
+        std::vector<Springy::Util::SpaceSaving<int>::Entry> top = ss.top(2);
+        ASSERT(top[0].key == -1 && top[0].count - top[0].error <= 5000 && top[0].count >= 5000);
+        ASSERT(top[1].key == -2 && top[1].count >= 1000);
+    }
+}
+
+void test_XattrCache(){
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    st.st_dev = 1;
+    st.st_ino = 2;
+    st.st_ctim.tv_sec = 100;
+    Springy::Volume::File file(libc, Springy::Util::Uri(std::string("file://")+cwd));
+    Springy::Volume::IVolume *volume = &file;
+
+    std::string value;
+    int err;
+
+    {
+        // only entries bound to an inode are filled, including errors
+        Springy::FsOps::XattrCache c(1024, 100);
+        c.put("/f", "user.a", "x", 0);
+        ASSERT(!c.get("/f", "user.a", value, err));
+
+        c.validate("/f", Springy::FsOps::XattrCache::identity(volume, st));
+        c.put("/f", "user.a", "x", 0);
+        c.put("/f", "security.capability", "", ENODATA);
+        ASSERT(c.get("/f", "user.a", value, err) && value == "x" && err == 0);
+        ASSERT(c.get("/f", "security.capability", value, err) && err == ENODATA);
+        ASSERT(!c.get("/f", "user.b", value, err));
+        ASSERT(!c.getList("/f", value, err));
+        c.putList("/f", std::string("user.a\0", 7), 0);
+        ASSERT(c.getList("/f", value, err) && value == std::string("user.a\0", 7));
+
+        c.invalidate("/f");
+        ASSERT(!c.get("/f", "user.a", value, err));
+    }
+
+    {
+        // answered without the volume for ttl milliseconds, kept as long as the inode's ctime matches
+        Springy::FsOps::XattrCache c(1024, 50);
+        c.validate("/f", Springy::FsOps::XattrCache::identity(volume, st));
+        c.put("/f", "user.a", "x", 0);
+        sleepMs(100);
+        ASSERT(!c.get("/f", "user.a", value, err));
+
+        c.validate("/f", Springy::FsOps::XattrCache::identity(volume, st));
+        ASSERT(c.get("/f", "user.a", value, err) && value == "x");
+
+        st.st_ctim.tv_nsec = 1;
+        c.validate("/f", Springy::FsOps::XattrCache::identity(volume, st));
+        ASSERT(!c.get("/f", "user.a", value, err));
+
+        c.put("/f", "user.a", "y", 0);
+        st.st_ino = 3;
+        c.validate("/f", Springy::FsOps::XattrCache::identity(volume, st));
+        ASSERT(!c.get("/f", "user.a", value, err));
+    }
+}
+
+// reports no free space on the volumes below full, so Fuse::place() moves files away from them
+class FullVolumeLibC : public Springy::LibC::LibC{
+    public:
+        std::string full;
+        virtual int statvfs(int LINE, const char *path, struct ::statvfs *buf){
+            int res = Springy::LibC::LibC::statvfs(LINE, path, buf);
+            if(res == 0 && !this->full.empty() && std::string(path).compare(0, this->full.size(), this->full) == 0){
+                buf->f_bavail = 0;
+            }
+            return res;
+        }
+};
+
+class PlacingFuse : public Springy::FsOps::Fuse{
+    public:
+        PlacingFuse(Springy::Settings *config, Springy::LibC::ILibC *libc) : Springy::FsOps::Fuse(config, libc){}
+        using Springy::FsOps::Fuse::place;
+};
+
+void test_WriteDuringRelocation(){
+    boost::filesystem::path dir = boost::filesystem::path(cwd)/"units";
+    boost::filesystem::remove_all(dir);
+    boost::filesystem::create_directories(dir/"from");
+    boost::filesystem::create_directories(dir/"to");
+    { boost::filesystem::ofstream((dir/"from"/"f")); }
+
+    FullVolumeLibC full;
+    Springy::Settings s(&full);
+    s.volumes.addVolume(Springy::Util::Uri("file://"+(dir/"from").string()), "/");
+    s.volumes.addVolume(Springy::Util::Uri("file://"+(dir/"to").string()), "/");
+    PlacingFuse f(&s, &full);
+
+    Springy::FsOps::Abstract::MetaRequest meta;
+    meta.u = getuid();
+    meta.g = getgid();
+    meta.p = getpid();
+    meta.mask = 022;
+    meta.readonly = false;
+
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.flags = O_RDWR;
+    int rval = f.open(meta, "/f", &fi);
+    ASSERT(rval == 0);
+    Springy::OpenFiles::Handle *h = s.openFiles.get(fi.fh);
+    ASSERT(h != NULL);
+
+    {
+        // a write waiting for the whole file range of a relocating fallocate
+        // has to go to the new file, not the unlinked old one
+        std::atomic<int> written(0);
+        std::unique_ptr<Springy::Util::RangeLock::Guard> held(new Springy::Util::RangeLock::Guard(h->state->ranges, 0, 0));
+        std::thread th([&](){
+            written = f.write(meta, "/f", "test", 4, 0, &fi);
+        });
+        sleepMs(50);
+        ASSERT(written == 0);
+
+        full.full = (dir/"from").string();
+        f.place("/f", h, 4096);
+        full.full.clear();
+        ASSERT(!boost::filesystem::exists(dir/"from"/"f"));
+        ASSERT(boost::filesystem::exists(dir/"to"/"f"));
+
+        held.reset();
+        th.join();
+        ASSERT(written == 4);
+        ASSERT(boost::filesystem::file_size(dir/"to"/"f") == 4);
+    }
+
+    rval = f.release(meta, "/f", &fi);
+    ASSERT(rval == 0);
+
+    boost::filesystem::remove_all(dir);
+}
+
+void test_ChangeNotifier(){
+    boost::filesystem::path dir = boost::filesystem::path(cwd)/"units";
+    boost::filesystem::remove_all(dir);
+    boost::filesystem::create_directories(dir);
+
+    Springy::Settings s(libc);
+    s.volumes.addVolume(Springy::Util::Uri("file://"+dir.string()), "/");
+    Springy::Volume::File volume(libc, Springy::Util::Uri("file://"+dir.string()));
+    Springy::FsOps::Fuse f(&s, libc);
+
+    Springy::FsOps::Abstract::MetaRequest meta;
+    meta.u = getuid();
+    meta.g = getgid();
+    meta.p = getpid();
+    meta.mask = 022;
+    meta.readonly = false;
+
+    std::mutex lock;
+    std::vector<boost::filesystem::path> notified;
+    s.changes.subscribe(&notified, [&](const boost::filesystem::path &path, Springy::ChangeNotifier::Kind kind){
+        std::lock_guard<std::mutex> l(lock);
+        notified.push_back(path);
+    });
+    s.changes.start();
+    s.changes.watch(&volume, "/", "/");
+
+    // springy's own mutations went through the mount, the kernel knows them
+    int rval = f.mkdir(meta, "/d", 0755);
+    ASSERT(rval == 0);
+    rval = f.rename(meta, "/d", "/e");
+    ASSERT(rval == 0);
+    rval = f.chmod(meta, "/e", 0700);
+    ASSERT(rval == 0);
+    rval = f.rmdir(meta, "/e");
+    ASSERT(rval == 0);
+
+    // everybody else's are reported
+    boost::filesystem::create_directory(dir/"other");
+    sleepMs(200);
+
+    s.changes.stop();
+    s.changes.unsubscribe(&notified);
+    ASSERT(notified.size() == 1);
+    ASSERT(notified[0] == "/other");
+
+    boost::filesystem::remove_all(dir);
+}
+
+void test_Metrics(){
+    Springy::Volume::File a(libc, Springy::Util::Uri(std::string("file://")+cwd+"/a"));
+    Springy::Volume::File b(libc, Springy::Util::Uri(std::string("file://")+cwd+"/b"));
+    Springy::Volume::File again(libc, Springy::Util::Uri(std::string("file://")+cwd+"/a"));
+
+    // volumes are counted by name, the same name gets the same number
+    uint32_t ids[3];
+    Springy::Volume::File *volumes[3] = {&a, &b, &again};
+    for(int i=0;i<3;i++){
+        Springy::Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+        Springy::Trace::tagVolume(volumes[i]);
+        ids[i] = volumes[i]->traceId;
+    }
+    ASSERT(ids[0] != 0 && ids[1] != 0);
+    ASSERT(ids[0] != ids[1]);
+    ASSERT(ids[2] == ids[0]);
+    ASSERT(Springy::Trace::volumeName(ids[1]) == b.string());
+    ASSERT(Springy::Trace::volumeName(0).empty());
+
+    const char *method = "virtual ssize_t Springy::Volume::File::read(const boost::filesystem::path&, int, void*, size_t, off_t)";
+    Springy::Metrics::record(method, ids[0], 1000, 0);
+    Springy::Metrics::record(method, ids[2], 3000, -EIO);
+    Springy::Metrics::record("void test_Metrics()", ids[0], 1000, 0);
+
+    Springy::Metrics::StatsMap m = Springy::Metrics::snapshot();
+    Springy::Metrics::StatsMap::iterator it = m.find(Springy::Metrics::Key("Volume::File::read", a.string()));
+    ASSERT(it != m.end());
+    ASSERT(it->second.count == 2);
+    ASSERT(it->second.sumNs == 4000);
+    ASSERT(it->second.errors[EIO] == 1);
+    ASSERT(m.find(Springy::Metrics::Key("test_Metrics", a.string())) == m.end());
+}
+
+static int traced(int result){
+    Springy::Trace t(__FILE__, __PRETTY_FUNCTION__, __LINE__);
+    errno = EAGAIN; // left over by a call that was retried
+    return t.result(result);
+}
+
+void test_FlightRecorder(){
+    boost::filesystem::path file = boost::filesystem::path(cwd)/"units.flight";
+    boost::filesystem::remove(file);
+
+    bool opened = Springy::FlightRecorder::open(file.string(), 1024*1024);
+    ASSERT(opened);
+    traced(0);
+    traced(-ENOENT);
+    Springy::FlightRecorder::close();
+
+    // the frame's result is recorded, not whatever errno it ended with
+    std::vector<int> errs;
+    boost::filesystem::ifstream in(file, std::ios::binary);
+    Springy::FlightRecorder::Header h;
+    in.read((char*)&h, sizeof(h));
+    for(uint64_t i=0;i<h.head && i<h.capacity;i++){
+        Springy::FlightRecorder::Record r;
+        in.seekg(h.recordsOffset + i*sizeof(r));
+        in.read((char*)&r, sizeof(r));
+        errs.push_back(r.err);
+    }
+    ASSERT(errs.size() == 2);
+    ASSERT(errs[0] == 0);
+    ASSERT(errs[1] == ENOENT);
+
+    boost::filesystem::remove(file);
+}
+
+class FailingEnterLibC : public Springy::LibC::LibC{
+    public:
+        virtual int io_uring_enter(int LINE, int fd, unsigned to_submit, unsigned min_complete, unsigned flags){
+            errno = EBADF;
+            return -1;
+        }
+};
+
+void test_Ring(){
+    boost::filesystem::path dir = boost::filesystem::path(cwd)/"units";
+    boost::filesystem::remove_all(dir);
+    boost::filesystem::create_directories(dir);
+
+    // rings are per thread and bound to the libc of their first use
+    std::thread([&](){
+        Springy::Volume::Ring *ring = Springy::Volume::Ring::current(libc);
+        if(ring == NULL){
+            std::cerr << "io_uring not available, Ring tests skipped" << std::endl;
+            return;
+        }
+
+        // a batch of requests is one submit, a full queue takes no more
+        struct io_uring_sqe *sqe;
+        for(unsigned i=0;i<Springy::Volume::Ring::entries;i++){
+            sqe = ring->prepare();  // zeroed, IORING_OP_NOP
+            ASSERT(sqe != NULL);
+        }
+        sqe = ring->prepare();
+        ASSERT(sqe == NULL);
+        int rval = ring->submit();
+        ASSERT(rval == (int)Springy::Volume::Ring::entries);
+        ASSERT(ring->result(Springy::Volume::Ring::entries-1) == 0);
+
+        // a hot descriptor is used through its fixed file slot
+        int fd = ::open((dir/"a").c_str(), O_CREAT|O_RDWR, 0644);
+        sqe = ring->prepare();
+        sqe->opcode = IORING_OP_WRITE;
+        ring->file(sqe, fd, true);
+        sqe->addr = (uint64_t)(uintptr_t)"hello";
+        sqe->len = 5;
+        rval = ring->run();
+        ASSERT(rval == 5);
+
+        char buf[8];
+        memset(buf, 0, sizeof(buf));
+        sqe = ring->prepare();
+        sqe->opcode = IORING_OP_READ;
+        ring->file(sqe, fd, true);
+        sqe->addr = (uint64_t)(uintptr_t)buf;
+        sqe->len = sizeof(buf);
+        rval = ring->run();
+        ASSERT(rval == 5);
+        ASSERT(strcmp(buf, "hello") == 0);
+
+        // the number of a closed descriptor must not lead to its old slot
+        Springy::Volume::Ring::forget(fd);
+        ::close(fd);
+        int other = ::open((dir/"b").c_str(), O_CREAT|O_RDWR, 0644);
+        ASSERT(other == fd);
+        sqe = ring->prepare();
+        sqe->opcode = IORING_OP_WRITE;
+        ring->file(sqe, other, true);
+        sqe->addr = (uint64_t)(uintptr_t)"xy";
+        sqe->len = 2;
+        rval = ring->run();
+        ASSERT(rval == 2);
+        Springy::Volume::Ring::forget(other);
+        ::close(other);
+        ASSERT(boost::filesystem::file_size(dir/"a") == 5);
+        ASSERT(boost::filesystem::file_size(dir/"b") == 2);
+
+        // more entries than the ring holds are stat'ed in several batches
+        boost::filesystem::create_directories(dir/"list");
+        for(unsigned i=0;i<Springy::Volume::Ring::entries*2+1;i++){
+            boost::filesystem::ofstream f(dir/"list"/std::to_string(i));
+            f << std::string(i, 'x');
+        }
+        Springy::Volume::Uring uring(libc, Springy::Util::Uri("uring://"+(dir/"list").string()));
+        std::unordered_map<std::string, struct stat> entries;
+        rval = uring.readdir("/", entries);
+        ASSERT(rval == 0);
+        for(unsigned i=0;i<Springy::Volume::Ring::entries*2+1;i++){
+            std::unordered_map<std::string, struct stat>::iterator it = entries.find(std::to_string(i));
+            ASSERT(it != entries.end());
+            ASSERT(S_ISREG(it->second.st_mode) && it->second.st_size == (off_t)i);
+        }
+    }).join();
+
+    // a ring io_uring_enter fails on is dropped, the request is done without it
+    std::thread([&](){
+        FailingEnterLibC failing;
+        Springy::Volume::Uring uring(&failing, Springy::Util::Uri("uring://"+dir.string()));
+        if(Springy::Volume::Ring::current(&failing) == NULL){
+            return;
+        }
+        struct stat st;
+        int rval = uring.getattr("/a", &st);
+        ASSERT(rval == 0);
+        ASSERT(st.st_size == 5);
+        ASSERT(Springy::Volume::Ring::current(&failing) == NULL);
+    }).join();
+
+    boost::filesystem::remove_all(dir);
+}
+
+void test_BlockCache(){
+    Springy::Volume::BlockCache c(1024*1024, 4096);
+    Springy::Volume::BlockCache::Key k = {&c, 1, 2, 0};
+    Springy::Volume::BlockCache::Validator v = {100, 8192, 0};
+    char buf[16];
+
+    ASSERT(c.read(k, v, buf, 0, sizeof(buf)) == -1);
+    c.put(k, v, std::string(4096, 'a'));
+    ASSERT(c.read(k, v, buf, 4090, sizeof(buf)) == 6);
+    ASSERT(buf[0] == 'a');
+
+    {
+        // other blocks of the file are not affected
+        Springy::Volume::BlockCache::Key k2 = k;
+        k2.block = 1;
+        ASSERT(c.read(k2, v, buf, 0, sizeof(buf)) == -1);
+    }
+
+    {
+        // a new write generation (truncate, local write) drops the block
+        Springy::Volume::BlockCache::Validator v2 = v;
+        v2.generation++;
+        ASSERT(c.read(k, v2, buf, 0, sizeof(buf)) == -1);
+        ASSERT(c.read(k, v, buf, 0, sizeof(buf)) == -1);
+    }
+
+    {
+        // so does a different mtime or size
+        c.put(k, v, std::string(4096, 'a'));
+        Springy::Volume::BlockCache::Validator v2 = v;
+        v2.size = 0;
+        ASSERT(c.read(k, v2, buf, 0, sizeof(buf)) == -1);
+        c.put(k, v, std::string(4096, 'a'));
+        v2 = v;
+        v2.mtime++;
+        ASSERT(c.read(k, v2, buf, 0, sizeof(buf)) == -1);
+    }
+
+    {
+        c.put(k, v, std::string(4096, 'a'));
+        c.clear();
+        ASSERT(c.read(k, v, buf, 0, sizeof(buf)) == -1);
+
+        c.put(k, v, std::string(4096, 'a'));
+        c.setCapacity(0);
+        ASSERT(c.read(k, v, buf, 0, sizeof(buf)) == -1);
+    }
+}
+
+int main(int argc, char **argv){
+    getcwd(cwd, sizeof(cwd));
+
+    test_OpenFiles();
+    test_WriteDuringRelocation();
+    test_ChangeNotifier();
+    test_Metrics();
+    test_FlightRecorder();
+    test_Ring();
+    test_RangeLock();
+    test_NodeTable();
+    test_SpaceSaving();
+    test_XattrCache();
+    test_BlockCache();
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * flightdump - decodes a springy flight recorder file (--flight-recorder)
+ *
+ * usage: flightdump [--chrome] FILE
+ *   without options one line per record is printed, oldest first
+ *   --chrome writes chrome trace event json (chrome://tracing, perfetto)
+ *
+ * the file may come from a process that crashed or is still running,
+ * slots that were being written at that moment are skipped.
+ */
+#include "flightrecorder.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Springy::FlightRecorder;
+
+static const FlightRecorder::Header *header;
+static size_t fileSize;
+
+static std::string str(uint32_t offset){
+    if(offset == 0 || offset + sizeof(uint32_t) > header->stringsSize){
+        return std::string();
+    }
+    const char *p = (const char*)header + header->stringsOffset + offset;
+    uint32_t len;
+    memcpy(&len, p, sizeof(len));
+    if(offset + sizeof(uint32_t) + len > header->stringsSize){
+        return std::string();
+    }
+    return std::string(p + sizeof(len), len);
+}
+
+static std::string json(const std::string &s){
+    std::string out;
+    for(size_t i=0;i<s.length();i++){
+        char c = s[i];
+        if(c == '"' || c == '\\'){
+            out += '\\';
+            out += c;
+        }
+        else if((unsigned char)c < 0x20){
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        else{
+            out += c;
+        }
+    }
+    return out;
+}
+
+static bool bySeq(const FlightRecorder::Record &a, const FlightRecorder::Record &b){
+    return a.seq < b.seq;
+}
+
+int main(int argc, char **argv){
+    bool chrome = false;
+    const char *file = NULL;
+    for(int i=1;i<argc;i++){
+        if(strcmp(argv[i], "--chrome") == 0){
+            chrome = true;
+        }
+        else{
+            file = argv[i];
+        }
+    }
+    if(file == NULL){
+        std::cerr << "usage: " << argv[0] << " [--chrome] FILE" << std::endl;
+        return 1;
+    }
+
+    int fd = open(file, O_RDONLY);
+    struct stat st;
+    if(fd == -1 || fstat(fd, &st) == -1){
+        std::cerr << file << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    fileSize = st.st_size;
+    if(fileSize < sizeof(FlightRecorder::Header)){
+        std::cerr << file << ": too small" << std::endl;
+        return 1;
+    }
+    void *p = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED){
+        std::cerr << file << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    header = (const FlightRecorder::Header*)p;
+    if(memcmp(header->magic, "SPRINGFR", 8) != 0 || header->version != FlightRecorder::version ||
+       header->recordSize != sizeof(FlightRecorder::Record) ||
+       header->recordsOffset + header->capacity * header->recordSize > fileSize ||
+       header->stringsOffset + header->stringsSize > header->recordsOffset){
+        std::cerr << file << ": not a flight recorder file of version " << FlightRecorder::version << std::endl;
+        return 1;
+    }
+
+    // copy first, the writer may still be running
+    const FlightRecorder::Record *slots = (const FlightRecorder::Record*)((const char*)p + header->recordsOffset);
+    std::vector<FlightRecorder::Record> records;
+    records.reserve(header->capacity);
+    for(uint64_t i=0;i<header->capacity;i++){
+        FlightRecorder::Record r = slots[i];
+        if(r.seq == 0 || (r.seq - 1) % header->capacity != i || r.seq != __atomic_load_n(&slots[i].seq, __ATOMIC_ACQUIRE)){
+            continue;
+        }
+        records.push_back(r);
+    }
+    std::sort(records.begin(), records.end(), bySeq);
+
+    if(chrome){
+        std::cout << "{\"traceEvents\":[" << std::endl;
+        for(size_t i=0;i<records.size();i++){
+            const FlightRecorder::Record &r = records[i];
+            std::string site = str(r.site);
+            std::string method = site.substr(site.find('\t') + 1);
+            std::string source = site.substr(0, site.find('\t'));
+
+            std::cout << (i ? ",\n" : "") << "{\"name\":\"" << json(method) << "\",\"cat\":\"" << json(str(r.volume)) << "\""
+                      << ",\"ph\":\"X\",\"pid\":" << header->pid << ",\"tid\":" << r.tid
+                      << ",\"ts\":" << (r.startNs / 1000) << "." << (r.startNs % 1000) / 100
+                      << ",\"dur\":" << (r.durationNs / 1000) << "." << (r.durationNs % 1000) / 100
+                      << ",\"args\":{\"file\":\"" << json(source) << "\",\"line\":" << r.line << ",\"errno\":" << r.err
+                      << ",\"seq\":" << r.seq << "}}";
+        }
+        std::cout << std::endl << "]}" << std::endl;
+        return 0;
+    }
+
+    std::cout << "# pid " << header->pid << ", " << records.size() << " of " << header->head
+              << " records, " << header->capacity << " slots" << std::endl;
+    for(size_t i=0;i<records.size();i++){
+        const FlightRecorder::Record &r = records[i];
+        time_t t = r.startNs / 1000000000ULL;
+        struct tm tm;
+        localtime_r(&t, &tm);
+        char buffer[32];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+
+        std::string site = str(r.site);
+        std::replace(site.begin(), site.end(), '\t', ':');
+
+        printf("%s.%06llu %6u %*s%s:%d %lluus", buffer, (unsigned long long)(r.startNs / 1000) % 1000000, r.tid,
+               r.depth * 2, "", site.c_str(), r.line, (unsigned long long)r.durationNs / 1000);
+        if(r.volume){
+            printf(" [%s]", str(r.volume).c_str());
+        }
+        if(r.err){
+            printf(" (%d|%s)", r.err, strerror(r.err));
+        }
+        printf("\n");
+    }
+
+    return 0;
+}